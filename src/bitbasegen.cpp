@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "./engine/bitbase-gen.hpp"
+
+/*
+ * Endgame bitbase generator
+ *
+ * Solves the given endings, and all smaller endings they turn into, by
+ * retrograde analysis on all threads (see bitbase-gen.hpp) and writes every
+ * solved ending to <output>/<name>.pbb, which Bitbase (bitbase.hpp) maps
+ * and probes in place.
+ */
+
+struct BitbasegenConfig {
+  std::vector<std::string> endings;  // Like "KRvK" or "KPvKP"
+  std::string output = ".";
+  int concurrency = 1;
+};
+
+void printUsage() {
+  std::cout << "Usage: pawnstar-bitbasegen [options] ENDING...\n"
+            << "  ENDING            pieces of both sides like KQvKR, up to "
+            << MAX_BITBASE_PIECES << " pieces\n"
+            << "  --output DIR      directory of the .pbb files (default .)\n"
+            << "  --concurrency N   worker threads (default 1)\n";
+}
+
+bool parseArgs(int argc, char* argv[], BitbasegenConfig& config) {
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg.rfind("--", 0) != 0) {
+      config.endings.push_back(arg);
+      continue;
+    }
+
+    if (i + 1 >= argc) return false;
+    std::string value = argv[++i];
+
+    if (arg == "--output") {
+      config.output = value;
+    } else if (arg == "--concurrency") {
+      config.concurrency = std::max(1, std::stoi(value));
+    } else {
+      return false;
+    }
+  }
+
+  return !config.endings.empty();
+}
+
+int main(int argc, char* argv[]) {
+  BitbasegenConfig config;
+
+  try {
+    if (!parseArgs(argc, argv, config)) {
+      printUsage();
+      return 1;
+    }
+  } catch (const std::exception&) {
+    printUsage();
+    return 1;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+
+  BitbaseGenerator generator(config.concurrency);
+  for (const auto& ending : config.endings) {
+    std::cout << "Solving " << ending << " on " << config.concurrency
+              << " thread(s)" << std::endl;
+    if (!generator.generate(ending)) {
+      std::cerr << "Invalid ending " << ending << std::endl;
+      return 1;
+    }
+  }
+
+  for (const auto& [name, results] : generator.getResults()) {
+    EndgameMaterial material;
+    EndgameMaterial::parse(name, material);
+
+    uint64_t counts[4] = {};
+    for (uint64_t index = 0; index < material.entries(); index++) {
+      counts[static_cast<int>(getWdl(results.data(), index))]++;
+    }
+
+    std::string path = config.output + "/" + name + ".pbb";
+    if (!writeBitbase(path, material, results.data())) {
+      std::cerr << "Failed to write " << path << std::endl;
+      return 1;
+    }
+
+    std::cout << name << ": " << counts[static_cast<int>(Wdl::WIN)]
+              << " wins, " << counts[static_cast<int>(Wdl::DRAW)]
+              << " draws, " << counts[static_cast<int>(Wdl::LOSS)]
+              << " losses for the side to move" << std::endl;
+  }
+
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  std::cout << "Wrote " << generator.getResults().size() << " bitbase(s) to "
+            << config.output << " in " << seconds << "s" << std::endl;
+
+  return 0;
+}
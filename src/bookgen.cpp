@@ -0,0 +1,323 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "./engine/book.hpp"
+#include "./engine/mapped-file.hpp"
+#include "./engine/pgn-reader.hpp"
+
+/*
+ * Polyglot opening book builder
+ *
+ * The PGN files are memory mapped and parsed in place by one thread per
+ * core (see pgn-reader.hpp). Each thread counts the wins,
+ * draws and losses of every (position, move) pair in its own maps, split
+ * into shards by the top bits of the position key. The shards are merged
+ * and sorted in parallel afterwards, and since a shard holds one range of
+ * keys the sorted shards only have to be written one after the other.
+ */
+
+struct BookgenConfig {
+  std::vector<std::string> inputs;
+  std::string output = "book.bin";
+  int concurrency = 1;
+  int maxPly = 24;    // Moves after this ply are not added
+  int minGames = 3;   // Moves played in fewer games are dropped
+};
+
+// Number of shards is 2^SHARD_BITS
+constexpr int SHARD_BITS = 6;
+constexpr int SHARD_COUNT = 1 << SHARD_BITS;
+
+struct BookKey {
+  uint64_t key;
+  uint16_t move;
+
+  bool operator==(const BookKey& other) const {
+    return key == other.key && move == other.move;
+  }
+};
+
+struct BookKeyHash {
+  size_t operator()(const BookKey& key) const {
+    // Zobrist keys are already random
+    return static_cast<size_t>(key.key ^ (uint64_t(key.move) << 48));
+  }
+};
+
+// Results from the point of view of the side that played the move
+struct MoveStats {
+  uint32_t wins = 0;
+  uint32_t draws = 0;
+  uint32_t losses = 0;
+
+  uint32_t games() const { return wins + draws + losses; }
+};
+
+using ShardMap = std::unordered_map<BookKey, MoveStats, BookKeyHash>;
+
+int shardOf(uint64_t key) { return static_cast<int>(key >> (64 - SHARD_BITS)); }
+
+class BookVisitor : public pgn::Visitor {
+ public:
+  BookVisitor(std::vector<ShardMap>& shards, int maxPly)
+      : shards(shards), maxPly(maxPly) {}
+
+  void startPgn() override {
+    board.setFen(constants::STARTPOS);
+    ply = 0;
+    valid = true;
+    whiteScore = -1;
+  }
+
+  void header(std::string_view key, std::string_view value) override {
+    if (key == "FEN") {
+      board.setFen(value);
+    } else if (key == "Result") {
+      if (value == "1-0") whiteScore = 2;
+      if (value == "1/2-1/2") whiteScore = 1;
+      if (value == "0-1") whiteScore = 0;
+    }
+  }
+
+  void startMoves() override {
+    // Unfinished games say nothing about the moves
+    if (whiteScore < 0) skipPgn(true);
+  }
+
+  void move(std::string_view san, std::string_view) override {
+    if (!valid || ply >= maxPly || san.empty()) return;
+
+    Move move;
+    try {
+      move = uci::parseSan(board, san, moves);
+    } catch (const std::exception&) {
+      valid = false;
+      return;
+    }
+    if (move == Move::NO_MOVE) {
+      valid = false;
+      return;
+    }
+
+    uint64_t key = board.polyglotKey();
+    int score = board.sideToMove() == Color::WHITE ? whiteScore : 2 - whiteScore;
+
+    MoveStats& stats = shards[shardOf(key)][{key, encodePolyglotMove(move)}];
+    if (score == 2) stats.wins++;
+    if (score == 1) stats.draws++;
+    if (score == 0) stats.losses++;
+
+    // Not the exact variant, the Polyglot key needs the en passant square
+    // after every double push
+    board.makeMove(move);
+    ply++;
+  }
+
+  void endPgn() override {
+    if (whiteScore >= 0) games++;
+  }
+
+  uint64_t games = 0;
+
+ private:
+  std::vector<ShardMap>& shards;
+  int maxPly;
+
+  Board board;
+  Movelist moves;
+  int ply = 0;
+  bool valid = true;
+  int whiteScore = -1;  // 2 win, 1 draw, 0 loss for white, -1 unknown
+};
+
+// Entries of one shard, sorted by key and best move first. The weights of
+// a position are 2 * wins + draws, scaled down when they do not fit.
+std::vector<PolyglotEntry> buildShard(std::vector<std::vector<ShardMap>>& maps,
+                                      int shard, int minGames) {
+  ShardMap merged = std::move(maps[0][shard]);
+  for (size_t t = 1; t < maps.size(); t++) {
+    for (const auto& [key, stats] : maps[t][shard]) {
+      MoveStats& total = merged[key];
+      total.wins += stats.wins;
+      total.draws += stats.draws;
+      total.losses += stats.losses;
+    }
+    ShardMap().swap(maps[t][shard]);
+  }
+
+  std::vector<std::pair<BookKey, uint64_t>> scored;
+  scored.reserve(merged.size());
+  for (const auto& [key, stats] : merged) {
+    if (static_cast<int>(stats.games()) < minGames) continue;
+    scored.push_back({key, uint64_t(stats.wins) * 2 + stats.draws});
+  }
+  ShardMap().swap(merged);
+
+  std::sort(scored.begin(), scored.end(), [](const auto& a, const auto& b) {
+    if (a.first.key != b.first.key) return a.first.key < b.first.key;
+    if (a.second != b.second) return a.second > b.second;
+    return a.first.move < b.first.move;
+  });
+
+  std::vector<PolyglotEntry> entries;
+  entries.reserve(scored.size());
+
+  for (size_t begin = 0; begin < scored.size();) {
+    size_t end = begin;
+    while (end < scored.size() && scored[end].first.key == scored[begin].first.key) {
+      end++;
+    }
+
+    // The first move of a position has the highest weight
+    uint64_t maxWeight = scored[begin].second;
+    for (size_t i = begin; i < end; i++) {
+      uint64_t weight = scored[i].second;
+      if (maxWeight > 0xFFFF) weight = weight * 0xFFFF / maxWeight;
+
+      entries.push_back({scored[i].first.key, scored[i].first.move,
+                         static_cast<uint16_t>(weight), 0});
+    }
+    begin = end;
+  }
+
+  return entries;
+}
+
+void printUsage() {
+  std::cout << "Usage: pawnstar-bookgen [options] FILE.pgn...\n"
+            << "  --output FILE     Polyglot book to write (default book.bin)\n"
+            << "  --concurrency N   worker threads (default 1)\n"
+            << "  --max-ply N       plies of each game to add (default 24)\n"
+            << "  --min-games N     games a move needs to be kept (default 3)\n";
+}
+
+bool parseArgs(int argc, char* argv[], BookgenConfig& config) {
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg.rfind("--", 0) != 0) {
+      config.inputs.push_back(arg);
+      continue;
+    }
+
+    if (i + 1 >= argc) return false;
+    std::string value = argv[++i];
+
+    if (arg == "--output") {
+      config.output = value;
+    } else if (arg == "--concurrency") {
+      config.concurrency = std::max(1, std::stoi(value));
+    } else if (arg == "--max-ply") {
+      config.maxPly = std::stoi(value);
+    } else if (arg == "--min-games") {
+      config.minGames = std::stoi(value);
+    } else {
+      return false;
+    }
+  }
+
+  return !config.inputs.empty();
+}
+
+int main(int argc, char* argv[]) {
+  BookgenConfig config;
+
+  try {
+    if (!parseArgs(argc, argv, config)) {
+      printUsage();
+      return 1;
+    }
+  } catch (const std::exception&) {
+    printUsage();
+    return 1;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+
+  // maps[thread][shard], every thread has its own visitor and maps
+  std::vector<std::vector<ShardMap>> maps(
+      config.concurrency, std::vector<ShardMap>(SHARD_COUNT));
+  std::vector<std::unique_ptr<BookVisitor>> visitors;
+  std::vector<pgn::Visitor*> visitorPointers;
+  for (int t = 0; t < config.concurrency; t++) {
+    visitors.push_back(std::make_unique<BookVisitor>(maps[t], config.maxPly));
+    visitorPointers.push_back(visitors.back().get());
+  }
+
+  uint64_t totalBytes = 0;
+  for (const auto& input : config.inputs) {
+    MappedFile file(input);
+    if (!file.isOpen()) {
+      std::cerr << "Failed to open " << input << std::endl;
+      return 1;
+    }
+
+    std::cout << "Reading " << input << " (" << file.size() / (1024 * 1024)
+              << " MB) on " << config.concurrency << " thread(s)" << std::endl;
+    totalBytes += file.size();
+
+    size_t failed = readPgnParallel(file.view(), visitorPointers);
+    if (failed > 0) {
+      std::cerr << "Skipped the rest of " << failed
+                << " chunk(s) after an invalid game" << std::endl;
+    }
+  }
+
+  uint64_t games = 0;
+  for (const auto& visitor : visitors) games += visitor->games;
+
+  double parseSeconds = std::chrono::duration<double>(
+                            std::chrono::steady_clock::now() - start)
+                            .count();
+  std::cout << "Parsed " << games << " games in " << parseSeconds << "s ("
+            << static_cast<int64_t>(totalBytes / std::max(parseSeconds, 1e-3) /
+                                    (1024 * 1024))
+            << " MB/s)" << std::endl;
+
+  // Shards are independent, every thread merges and sorts its share
+  std::vector<std::vector<PolyglotEntry>> shardEntries(SHARD_COUNT);
+  std::atomic<int> nextShard{0};
+  std::vector<std::thread> workers;
+  for (int t = 0; t < config.concurrency; t++) {
+    workers.emplace_back([&]() {
+      for (int shard = nextShard++; shard < SHARD_COUNT; shard = nextShard++) {
+        shardEntries[shard] = buildShard(maps, shard, config.minGames);
+      }
+    });
+  }
+  for (auto& worker : workers) worker.join();
+
+  std::ofstream out(config.output, std::ios::binary);
+  if (!out.is_open()) {
+    std::cerr << "Failed to open " << config.output << std::endl;
+    return 1;
+  }
+
+  uint64_t entryCount = 0;
+  std::vector<uint8_t> bytes;
+  for (const auto& entries : shardEntries) {
+    bytes.resize(entries.size() * POLYGLOT_ENTRY_BYTES);
+    for (size_t i = 0; i < entries.size(); i++) {
+      entries[i].write(bytes.data() + i * POLYGLOT_ENTRY_BYTES);
+    }
+    out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    entryCount += entries.size();
+  }
+  out.close();
+
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  std::cout << "Wrote " << entryCount << " entries to " << config.output
+            << " in " << seconds << "s" << std::endl;
+
+  return 0;
+}
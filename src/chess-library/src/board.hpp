@@ -7,8 +7,13 @@
 #include <optional>
 #include <string>
 #include <string_view>
+#include <type_traits>
 #include <vector>
 
+#if defined(__SSE2__) || defined(_M_X64)
+#    include <emmintrin.h>
+#endif
+
 #include "attacks_fwd.hpp"
 #include "color.hpp"
 #include "constants.hpp"
@@ -81,23 +86,58 @@ class Board {
         std::array<std::array<File, 2>, 2> rooks;
     };
 
+    /**
+     * @brief Everything that describes the current position, except the move history.
+     * Stored contiguously and trivially copyable, so a position can be saved and
+     * restored with a single copy (see unmakeMove(const Position &)).
+     */
+    struct alignas(64) Position {
+        std::array<Bitboard, 6> pieces_bb = {};
+        std::array<Bitboard, 2> occ_bb    = {};
+        std::array<Piece, 64> board       = {};
+
+        U64 key           = 0ULL;
+        U64 pawn_key      = 0ULL;
+        U64 material_key  = 0ULL;
+        CastlingRights cr = {};
+        uint16_t plies    = 0;
+        Color stm         = Color::WHITE;
+        Square ep_sq      = Square::underlying::NO_SQ;
+        uint8_t hfm       = 0;
+    };
+
+    static_assert(std::is_trivially_copyable_v<Position>, "Position must be trivially copyable");
+
    private:
     struct State {
         U64 hash;
+        U64 pawn_hash;
+        U64 material_hash;
         CastlingRights castling;
         Square enpassant;
         uint8_t half_moves;
         Piece captured_piece;
 
-        State(const U64 &hash, const CastlingRights &castling, const Square &enpassant, const uint8_t &half_moves,
-              const Piece &captured_piece)
+        State(const U64 &hash, const U64 &pawn_hash, const U64 &material_hash, const CastlingRights &castling,
+              const Square &enpassant, const uint8_t &half_moves, const Piece &captured_piece)
             : hash(hash),
+              pawn_hash(pawn_hash),
+              material_hash(material_hash),
               castling(castling),
               enpassant(enpassant),
               half_moves(half_moves),
               captured_piece(captured_piece) {}
     };
 
+    // Per-position data used to detect checks without making the move.
+    struct CheckInfo {
+        // squares from which a piece of the given type would attack the enemy king
+        std::array<Bitboard, 6> check_squares;
+        // our pieces which are the only blocker between one of our sliders and the enemy king
+        Bitboard blockers;
+        Square king_sq;
+    };
+
     enum class PrivateCtor { CREATE };
 
     // private constructor to avoid initialization
@@ -214,11 +254,11 @@ class Board {
 
         // Append " w " or " b " to the FEN string, depending on which player's turn it is
         ss += ' ';
-        ss += (stm_ == Color::WHITE ? 'w' : 'b');
+        ss += (pos_.stm == Color::WHITE ? 'w' : 'b');
 
         // Append the appropriate characters to the FEN string to indicate
         // whether castling is allowed for each player
-        if (cr_.isEmpty())
+        if (pos_.cr.isEmpty())
             ss += " -";
         else {
             ss += ' ';
@@ -227,11 +267,11 @@ class Board {
 
         // Append information about the en passant square (if any)
         // and the half-move clock and full move number to the FEN string
-        if (ep_sq_ == Square::underlying::NO_SQ)
+        if (pos_.ep_sq == Square::underlying::NO_SQ)
             ss += " -";
         else {
             ss += ' ';
-            ss += static_cast<std::string>(ep_sq_);
+            ss += static_cast<std::string>(pos_.ep_sq);
         }
 
         if (move_counters) {
@@ -268,165 +308,205 @@ class Board {
      */
     template <bool EXACT = false>
     void makeMove(const Move move) {
-        const auto capture  = at(move.to()) != Piece::NONE && move.typeOf() != Move::CASTLING;
-        const auto captured = at(move.to());
-        const auto pt       = at<PieceType>(move.from());
-
         // Validate side to move
-        assert((at(move.from()) < Piece::BLACKPAWN) == (stm_ == Color::WHITE));
+        assert((at(move.from()) < Piece::BLACKPAWN) == (pos_.stm == Color::WHITE));
 
-        prev_states_.emplace_back(key_, cr_, ep_sq_, hfm_, captured);
+        // dispatch once on the side to move and the move type
+        if (pos_.stm == Color::WHITE) {
+            makeMoveOfType<Color::WHITE, EXACT>(move);
+        } else {
+            makeMoveOfType<Color::BLACK, EXACT>(move);
+        }
+    }
 
-        hfm_++;
-        plies_++;
+    /**
+     * @brief Make a move for a known side to move, dispatches on the move type.
+     * @tparam c side to move
+     * @tparam EXACT
+     * @param move
+     */
+    template <Color::underlying c, bool EXACT = false>
+    void makeMoveOfType(const Move move) {
+        switch (move.typeOf()) {
+            case Move::NORMAL:
+                makeMove<c, Move::NORMAL, EXACT>(move);
+                break;
+            case Move::PROMOTION:
+                makeMove<c, Move::PROMOTION, EXACT>(move);
+                break;
+            case Move::ENPASSANT:
+                makeMove<c, Move::ENPASSANT, EXACT>(move);
+                break;
+            default:
+                makeMove<c, Move::CASTLING, EXACT>(move);
+                break;
+        }
+    }
 
-        if (ep_sq_ != Square::underlying::NO_SQ) key_ ^= Zobrist::enpassant(ep_sq_.file());
-        ep_sq_ = Square::underlying::NO_SQ;
+    /**
+     * @brief Make a move for a known side to move and move type. The move must be legal
+     * and of type MoveType, otherwise the behavior is undefined.
+     * @tparam c side to move
+     * @tparam MoveType one of Move::NORMAL, Move::PROMOTION, Move::ENPASSANT, Move::CASTLING
+     * @tparam EXACT
+     * @param move
+     */
+    template <Color::underlying c, std::uint16_t MoveType, bool EXACT = false>
+    void makeMove(const Move move) {
+        constexpr auto them = ~c;
 
-        if (capture) {
-            removePiece(captured, move.to());
+        const auto from     = move.from();
+        const auto to       = move.to();
+        const auto captured = MoveType == Move::CASTLING ? Piece(Piece::NONE) : at(to);
 
-            hfm_ = 0;
-            key_ ^= Zobrist::piece(captured, move.to());
+        assert(move.typeOf() == MoveType);
+        assert(pos_.stm == c);
 
-            // remove castling rights if rook is captured
-            if (captured.type() == PieceType::ROOK && Rank::back_rank(move.to().rank(), ~stm_)) {
-                const auto king_sq = kingSq(~stm_);
-                const auto file    = CastlingRights::closestSide(move.to(), king_sq);
+        prev_states_.emplace_back(pos_.key, pos_.pawn_key, pos_.material_key, pos_.cr, pos_.ep_sq, pos_.hfm, captured);
 
-                if (cr_.getRookFile(~stm_, file) == move.to().file()) {
-                    key_ ^= Zobrist::castlingIndex(cr_.clear(~stm_, file));
-                }
-            }
-        }
+        pos_.hfm++;
+        pos_.plies++;
 
-        // remove castling rights if king moves
-        if (pt == PieceType::KING && cr_.has(stm_)) {
-            key_ ^= Zobrist::castling(cr_.hashIndex());
-            cr_.clear(stm_);
-            key_ ^= Zobrist::castling(cr_.hashIndex());
-        } else if (pt == PieceType::ROOK && Square::back_rank(move.from(), stm_)) {
-            const auto king_sq = kingSq(stm_);
-            const auto file    = CastlingRights::closestSide(move.from(), king_sq);
-
-            // remove castling rights if rook moves from back rank
-            if (cr_.getRookFile(stm_, file) == move.from().file()) {
-                key_ ^= Zobrist::castlingIndex(cr_.clear(stm_, file));
-            }
-        } else if (pt == PieceType::PAWN) {
-            hfm_ = 0;
+        if (pos_.ep_sq != Square::underlying::NO_SQ) pos_.key ^= Zobrist::enpassant(pos_.ep_sq.file());
+        pos_.ep_sq = Square::underlying::NO_SQ;
 
-            // double push
-            if (Square::value_distance(move.to(), move.from()) == 16) {
-                // imaginary attacks from the ep square from the pawn which moved
-                Bitboard ep_mask = attacks::pawn(stm_, move.to().ep_square());
+        // remove castling rights if the king or a rook leaves its square or a rook is captured
+        const auto lost_rights = castling_mask_[from.index()] | castling_mask_[to.index()];
 
-                // add enpassant hash if enemy pawns are attacking the square
-                if (static_cast<bool>(ep_mask & pieces(PieceType::PAWN, ~stm_))) {
-                    int found = -1;
+        if (pos_.cr.hashIndex() & lost_rights) {
+            pos_.key ^= Zobrist::castling(pos_.cr.hashIndex());
 
-                    // check if the enemy can legally capture the pawn on the next move
-                    if constexpr (EXACT) {
-                        const auto piece = at(move.from());
+            for (int i = 0; i < 4; i++) {
+                if (lost_rights & (1 << i)) {
+                    const auto side =
+                        i % 2 == 0 ? CastlingRights::Side::KING_SIDE : CastlingRights::Side::QUEEN_SIDE;
+                    pos_.cr.clear(i < 2 ? Color::WHITE : Color::BLACK, side);
+                }
+            }
 
-                        found = 0;
+            pos_.key ^= Zobrist::castling(pos_.cr.hashIndex());
+        }
 
-                        removePieceInternal(piece, move.from());
-                        placePieceInternal(piece, move.to());
+        if constexpr (MoveType == Move::CASTLING) {
+            assert(at<PieceType>(from) == PieceType::KING);
+            assert(at<PieceType>(to) == PieceType::ROOK);
 
-                        stm_ = ~stm_;
+            const bool king_side = to > from;
+            const auto rookTo    = Square::castling_rook_square(king_side, c);
+            const auto kingTo    = Square::castling_king_square(king_side, c);
 
-                        bool valid;
+            constexpr auto king = Piece(PieceType::KING, c);
+            constexpr auto rook = Piece(PieceType::ROOK, c);
 
-                        if (stm_ == Color::WHITE) {
-                            valid = movegen::isEpSquareValid<Color::WHITE>(*this, move.to().ep_square());
-                        } else {
-                            valid = movegen::isEpSquareValid<Color::BLACK>(*this, move.to().ep_square());
-                        }
+            removePiece(king, from);
+            removePiece(rook, to);
 
-                        if (valid) found = 1;
+            placePiece(king, kingTo);
+            placePiece(rook, rookTo);
 
-                        // undo
-                        stm_ = ~stm_;
+            pos_.key ^= Zobrist::piece(king, from) ^ Zobrist::piece(king, kingTo);
+            pos_.key ^= Zobrist::piece(rook, to) ^ Zobrist::piece(rook, rookTo);
+        } else if constexpr (MoveType == Move::PROMOTION) {
+            constexpr auto piece_pawn = Piece(PieceType::PAWN, c);
+            const auto piece_prom     = Piece(move.promotionType(), c);
 
-                        removePieceInternal(piece, move.to());
-                        placePieceInternal(piece, move.from());
-                    }
+            pos_.hfm = 0;
 
-                    if (found != 0) {
-                        assert(at(move.to().ep_square()) == Piece::NONE);
-                        ep_sq_ = move.to().ep_square();
-                        key_ ^= Zobrist::enpassant(move.to().ep_square().file());
-                    }
-                }
+            if (captured != Piece::NONE) {
+                removePiece(captured, to);
+                pos_.key ^= Zobrist::piece(captured, to);
+                pos_.material_key ^= pieceCountKey(captured);
             }
-        }
-
-        if (move.typeOf() == Move::CASTLING) {
-            assert(at<PieceType>(move.from()) == PieceType::KING);
-            assert(at<PieceType>(move.to()) == PieceType::ROOK);
 
-            const bool king_side = move.to() > move.from();
-            const auto rookTo    = Square::castling_rook_square(king_side, stm_);
-            const auto kingTo    = Square::castling_king_square(king_side, stm_);
+            removePiece(piece_pawn, from);
+            pos_.material_key ^= pieceCountKey(piece_pawn);
+            pos_.material_key ^= pieceCountKey(piece_prom);
+            placePiece(piece_prom, to);
 
-            const auto king = at(move.from());
-            const auto rook = at(move.to());
+            pos_.key ^= Zobrist::piece(piece_pawn, from) ^ Zobrist::piece(piece_prom, to);
+            pos_.pawn_key ^= Zobrist::piece(piece_pawn, from);
+        } else if constexpr (MoveType == Move::ENPASSANT) {
+            constexpr auto piece_pawn = Piece(PieceType::PAWN, c);
+            constexpr auto enemy_pawn = Piece(PieceType::PAWN, them);
 
-            removePiece(king, move.from());
-            removePiece(rook, move.to());
+            assert(at(to.ep_square()) == enemy_pawn);
 
-            assert(king == Piece(PieceType::KING, stm_));
-            assert(rook == Piece(PieceType::ROOK, stm_));
+            pos_.hfm = 0;
 
-            placePiece(king, kingTo);
-            placePiece(rook, rookTo);
+            removePiece(enemy_pawn, to.ep_square());
+            removePiece(piece_pawn, from);
+            placePiece(piece_pawn, to);
 
-            key_ ^= Zobrist::piece(king, move.from()) ^ Zobrist::piece(king, kingTo);
-            key_ ^= Zobrist::piece(rook, move.to()) ^ Zobrist::piece(rook, rookTo);
-        } else if (move.typeOf() == Move::PROMOTION) {
-            const auto piece_pawn = Piece(PieceType::PAWN, stm_);
-            const auto piece_prom = Piece(move.promotionType(), stm_);
+            pos_.material_key ^= pieceCountKey(enemy_pawn);
 
-            removePiece(piece_pawn, move.from());
-            placePiece(piece_prom, move.to());
+            pos_.key ^= Zobrist::piece(enemy_pawn, to.ep_square());
+            pos_.key ^= Zobrist::piece(piece_pawn, from) ^ Zobrist::piece(piece_pawn, to);
 
-            key_ ^= Zobrist::piece(piece_pawn, move.from()) ^ Zobrist::piece(piece_prom, move.to());
+            pos_.pawn_key ^= Zobrist::piece(enemy_pawn, to.ep_square());
+            pos_.pawn_key ^= Zobrist::piece(piece_pawn, from) ^ Zobrist::piece(piece_pawn, to);
         } else {
-            assert(at(move.from()) != Piece::NONE);
-            assert(at(move.to()) == Piece::NONE);
+            assert(at(from) != Piece::NONE);
 
-            const auto piece = at(move.from());
+            const auto piece = at(from);
 
-            removePiece(piece, move.from());
-            placePiece(piece, move.to());
+            if (captured != Piece::NONE) {
+                pos_.hfm = 0;
 
-            key_ ^= Zobrist::piece(piece, move.from()) ^ Zobrist::piece(piece, move.to());
-        }
+                removePiece(captured, to);
+                pos_.key ^= Zobrist::piece(captured, to);
+                pos_.material_key ^= pieceCountKey(captured);
 
-        if (move.typeOf() == Move::ENPASSANT) {
-            assert(at<PieceType>(move.to().ep_square()) == PieceType::PAWN);
+                if (captured.type() == PieceType::PAWN) pos_.pawn_key ^= Zobrist::piece(captured, to);
+            }
+
+            removePiece(piece, from);
+            placePiece(piece, to);
 
-            const auto piece = Piece(PieceType::PAWN, ~stm_);
+            pos_.key ^= Zobrist::piece(piece, from) ^ Zobrist::piece(piece, to);
 
-            removePiece(piece, move.to().ep_square());
+            if (piece.type() == PieceType::PAWN) {
+                pos_.hfm = 0;
+                pos_.pawn_key ^= Zobrist::piece(piece, from) ^ Zobrist::piece(piece, to);
+
+                // double push
+                if (Square::value_distance(to, from) == 16) {
+                    // imaginary attacks from the ep square from the pawn which moved
+                    Bitboard ep_mask = attacks::pawn(c, to.ep_square());
+
+                    // add enpassant hash if enemy pawns are attacking the square
+                    if (static_cast<bool>(ep_mask & pieces(PieceType::PAWN, them))) {
+                        bool valid = true;
+
+                        // check if the enemy can legally capture the pawn on the next move
+                        if constexpr (EXACT) {
+                            pos_.stm = them;
+                            valid    = movegen::isEpSquareValid<them>(*this, to.ep_square());
+                            pos_.stm = c;
+                        }
 
-            key_ ^= Zobrist::piece(piece, move.to().ep_square());
+                        if (valid) {
+                            assert(at(to.ep_square()) == Piece::NONE);
+                            pos_.ep_sq = to.ep_square();
+                            pos_.key ^= Zobrist::enpassant(to.ep_square().file());
+                        }
+                    }
+                }
+            }
         }
 
-        key_ ^= Zobrist::sideToMove();
-        stm_ = ~stm_;
+        pos_.key ^= Zobrist::sideToMove();
+        pos_.stm = them;
     }
 
     void unmakeMove(const Move move) {
         const auto prev = prev_states_.back();
         prev_states_.pop_back();
 
-        ep_sq_ = prev.enpassant;
-        cr_    = prev.castling;
-        hfm_   = prev.half_moves;
-        stm_   = ~stm_;
-        plies_--;
+        pos_.ep_sq = prev.enpassant;
+        pos_.cr    = prev.castling;
+        pos_.hfm   = prev.half_moves;
+        pos_.stm   = ~pos_.stm;
+        pos_.plies--;
 
         if (move.typeOf() == Move::CASTLING) {
             const bool king_side    = move.to() > move.from();
@@ -442,17 +522,19 @@ class Board {
             removePiece(rook, rook_from_sq);
             removePiece(king, king_to_sq);
 
-            assert(king == Piece(PieceType::KING, stm_));
-            assert(rook == Piece(PieceType::ROOK, stm_));
+            assert(king == Piece(PieceType::KING, pos_.stm));
+            assert(rook == Piece(PieceType::ROOK, pos_.stm));
 
             placePiece(king, move.from());
             placePiece(rook, move.to());
 
-            key_ = prev.hash;
+            pos_.key          = prev.hash;
+            pos_.pawn_key     = prev.pawn_hash;
+            pos_.material_key = prev.material_hash;
 
             return;
         } else if (move.typeOf() == Move::PROMOTION) {
-            const auto pawn  = Piece(PieceType::PAWN, stm_);
+            const auto pawn  = Piece(PieceType::PAWN, pos_.stm);
             const auto piece = at(move.to());
 
             assert(piece.type() == move.promotionType());
@@ -468,7 +550,9 @@ class Board {
                 placePiece(prev.captured_piece, move.to());
             }
 
-            key_ = prev.hash;
+            pos_.key          = prev.hash;
+            pos_.pawn_key     = prev.pawn_hash;
+            pos_.material_key = prev.material_hash;
             return;
         } else {
             assert(at(move.to()) != Piece::NONE);
@@ -481,8 +565,8 @@ class Board {
         }
 
         if (move.typeOf() == Move::ENPASSANT) {
-            const auto pawn   = Piece(PieceType::PAWN, ~stm_);
-            const auto pawnTo = static_cast<Square>(ep_sq_ ^ 8);
+            const auto pawn   = Piece(PieceType::PAWN, ~pos_.stm);
+            const auto pawnTo = static_cast<Square>(pos_.ep_sq ^ 8);
 
             assert(at(pawnTo) == Piece::NONE);
 
@@ -493,22 +577,42 @@ class Board {
             placePiece(prev.captured_piece, move.to());
         }
 
-        key_ = prev.hash;
+        pos_.key          = prev.hash;
+        pos_.pawn_key     = prev.pawn_hash;
+        pos_.material_key = prev.material_hash;
     }
 
+    /**
+     * @brief Copy-make alternative to unmakeMove(Move). Restores the position which was
+     * saved with position() before the last makeMove(), with a single copy.
+     * @param saved
+     */
+    void unmakeMove(const Position &saved) {
+        pos_ = saved;
+        prev_states_.pop_back();
+    }
+
+    /**
+     * @brief Get the trivially copyable part of the board, used to save a position
+     * before making a move in copy-make mode.
+     * @return
+     */
+    [[nodiscard]] const Position &position() const { return pos_; }
+
     /**
      * @brief Make a null move. (Switches the side to move)
      */
     void makeNullMove() {
-        prev_states_.emplace_back(key_, cr_, ep_sq_, hfm_, Piece::NONE);
+        prev_states_.emplace_back(pos_.key, pos_.pawn_key, pos_.material_key, pos_.cr, pos_.ep_sq, pos_.hfm,
+                                  Piece::NONE);
 
-        key_ ^= Zobrist::sideToMove();
-        if (ep_sq_ != Square::underlying::NO_SQ) key_ ^= Zobrist::enpassant(ep_sq_.file());
-        ep_sq_ = Square::underlying::NO_SQ;
+        pos_.key ^= Zobrist::sideToMove();
+        if (pos_.ep_sq != Square::underlying::NO_SQ) pos_.key ^= Zobrist::enpassant(pos_.ep_sq.file());
+        pos_.ep_sq = Square::underlying::NO_SQ;
 
-        stm_ = ~stm_;
+        pos_.stm = ~pos_.stm;
 
-        plies_++;
+        pos_.plies++;
     }
 
     /**
@@ -517,14 +621,14 @@ class Board {
     void unmakeNullMove() {
         const auto &prev = prev_states_.back();
 
-        ep_sq_ = prev.enpassant;
-        cr_    = prev.castling;
-        hfm_   = prev.half_moves;
-        key_   = prev.hash;
+        pos_.ep_sq = prev.enpassant;
+        pos_.cr    = prev.castling;
+        pos_.hfm   = prev.half_moves;
+        pos_.key   = prev.hash;
 
-        plies_--;
+        pos_.plies--;
 
-        stm_ = ~stm_;
+        pos_.stm = ~pos_.stm;
 
         prev_states_.pop_back();
     }
@@ -534,7 +638,7 @@ class Board {
      * @param color
      * @return
      */
-    [[nodiscard]] Bitboard us(Color color) const { return occ_bb_[color]; }
+    [[nodiscard]] Bitboard us(Color color) const { return pos_.occ_bb[color]; }
 
     /**
      * @brief Get the occupancy bitboard for the opposite color.
@@ -548,7 +652,7 @@ class Board {
      * Faster than calling all() or us(Color::WHITE) | us(Color::BLACK).
      * @return
      */
-    [[nodiscard]] Bitboard occ() const { return occ_bb_[0] | occ_bb_[1]; }
+    [[nodiscard]] Bitboard occ() const { return pos_.occ_bb[0] | pos_.occ_bb[1]; }
 
     /**
      * @brief Get the occupancy bitboard for all pieces, should be only used internally.
@@ -572,7 +676,9 @@ class Board {
      * @param color
      * @return
      */
-    [[nodiscard]] Bitboard pieces(PieceType type, Color color) const { return pieces_bb_[type] & occ_bb_[color]; }
+    [[nodiscard]] Bitboard pieces(PieceType type, Color color) const {
+        return pos_.pieces_bb[type] & pos_.occ_bb[color];
+    }
 
     /**
      * @brief Returns all pieces of a certain type
@@ -594,9 +700,9 @@ class Board {
         assert(sq.index() < 64 && sq.index() >= 0);
 
         if constexpr (std::is_same_v<T, PieceType>) {
-            return board_[sq.index()].type();
+            return pos_.board[sq.index()].type();
         } else {
-            return board_[sq.index()];
+            return pos_.board[sq.index()];
         }
     }
 
@@ -613,12 +719,12 @@ class Board {
      * @brief Get the current zobrist hash key of the board
      * @return
      */
-    [[nodiscard]] U64 hash() const { return key_; }
-    [[nodiscard]] Color sideToMove() const { return stm_; }
-    [[nodiscard]] Square enpassantSq() const { return ep_sq_; }
-    [[nodiscard]] CastlingRights castlingRights() const { return cr_; }
-    [[nodiscard]] std::uint32_t halfMoveClock() const { return hfm_; }
-    [[nodiscard]] std::uint32_t fullMoveNumber() const { return 1 + plies_ / 2; }
+    [[nodiscard]] U64 hash() const { return pos_.key; }
+    [[nodiscard]] Color sideToMove() const { return pos_.stm; }
+    [[nodiscard]] Square enpassantSq() const { return pos_.ep_sq; }
+    [[nodiscard]] CastlingRights castlingRights() const { return pos_.cr; }
+    [[nodiscard]] std::uint32_t halfMoveClock() const { return pos_.hfm; }
+    [[nodiscard]] std::uint32_t fullMoveNumber() const { return 1 + pos_.plies / 2; }
 
     void set960(bool is960) {
         chess960_ = is960;
@@ -646,17 +752,17 @@ class Board {
 
             for (auto color : {Color::WHITE, Color::BLACK})
                 for (auto side : {CastlingRights::Side::KING_SIDE, CastlingRights::Side::QUEEN_SIDE})
-                    if (cr_.has(color, side)) ss += get_file(cr_, color, side);
+                    if (pos_.cr.has(color, side)) ss += get_file(pos_.cr, color, side);
 
             return ss;
         }
 
         std::string ss;
 
-        if (cr_.has(Color::WHITE, CastlingRights::Side::KING_SIDE)) ss += 'K';
-        if (cr_.has(Color::WHITE, CastlingRights::Side::QUEEN_SIDE)) ss += 'Q';
-        if (cr_.has(Color::BLACK, CastlingRights::Side::KING_SIDE)) ss += 'k';
-        if (cr_.has(Color::BLACK, CastlingRights::Side::QUEEN_SIDE)) ss += 'q';
+        if (pos_.cr.has(Color::WHITE, CastlingRights::Side::KING_SIDE)) ss += 'K';
+        if (pos_.cr.has(Color::WHITE, CastlingRights::Side::QUEEN_SIDE)) ss += 'Q';
+        if (pos_.cr.has(Color::BLACK, CastlingRights::Side::KING_SIDE)) ss += 'k';
+        if (pos_.cr.has(Color::BLACK, CastlingRights::Side::QUEEN_SIDE)) ss += 'q';
 
         return ss;
     }
@@ -675,14 +781,97 @@ class Board {
         // be across half-moves.
         const auto size = static_cast<int>(prev_states_.size());
 
-        for (int i = size - 2; i >= 0 && i >= size - hfm_ - 1; i -= 2) {
-            if (prev_states_[i].hash == key_) c++;
+        for (int i = size - 2; i >= 0 && i >= size - pos_.hfm - 1; i -= 2) {
+            if (prev_states_[i].hash == pos_.key) c++;
             if (c == count) return true;
         }
 
         return false;
     }
 
+    /**
+     * @brief Checks if the current position is a draw by repetition as seen from a search.
+     * A single earlier occurrence counts if it lies within the last `ply` half moves,
+     * i.e. inside the current search path, otherwise the position has to occur twice before.
+     * Only the window since the last irreversible move is scanned.
+     * @param ply distance to the root of the search
+     * @return
+     */
+    [[nodiscard]] bool isRepetitionDraw(int ply) const {
+        const auto size = static_cast<int>(prev_states_.size());
+        const auto end  = std::min<int>(pos_.hfm, size);
+
+        // a position can repeat at the earliest after 4 half moves
+        if (end < 4) return false;
+
+        bool seen = false;
+
+        for (int distance = 4; distance <= end; distance += 2) {
+            if (prev_states_[size - distance].hash != pos_.key) continue;
+
+            if (distance <= ply || seen) return true;
+            seen = true;
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief Checks if the side to move has a move which repeats an earlier position,
+     * using the cuckoo tables of reversible moves. The position after such a move
+     * is at least a draw for the side to move.
+     * Based on "Fast detection of upcoming repetitions" by Marcel van Kervinck.
+     * @param ply distance to the root of the search
+     * @return
+     */
+    [[nodiscard]] bool hasUpcomingRepetition(int ply) const {
+        const auto size = static_cast<int>(prev_states_.size());
+        const auto end  = std::min<int>(pos_.hfm, size);
+
+        if (end < 3) return false;
+
+        const auto &table  = cuckoo();
+        const auto key_at  = [&](int distance) { return prev_states_[size - distance].hash; };
+        const auto occ_all = occ();
+
+        U64 other = pos_.key ^ key_at(1) ^ Zobrist::sideToMove();
+
+        for (int i = 3; i <= end; i += 2) {
+            other ^= key_at(i - 1) ^ key_at(i) ^ Zobrist::sideToMove();
+
+            // the position i plies ago differs by more than a single piece move
+            if (other != 0) continue;
+
+            const U64 move_key = pos_.key ^ key_at(i);
+
+            int j = CuckooTable::h1(move_key);
+
+            if (table.keys[j] != move_key) {
+                j = CuckooTable::h2(move_key);
+                if (table.keys[j] != move_key) continue;
+            }
+
+            const auto move = table.moves[j];
+
+            // the move is only possible if the path is free
+            if (movegen::SQUARES_BETWEEN_BB[move.from().index()][move.to().index()] & occ_all) continue;
+
+            // the repetition lies inside the search path
+            if (ply > i) return true;
+
+            // before or at the root, the moving piece has to belong to the side to move
+            const auto piece = at(move.from()) != Piece::NONE ? at(move.from()) : at(move.to());
+            if (piece.color() != pos_.stm) continue;
+
+            // and the repeated position has to occur one more time
+            for (int k = i + 2; k <= end; k += 2) {
+                if (key_at(k) == key_at(i)) return true;
+            }
+        }
+
+        return false;
+    }
+
     /**
      * @brief Checks if the current position is a draw by 50 move rule.
      * Keep in mind that by the rules of chess, if the position has 50 half
@@ -691,7 +880,7 @@ class Board {
      * to determine whether the position is a draw or checkmate.
      * @return
      */
-    [[nodiscard]] bool isHalfMoveDraw() const { return hfm_ >= 100; }
+    [[nodiscard]] bool isHalfMoveDraw() const { return pos_.hfm >= 100; }
 
     /**
      * @brief Only call this function if isHalfMoveDraw() returns true.
@@ -792,7 +981,66 @@ class Board {
      * @brief Checks if the current side to move is in check
      * @return
      */
-    [[nodiscard]] bool inCheck() const { return isAttacked(kingSq(stm_), ~stm_); }
+    [[nodiscard]] bool inCheck() const { return isAttacked(kingSq(pos_.stm), ~pos_.stm); }
+
+    /**
+     * @brief Checks if a legal move gives check, without making it on the board.
+     * Uses the check squares and discovered check candidates of the current position,
+     * which are computed lazily once per position.
+     * @param move
+     * @return
+     */
+    [[nodiscard]] bool givesCheck(const Move move) const {
+        const auto &info = checkInfo();
+
+        const auto from = move.from();
+        const auto to   = move.to();
+        const auto pt   = at<PieceType>(from);
+
+        // castling, the king never gives direct check but the rook might
+        if (move.typeOf() == Move::CASTLING) {
+            const bool king_side = to > from;
+            const auto rook_to   = Square::castling_rook_square(king_side, pos_.stm);
+            const auto king_to   = Square::castling_king_square(king_side, pos_.stm);
+
+            const auto occ_after = (occ() ^ Bitboard::fromSquare(from) ^ Bitboard::fromSquare(to)) |
+                                   Bitboard::fromSquare(rook_to) | Bitboard::fromSquare(king_to);
+
+            return static_cast<bool>(attacks::rook(rook_to, occ_after) & Bitboard::fromSquare(info.king_sq));
+        }
+
+        // direct check
+        if (info.check_squares[pt] & Bitboard::fromSquare(to)) return true;
+
+        auto occ_after = (occ() ^ Bitboard::fromSquare(from)) | Bitboard::fromSquare(to);
+
+        // discovered check, the moving piece blocked one of our sliders
+        if ((info.blockers & Bitboard::fromSquare(from)) && sliderChecks(occ_after, from)) return true;
+
+        if (move.typeOf() == Move::PROMOTION) {
+            const auto promotion = move.promotionType();
+            Bitboard promotion_attacks;
+
+            if (promotion == PieceType::KNIGHT)
+                promotion_attacks = attacks::knight(to);
+            else if (promotion == PieceType::BISHOP)
+                promotion_attacks = attacks::bishop(to, occ_after);
+            else if (promotion == PieceType::ROOK)
+                promotion_attacks = attacks::rook(to, occ_after);
+            else
+                promotion_attacks = attacks::queen(to, occ_after);
+
+            return static_cast<bool>(promotion_attacks & Bitboard::fromSquare(info.king_sq));
+        }
+
+        // en passant removes a second piece which might uncover a slider
+        if (move.typeOf() == Move::ENPASSANT) {
+            occ_after ^= Bitboard::fromSquare(to.ep_square());
+            return sliderChecks(occ_after, from);
+        }
+
+        return false;
+    }
 
     /**
      * @brief Checks if the given color has at least 1 piece thats not pawn and not king
@@ -825,17 +1073,80 @@ class Board {
         }
 
         U64 ep_hash = 0ULL;
-        if (ep_sq_ != Square::underlying::NO_SQ) ep_hash ^= Zobrist::enpassant(ep_sq_.file());
+        if (pos_.ep_sq != Square::underlying::NO_SQ) ep_hash ^= Zobrist::enpassant(pos_.ep_sq.file());
 
         U64 stm_hash = 0ULL;
-        if (stm_ == Color::WHITE) stm_hash ^= Zobrist::sideToMove();
+        if (pos_.stm == Color::WHITE) stm_hash ^= Zobrist::sideToMove();
 
         U64 castling_hash = 0ULL;
-        castling_hash ^= Zobrist::castling(cr_.hashIndex());
+        castling_hash ^= Zobrist::castling(pos_.cr.hashIndex());
 
         return hash_key ^ ep_hash ^ stm_hash ^ castling_hash;
     }
 
+    /**
+     * @brief Calculates the zobrist key of the pawns only, expensive! Prefer using pawnKey().
+     * @return
+     */
+    [[nodiscard]] U64 pawnZobrist() const {
+        U64 hash_key = 0ULL;
+
+        auto pawns = pieces(PieceType::PAWN);
+
+        while (pawns.getBits()) {
+            const Square sq = pawns.pop();
+            hash_key ^= Zobrist::piece(at(sq), sq);
+        }
+
+        return hash_key;
+    }
+
+    /**
+     * @brief Zobrist key of the pawns only, updated incrementally like hash(). Positions
+     * with the same pawns share the key, which makes it the index of a pawn hash table.
+     * @return
+     */
+    [[nodiscard]] U64 pawnKey() const { return pos_.pawn_key; }
+
+    /**
+     * @brief Calculates the material key from the piece counts, expensive! Prefer using
+     * materialKey().
+     * @return
+     */
+    [[nodiscard]] U64 materialZobrist() const {
+        U64 hash_key = 0ULL;
+
+        for (int i = 0; i < 12; i++) {
+            const auto piece = Piece(static_cast<Piece::underlying>(i));
+            const int count  = pieces(piece.type(), piece.color()).count();
+
+            for (int n = 0; n < count; n++) hash_key ^= Zobrist::piece(piece, Square(n));
+        }
+
+        return hash_key;
+    }
+
+    /**
+     * @brief Zobrist key of the number of pieces of each type and color, updated
+     * incrementally like hash(). Positions with the same material share the key,
+     * wherever the pieces stand.
+     * @return
+     */
+    [[nodiscard]] U64 materialKey() const { return pos_.material_key; }
+
+    /**
+     * @brief Key of the position in a Polyglot opening book. Same as hash(), except
+     * that the en passant file is only hashed when a pawn of the side to move
+     * stands next to the double pushed pawn, as the Polyglot format requires.
+     * @return
+     */
+    [[nodiscard]] U64 polyglotKey() const {
+        if (pos_.ep_sq == Square::underlying::NO_SQ) return pos_.key;
+
+        const auto capturers = attacks::pawn(~pos_.stm, pos_.ep_sq) & pieces(PieceType::PAWN, pos_.stm);
+        return capturers ? pos_.key : pos_.key ^ Zobrist::enpassant(pos_.ep_sq.file());
+    }
+
     friend std::ostream &operator<<(std::ostream &os, const Board &board);
 
     /**
@@ -868,6 +1179,27 @@ class Board {
             return board;
         }
 
+        /**
+         * @brief Compresses count boards into out, which must have room for count PackedBoards.
+         * @param boards
+         * @param count
+         * @param out
+         */
+        static void encode(const Board *boards, std::size_t count, PackedBoard *out) {
+            for (std::size_t i = 0; i < count; i++) out[i] = encodeState(boards[i]);
+        }
+
+        /**
+         * @brief Decodes count PackedBoards into the existing boards in out,
+         * the chess960 flag of each output board is kept.
+         * @param compressed
+         * @param count
+         * @param out
+         */
+        static void decode(const PackedBoard *compressed, std::size_t count, Board *out) {
+            for (std::size_t i = 0; i < count; i++) decode(out[i], compressed[i]);
+        }
+
        private:
         /**
          * A compact board representation can be achieved in 24 bytes,
@@ -892,30 +1224,20 @@ class Board {
         static PackedBoard encodeState(const Board &board) {
             PackedBoard packed{};
 
-            packed[0] = board.occ().getBits() >> 56;
-            packed[1] = (board.occ().getBits() >> 48) & 0xFF;
-            packed[2] = (board.occ().getBits() >> 40) & 0xFF;
-            packed[3] = (board.occ().getBits() >> 32) & 0xFF;
-            packed[4] = (board.occ().getBits() >> 24) & 0xFF;
-            packed[5] = (board.occ().getBits() >> 16) & 0xFF;
-            packed[6] = (board.occ().getBits() >> 8) & 0xFF;
-            packed[7] = board.occ().getBits() & 0xFF;
+            storeOccupancy(packed, board.occ());
 
-            auto offset = 8 * 2;
-            auto occ    = board.occ();
+            // one nibble per occupied square, in square order
+            std::array<std::uint8_t, 32> nibbles{};
+            auto occ = board.occ();
+            int i    = 0;
 
             while (occ) {
-                // we now fill the packed array, since our convertedpiece only actually needs 4 bits,
-                // we can store 2 pieces in one byte.
-                const auto sq      = Square(occ.pop());
-                const auto shift   = (offset % 2 == 0 ? 4 : 0);
-                const auto meaning = convertMeaning(board.cr_, board.sideToMove(), board.ep_sq_, sq, board.at(sq));
-                const auto nibble  = meaning << shift;
-
-                packed[offset / 2] |= nibble;
-                offset++;
+                const auto sq = Square(occ.pop());
+                nibbles[i++]  = convertMeaning(board.pos_.cr, board.sideToMove(), board.pos_.ep_sq, sq, board.at(sq));
             }
 
+            packNibbles(nibbles, packed);
+
             return packed;
         }
 
@@ -984,49 +1306,41 @@ class Board {
                 }
             }
 
-            packed[0] = occ.getBits() >> 56;
-            packed[1] = (occ.getBits() >> 48) & 0xFF;
-            packed[2] = (occ.getBits() >> 40) & 0xFF;
-            packed[3] = (occ.getBits() >> 32) & 0xFF;
-            packed[4] = (occ.getBits() >> 24) & 0xFF;
-            packed[5] = (occ.getBits() >> 16) & 0xFF;
-            packed[6] = (occ.getBits() >> 8) & 0xFF;
-            packed[7] = occ.getBits() & 0xFF;
+            storeOccupancy(packed, occ);
 
             return packed;
         }
 
         static void decode(Board &board, const PackedBoard &compressed) {
-            Bitboard occupied = 0ull;
+            Bitboard occupied = loadOccupancy(compressed);
 
-            for (int i = 0; i < 8; i++) {
-                occupied |= Bitboard(compressed[i]) << (56 - i * 8);
-            }
+            std::array<std::uint8_t, 32> nibbles;
+            unpackNibbles(compressed, nibbles);
 
-            int offset           = 16;
+            int offset           = 0;
             int white_castle_idx = 0, black_castle_idx = 0;
             File white_castle[2] = {File::NO_FILE, File::NO_FILE};
             File black_castle[2] = {File::NO_FILE, File::NO_FILE};
 
             // clear board state
 
-            board.hfm_   = 0;
-            board.plies_ = 0;
+            board.pos_.hfm   = 0;
+            board.pos_.plies = 0;
 
-            board.stm_ = Color::WHITE;
+            board.pos_.stm = Color::WHITE;
 
-            board.cr_.clear();
+            board.pos_.cr.clear();
             board.prev_states_.clear();
             board.original_fen_.clear();
 
-            board.occ_bb_.fill(0ULL);
-            board.pieces_bb_.fill(0ULL);
-            board.board_.fill(Piece::NONE);
+            board.pos_.occ_bb.fill(0ULL);
+            board.pos_.pieces_bb.fill(0ULL);
+            board.pos_.board.fill(Piece::NONE);
 
             // place pieces back on the board
             while (occupied) {
                 const auto sq     = Square(occupied.pop());
-                const auto nibble = compressed[offset / 2] >> (offset % 2 == 0 ? 4 : 0) & 0b1111;
+                const auto nibble = nibbles[offset];
                 const auto piece  = convertPiece(nibble);
 
                 if (piece != Piece::NONE) {
@@ -1039,7 +1353,7 @@ class Board {
                 // Piece has a special meaning, interpret it from the raw integer
                 // pawn with ep square behind it
                 if (nibble == 12) {
-                    board.ep_sq_ = sq.ep_square();
+                    board.pos_.ep_sq = sq.ep_square();
                     // depending on the rank this is a white or black pawn
                     auto color = sq.rank() == Rank::RANK_4 ? Color::WHITE : Color::BLACK;
                     board.placePiece(Piece(PieceType::PAWN, color), sq);
@@ -1058,7 +1372,7 @@ class Board {
                 }
                 // black to move
                 else if (nibble == 15) {
-                    board.stm_ = Color::BLACK;
+                    board.pos_.stm = Color::BLACK;
                     board.placePiece(Piece(PieceType::KING, Color::BLACK), sq);
                 }
 
@@ -1072,7 +1386,7 @@ class Board {
                     const auto file    = white_castle[i];
                     const auto side    = CastlingRights::closestSide(file, king_sq.file());
 
-                    board.cr_.setCastlingRight(Color::WHITE, side, file);
+                    board.pos_.cr.setCastlingRight(Color::WHITE, side, file);
                 }
 
                 if (black_castle[i] != File::NO_FILE) {
@@ -1080,15 +1394,68 @@ class Board {
                     const auto file    = black_castle[i];
                     const auto side    = CastlingRights::closestSide(file, king_sq.file());
 
-                    board.cr_.setCastlingRight(Color::BLACK, side, file);
+                    board.pos_.cr.setCastlingRight(Color::BLACK, side, file);
                 }
             }
 
-            if (board.stm_ == Color::BLACK) {
-                board.plies_++;
+            board.initCastlingMask();
+
+            if (board.pos_.stm == Color::BLACK) {
+                board.pos_.plies++;
             }
 
-            board.key_ = board.zobrist();
+            board.pos_.key      = board.zobrist();
+            board.pos_.pawn_key = board.pawnZobrist();
+            board.pos_.material_key = board.materialZobrist();
+        }
+
+        // The occupancy is stored big endian in the first 8 bytes.
+        static void storeOccupancy(PackedBoard &packed, Bitboard occ) {
+            for (int i = 0; i < 8; i++) packed[i] = static_cast<std::uint8_t>(occ.getBits() >> (56 - i * 8));
+        }
+
+        static Bitboard loadOccupancy(const PackedBoard &packed) {
+            std::uint64_t occ = 0ULL;
+            for (int i = 0; i < 8; i++) occ |= std::uint64_t(packed[i]) << (56 - i * 8);
+            return occ;
+        }
+
+        // Packs 32 nibbles into bytes 8..23, the first nibble of a pair goes into the high half of the byte.
+        static void packNibbles(const std::array<std::uint8_t, 32> &nibbles, PackedBoard &packed) {
+#if defined(__SSE2__) || defined(_M_X64)
+            const auto mask_lo = _mm_set1_epi16(0x00FF);
+
+            for (int half = 0; half < 2; half++) {
+                // each 16 bit lane holds a nibble pair (first | second << 8)
+                const auto pairs = _mm_loadu_si128(reinterpret_cast<const __m128i *>(nibbles.data() + half * 16));
+                const auto bytes = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(pairs, mask_lo), 4),
+                                                _mm_srli_epi16(pairs, 8));
+
+                const auto packed8 = _mm_packus_epi16(bytes, bytes);
+                _mm_storel_epi64(reinterpret_cast<__m128i *>(packed.data() + 8 + half * 8), packed8);
+            }
+#else
+            for (int i = 0; i < 16; i++) {
+                packed[8 + i] = static_cast<std::uint8_t>((nibbles[2 * i] << 4) | nibbles[2 * i + 1]);
+            }
+#endif
+        }
+
+        static void unpackNibbles(const PackedBoard &packed, std::array<std::uint8_t, 32> &nibbles) {
+#if defined(__SSE2__) || defined(_M_X64)
+            const auto mask  = _mm_set1_epi8(0x0F);
+            const auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(packed.data() + 8));
+            const auto hi    = _mm_and_si128(_mm_srli_epi16(bytes, 4), mask);
+            const auto lo    = _mm_and_si128(bytes, mask);
+
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(nibbles.data()), _mm_unpacklo_epi8(hi, lo));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(nibbles.data() + 16), _mm_unpackhi_epi8(hi, lo));
+#else
+            for (int i = 0; i < 16; i++) {
+                nibbles[2 * i]     = packed[8 + i] >> 4;
+                nibbles[2 * i + 1] = packed[8 + i] & 0x0F;
+            }
+#endif
         }
 
         // 1:1 mapping of Piece::internal() to the compressed piece
@@ -1135,22 +1502,24 @@ class Board {
 
     std::vector<State> prev_states_;
 
-    std::array<Bitboard, 6> pieces_bb_ = {};
-    std::array<Bitboard, 2> occ_bb_    = {};
-    std::array<Piece, 64> board_       = {};
-
-    U64 key_           = 0ULL;
-    CastlingRights cr_ = {};
-    uint16_t plies_    = 0;
-    Color stm_         = Color::WHITE;
-    Square ep_sq_      = Square::underlying::NO_SQ;
-    uint8_t hfm_       = 0;
+    Position pos_;
 
     bool chess960_ = false;
 
+    // castling rights (as bits of CastlingRights::hashIndex()) which are lost when
+    // a piece moves from or to the square, set up together with the castling rights
+    std::array<std::uint8_t, 64> castling_mask_ = {};
+
    private:
+    // The n-th piece of a kind is hashed with the piece's key on square n, so adding
+    // or removing a piece changes the material key by the key of the piece count
+    // without the piece.
+    [[nodiscard]] U64 pieceCountKey(Piece piece) const {
+        return Zobrist::piece(piece, Square(pieces(piece.type(), piece.color()).count()));
+    }
+
     void removePieceInternal(Piece piece, Square sq) {
-        assert(board_[sq.index()] == piece && piece != Piece::NONE);
+        assert(pos_.board[sq.index()] == piece && piece != Piece::NONE);
 
         auto type  = piece.type();
         auto color = piece.color();
@@ -1160,13 +1529,13 @@ class Board {
         assert(color != Color::NONE);
         assert(index >= 0 && index < 64);
 
-        pieces_bb_[type].clear(index);
-        occ_bb_[color].clear(index);
-        board_[index] = Piece::NONE;
+        pos_.pieces_bb[type].clear(index);
+        pos_.occ_bb[color].clear(index);
+        pos_.board[index] = Piece::NONE;
     }
 
     void placePieceInternal(Piece piece, Square sq) {
-        assert(board_[sq.index()] == Piece::NONE);
+        assert(pos_.board[sq.index()] == Piece::NONE);
 
         auto type  = piece.type();
         auto color = piece.color();
@@ -1176,18 +1545,154 @@ class Board {
         assert(color != Color::NONE);
         assert(index >= 0 && index < 64);
 
-        pieces_bb_[type].set(index);
-        occ_bb_[color].set(index);
-        board_[index] = piece;
+        pos_.pieces_bb[type].set(index);
+        pos_.occ_bb[color].set(index);
+        pos_.board[index] = piece;
+    }
+
+    // Cuckoo tables with the zobrist differences of all reversible piece moves,
+    // indexed by two hash functions, used by hasUpcomingRepetition().
+    struct CuckooTable {
+        std::array<U64, 8192> keys   = {};
+        std::array<Move, 8192> moves = {};
+
+        static constexpr int h1(U64 key) { return static_cast<int>(key & 0x1FFF); }
+        static constexpr int h2(U64 key) { return static_cast<int>((key >> 16) & 0x1FFF); }
+    };
+
+    static const CuckooTable &cuckoo() {
+        static const CuckooTable table = [] {
+            CuckooTable t;
+
+            for (auto pt : {PieceType::KNIGHT, PieceType::BISHOP, PieceType::ROOK, PieceType::QUEEN, PieceType::KING}) {
+                for (auto color : {Color::WHITE, Color::BLACK}) {
+                    const auto piece = Piece(pt, color);
+
+                    for (int s1 = 0; s1 < 64; s1++) {
+                        Bitboard targets;
+
+                        if (pt == PieceType::KNIGHT)
+                            targets = attacks::knight(s1);
+                        else if (pt == PieceType::BISHOP)
+                            targets = attacks::bishop(s1, 0ULL);
+                        else if (pt == PieceType::ROOK)
+                            targets = attacks::rook(s1, 0ULL);
+                        else if (pt == PieceType::QUEEN)
+                            targets = attacks::queen(s1, 0ULL);
+                        else
+                            targets = attacks::king(s1);
+
+                        for (int s2 = s1 + 1; s2 < 64; s2++) {
+                            if (!(targets & Bitboard::fromSquare(s2))) continue;
+
+                            auto move = Move::make<Move::NORMAL>(s1, s2);
+                            U64 key   = Zobrist::piece(piece, s1) ^ Zobrist::piece(piece, s2) ^ Zobrist::sideToMove();
+
+                            // insert and push out the previous entry until we find an empty slot
+                            int i = CuckooTable::h1(key);
+
+                            while (true) {
+                                std::swap(t.keys[i], key);
+                                std::swap(t.moves[i], move);
+
+                                if (move == Move::NO_MOVE) break;
+
+                                i = (i == CuckooTable::h1(key)) ? CuckooTable::h2(key) : CuckooTable::h1(key);
+                            }
+                        }
+                    }
+                }
+            }
+
+            return t;
+        }();
+
+        return table;
+    }
+
+    void initCastlingMask() {
+        castling_mask_.fill(0);
+
+        for (Color color : {Color::WHITE, Color::BLACK}) {
+            for (auto side : {CastlingRights::Side::KING_SIDE, CastlingRights::Side::QUEEN_SIDE}) {
+                if (!pos_.cr.has(color, side)) continue;
+
+                const auto king_sq = kingSq(color);
+                const auto rook_sq = Square(pos_.cr.getRookFile(color, side), king_sq.rank());
+                const auto right   = 1 << (color * 2 + static_cast<int>(side));
+
+                castling_mask_[king_sq.index()] |= right;
+                castling_mask_[rook_sq.index()] |= right;
+            }
+        }
+    }
+
+    /**
+     * @brief Returns the check info of the current position, it is only recomputed
+     * when the position changed since the last call.
+     * @return
+     */
+    const CheckInfo &checkInfo() const {
+        if (check_info_valid_ && check_info_key_ == pos_.key) return check_info_;
+
+        const auto king_sq = kingSq(~pos_.stm);
+        const auto occ_all = occ();
+
+        check_info_.king_sq = king_sq;
+
+        check_info_.check_squares[static_cast<int>(PieceType::PAWN)]   = attacks::pawn(~pos_.stm, king_sq);
+        check_info_.check_squares[static_cast<int>(PieceType::KNIGHT)] = attacks::knight(king_sq);
+        check_info_.check_squares[static_cast<int>(PieceType::BISHOP)] = attacks::bishop(king_sq, occ_all);
+        check_info_.check_squares[static_cast<int>(PieceType::ROOK)]   = attacks::rook(king_sq, occ_all);
+        check_info_.check_squares[static_cast<int>(PieceType::QUEEN)] =
+            check_info_.check_squares[static_cast<int>(PieceType::BISHOP)] |
+            check_info_.check_squares[static_cast<int>(PieceType::ROOK)];
+        check_info_.check_squares[static_cast<int>(PieceType::KING)] = 0ULL;
+
+        // our sliders which would attack the king on an empty board
+        const auto queens = pieces(PieceType::QUEEN, pos_.stm);
+        auto snipers      = (attacks::bishop(king_sq, 0ULL) & (pieces(PieceType::BISHOP, pos_.stm) | queens)) |
+                            (attacks::rook(king_sq, 0ULL) & (pieces(PieceType::ROOK, pos_.stm) | queens));
+
+        check_info_.blockers = 0ULL;
+
+        while (snipers) {
+            const auto sniper  = snipers.pop();
+            const auto between = movegen::SQUARES_BETWEEN_BB[king_sq.index()][sniper] & occ_all;
+
+            if (between.count() == 1 && (between & us(pos_.stm))) check_info_.blockers |= between;
+        }
+
+        check_info_key_   = pos_.key;
+        check_info_valid_ = true;
+
+        return check_info_;
+    }
+
+    /**
+     * @brief Checks if one of our sliders, except the one on the moved_from square,
+     * attacks the enemy king given the occupancy after a move.
+     * @param occupied
+     * @param moved_from
+     * @return
+     */
+    bool sliderChecks(Bitboard occupied, Square moved_from) const {
+        const auto king_sq = checkInfo().king_sq;
+        const auto queens  = pieces(PieceType::QUEEN, pos_.stm);
+        const auto bishops = (pieces(PieceType::BISHOP, pos_.stm) | queens) & ~Bitboard::fromSquare(moved_from);
+        const auto rooks   = (pieces(PieceType::ROOK, pos_.stm) | queens) & ~Bitboard::fromSquare(moved_from);
+
+        return static_cast<bool>((attacks::bishop(king_sq, occupied) & bishops) |
+                                 (attacks::rook(king_sq, occupied) & rooks));
     }
 
     template <bool ctor = false>
     void setFenInternal(std::string_view fen) {
         original_fen_ = fen;
 
-        occ_bb_.fill(0ULL);
-        pieces_bb_.fill(0ULL);
-        board_.fill(Piece::NONE);
+        pos_.occ_bb.fill(0ULL);
+        pos_.pieces_bb.fill(0ULL);
+        pos_.board.fill(Piece::NONE);
 
         // find leading whitespaces and remove them
         while (fen[0] == ' ') fen.remove_prefix(1);
@@ -1218,22 +1723,23 @@ class Board {
         };
 
         // Half move clock
-        hfm_ = parseStringViewToInt(half_move).value_or(0);
+        pos_.hfm = parseStringViewToInt(half_move).value_or(0);
 
         // Full move number
-        plies_ = parseStringViewToInt(full_move).value_or(1);
-
-        plies_ = plies_ * 2 - 2;
-        ep_sq_ = en_passant == "-" ? Square::underlying::NO_SQ : Square(en_passant);
-        stm_   = (move_right == "w") ? Color::WHITE : Color::BLACK;
-        key_   = 0ULL;
-        cr_.clear();
+        pos_.plies = parseStringViewToInt(full_move).value_or(1);
+
+        pos_.plies = pos_.plies * 2 - 2;
+        pos_.ep_sq = en_passant == "-" ? Square::underlying::NO_SQ : Square(en_passant);
+        pos_.stm   = (move_right == "w") ? Color::WHITE : Color::BLACK;
+        pos_.key      = 0ULL;
+        pos_.pawn_key = 0ULL;
+        pos_.cr.clear();
         prev_states_.clear();
 
-        if (stm_ == Color::BLACK) {
-            plies_++;
+        if (pos_.stm == Color::BLACK) {
+            pos_.plies++;
         } else {
-            key_ ^= Zobrist::sideToMove();
+            pos_.key ^= Zobrist::sideToMove();
         }
 
         auto square = 56;
@@ -1252,7 +1758,8 @@ class Board {
                     placePiece(p, square);
                 }
 
-                key_ ^= Zobrist::piece(p, Square(square));
+                pos_.key ^= Zobrist::piece(p, Square(square));
+                if (p.type() == PieceType::PAWN) pos_.pawn_key ^= Zobrist::piece(p, Square(square));
                 ++square;
             }
         }
@@ -1286,10 +1793,10 @@ class Board {
             const auto queen_side = CastlingRights::Side::QUEEN_SIDE;
 
             if (!chess960_) {
-                if (i == 'K') cr_.setCastlingRight(Color::WHITE, king_side, File::FILE_H);
-                if (i == 'Q') cr_.setCastlingRight(Color::WHITE, queen_side, File::FILE_A);
-                if (i == 'k') cr_.setCastlingRight(Color::BLACK, king_side, File::FILE_H);
-                if (i == 'q') cr_.setCastlingRight(Color::BLACK, queen_side, File::FILE_A);
+                if (i == 'K') pos_.cr.setCastlingRight(Color::WHITE, king_side, File::FILE_H);
+                if (i == 'Q') pos_.cr.setCastlingRight(Color::WHITE, queen_side, File::FILE_A);
+                if (i == 'k') pos_.cr.setCastlingRight(Color::BLACK, king_side, File::FILE_H);
+                if (i == 'q') pos_.cr.setCastlingRight(Color::BLACK, queen_side, File::FILE_A);
 
                 continue;
             }
@@ -1301,45 +1808,51 @@ class Board {
 
             // find rook on the right side of the king
             if (i == 'K' || i == 'k') {
-                cr_.setCastlingRight(color, king_side, find_rook(*this, king_side, color));
+                pos_.cr.setCastlingRight(color, king_side, find_rook(*this, king_side, color));
             }
             // find rook on the left side of the king
             else if (i == 'Q' || i == 'q') {
-                cr_.setCastlingRight(color, queen_side, find_rook(*this, queen_side, color));
+                pos_.cr.setCastlingRight(color, queen_side, find_rook(*this, queen_side, color));
             }
             // correct frc castling encoding
             else {
                 const auto file = File(std::string_view(&i, 1));
                 const auto side = CastlingRights::closestSide(file, king_sq.file());
-                cr_.setCastlingRight(color, side, file);
+                pos_.cr.setCastlingRight(color, side, file);
             }
         }
 
+        initCastlingMask();
+
         // check if ep square itself is valid
-        if (ep_sq_ != Square::underlying::NO_SQ && !((ep_sq_.rank() == Rank::RANK_3 && stm_ == Color::BLACK) ||
-                                                     (ep_sq_.rank() == Rank::RANK_6 && stm_ == Color::WHITE))) {
-            ep_sq_ = Square::underlying::NO_SQ;
+        if (pos_.ep_sq != Square::underlying::NO_SQ &&
+            !((pos_.ep_sq.rank() == Rank::RANK_3 && pos_.stm == Color::BLACK) ||
+              (pos_.ep_sq.rank() == Rank::RANK_6 && pos_.stm == Color::WHITE))) {
+            pos_.ep_sq = Square::underlying::NO_SQ;
         }
 
         // check if ep square is valid, i.e. if there is a pawn that can capture it
-        if (ep_sq_ != Square::underlying::NO_SQ) {
+        if (pos_.ep_sq != Square::underlying::NO_SQ) {
             bool valid;
 
-            if (stm_ == Color::WHITE) {
-                valid = movegen::isEpSquareValid<Color::WHITE>(*this, ep_sq_);
+            if (pos_.stm == Color::WHITE) {
+                valid = movegen::isEpSquareValid<Color::WHITE>(*this, pos_.ep_sq);
             } else {
-                valid = movegen::isEpSquareValid<Color::BLACK>(*this, ep_sq_);
+                valid = movegen::isEpSquareValid<Color::BLACK>(*this, pos_.ep_sq);
             }
 
             if (!valid)
-                ep_sq_ = Square::underlying::NO_SQ;
+                pos_.ep_sq = Square::underlying::NO_SQ;
             else
-                key_ ^= Zobrist::enpassant(ep_sq_.file());
+                pos_.key ^= Zobrist::enpassant(pos_.ep_sq.file());
         }
 
-        key_ ^= Zobrist::castling(cr_.hashIndex());
+        pos_.key ^= Zobrist::castling(pos_.cr.hashIndex());
+
+        assert(pos_.key == zobrist());
+        assert(pos_.pawn_key == pawnZobrist());
 
-        assert(key_ == zobrist());
+        pos_.material_key = materialZobrist();
     }
 
     template <int N>
@@ -1366,24 +1879,29 @@ class Board {
     // store the original fen string
     // useful when setting up a frc position and the user called set960(true) afterwards
     std::string original_fen_;
+
+    // lazily computed by checkInfo(), valid as long as check_info_key_ matches the current key
+    mutable CheckInfo check_info_  = {};
+    mutable U64 check_info_key_    = 0ULL;
+    mutable bool check_info_valid_ = false;
 };
 
 inline std::ostream &operator<<(std::ostream &os, const Board &b) {
     for (int i = 63; i >= 0; i -= 8) {
         for (int j = 7; j >= 0; j--) {
-            os << " " << static_cast<std::string>(b.board_[i - j]);
+            os << " " << static_cast<std::string>(b.pos_.board[i - j]);
         }
 
         os << " \n";
     }
 
     os << "\n\n";
-    os << "Side to move: " << static_cast<int>(b.stm_.internal()) << "\n";
+    os << "Side to move: " << static_cast<int>(b.pos_.stm.internal()) << "\n";
     os << "Castling rights: " << b.getCastleString() << "\n";
     os << "Halfmoves: " << b.halfMoveClock() << "\n";
     os << "Fullmoves: " << b.fullMoveNumber() << "\n";
-    os << "EP: " << b.ep_sq_.index() << "\n";
-    os << "Hash: " << b.key_ << "\n";
+    os << "EP: " << b.pos_.ep_sq.index() << "\n";
+    os << "Hash: " << b.pos_.key << "\n";
 
     os << std::endl;
 
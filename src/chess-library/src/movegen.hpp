@@ -158,8 +158,8 @@ template <Color::underlying c>
     return seen;
 }
 
-template <Color::underlying c, movegen::MoveGenType mt>
-inline void movegen::generatePawnMoves(const Board &board, Movelist &moves, Bitboard pin_d, Bitboard pin_hv,
+template <Color::underlying c, movegen::MoveGenType mt, typename List>
+inline void movegen::generatePawnMoves(const Board &board, List &moves, Bitboard pin_d, Bitboard pin_hv,
                                        Bitboard checkmask, Bitboard occ_opp) {
     // flipped for black
 
@@ -405,8 +405,8 @@ template <Color::underlying c, movegen::MoveGenType mt>
     return moves;
 }
 
-template <typename T>
-inline void movegen::whileBitboardAdd(Movelist &movelist, Bitboard mask, T func) {
+template <typename List, typename T>
+inline void movegen::whileBitboardAdd(List &movelist, Bitboard mask, T func) {
     while (mask) {
         const Square from = mask.pop();
         auto moves        = func(from);
@@ -417,8 +417,8 @@ inline void movegen::whileBitboardAdd(Movelist &movelist, Bitboard mask, T func)
     }
 }
 
-template <Color::underlying c, movegen::MoveGenType mt>
-inline void movegen::legalmoves(Movelist &movelist, const Board &board, int pieces) {
+template <Color::underlying c, movegen::MoveGenType mt, typename List>
+inline void movegen::legalmoves(List &movelist, const Board &board, int pieces) {
     /*
      The size of the movelist might not
      be 0! This is done on purpose since it enables
@@ -517,6 +517,30 @@ inline void movegen::legalmoves(Movelist &movelist, const Board &board, int piec
         legalmoves<Color::BLACK, mt>(movelist, board, pieces);
 }
 
+template <movegen::MoveGenType mt>
+[[nodiscard]] inline Move *movegen::generate(const Board &board, Move *out, int pieces) {
+    MoveWriter<Move> writer{out};
+
+    if (board.sideToMove() == Color::WHITE)
+        legalmoves<Color::WHITE, mt>(writer, board, pieces);
+    else
+        legalmoves<Color::BLACK, mt>(writer, board, pieces);
+
+    return writer.end;
+}
+
+template <movegen::MoveGenType mt>
+[[nodiscard]] inline movegen::ScoredMove *movegen::generate(const Board &board, ScoredMove *out, int pieces) {
+    MoveWriter<ScoredMove> writer{out};
+
+    if (board.sideToMove() == Color::WHITE)
+        legalmoves<Color::WHITE, mt>(writer, board, pieces);
+    else
+        legalmoves<Color::BLACK, mt>(writer, board, pieces);
+
+    return writer.end;
+}
+
 template <Color::underlying c>
 inline bool movegen::isEpSquareValid(const Board &board, Square ep) {
     const auto stm = board.sideToMove();
@@ -2,6 +2,7 @@
 
 #include <array>
 #include <cstdint>
+#include <type_traits>
 #include <utility>
 
 #include "movelist.hpp"
@@ -34,7 +35,59 @@ class movegen {
                            int pieces = PieceGenType::PAWN | PieceGenType::KNIGHT | PieceGenType::BISHOP |
                                         PieceGenType::ROOK | PieceGenType::QUEEN | PieceGenType::KING);
 
+    /**
+     * @brief A move together with an ordering score, filled in by the caller.
+     */
+    struct ScoredMove {
+        Move move;
+        std::int16_t score;
+    };
+
+    /**
+     * @brief Generates all legal moves for a position into a caller provided buffer,
+     * which must have room for constants::MAX_MOVES moves.
+     * @tparam mt
+     * @param board
+     * @param out
+     * @param pieces
+     * @return one past the last written move
+     */
+    template <MoveGenType mt = MoveGenType::ALL>
+    [[nodiscard]] static Move *generate(const Board &board, Move *out,
+                                        int pieces = PieceGenType::PAWN | PieceGenType::KNIGHT |
+                                                     PieceGenType::BISHOP | PieceGenType::ROOK |
+                                                     PieceGenType::QUEEN | PieceGenType::KING);
+
+    /**
+     * @brief Same as generate() but writes {move, 0} pairs, so the moves can be scored
+     * and sorted in the same buffer.
+     * @tparam mt
+     * @param board
+     * @param out
+     * @param pieces
+     * @return one past the last written move
+     */
+    template <MoveGenType mt = MoveGenType::ALL>
+    [[nodiscard]] static ScoredMove *generate(const Board &board, ScoredMove *out,
+                                              int pieces = PieceGenType::PAWN | PieceGenType::KNIGHT |
+                                                           PieceGenType::BISHOP | PieceGenType::ROOK |
+                                                           PieceGenType::QUEEN | PieceGenType::KING);
+
    private:
+    // Appends moves to a raw buffer, used in place of a Movelist by generate().
+    template <typename T>
+    struct MoveWriter {
+        T *end;
+
+        constexpr void add(Move move) noexcept {
+            if constexpr (std::is_same_v<T, Move>) {
+                *end++ = move;
+            } else {
+                *end++ = T{move, 0};
+            }
+        }
+    };
+
     static auto init_squares_between();
     static const std::array<std::array<Bitboard, 64>, 64> SQUARES_BETWEEN_BB;
 
@@ -56,8 +109,8 @@ class movegen {
     [[nodiscard]] static Bitboard seenSquares(const Board &board, Bitboard enemy_empty);
 
     // Generate pawn moves.
-    template <Color::underlying c, MoveGenType mt>
-    static void generatePawnMoves(const Board &board, Movelist &moves, Bitboard pin_d, Bitboard pin_hv,
+    template <Color::underlying c, MoveGenType mt, typename List>
+    static void generatePawnMoves(const Board &board, List &moves, Bitboard pin_d, Bitboard pin_hv,
                                   Bitboard checkmask, Bitboard occ_enemy);
 
     [[nodiscard]] static std::array<Move, 2> generateEPMove(const Board &board, Bitboard checkmask, Bitboard pin_d,
@@ -76,11 +129,11 @@ class movegen {
     template <Color::underlying c, MoveGenType mt>
     [[nodiscard]] static Bitboard generateCastleMoves(const Board &board, Square sq, Bitboard seen, Bitboard pinHV);
 
-    template <typename T>
-    static void whileBitboardAdd(Movelist &movelist, Bitboard mask, T func);
+    template <typename List, typename T>
+    static void whileBitboardAdd(List &movelist, Bitboard mask, T func);
 
-    template <Color::underlying c, MoveGenType mt>
-    static void legalmoves(Movelist &movelist, const Board &board, int pieces);
+    template <Color::underlying c, MoveGenType mt, typename List>
+    static void legalmoves(List &movelist, const Board &board, int pieces);
 
     template <Color::underlying c>
     static bool isEpSquareValid(const Board &board, Square ep);
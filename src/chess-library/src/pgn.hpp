@@ -7,6 +7,7 @@
 #include <optional>
 #include <stdexcept>
 #include <string_view>
+#include <vector>
 
 namespace chess::pgn {
 
@@ -90,6 +91,13 @@ class StreamParser {
 
     StreamParser(std::istream &stream) : stream_buffer(stream) {}
 
+    /**
+     * @brief Parses PGN text that is already in memory, for example a memory mapped
+     * file. The text is read in place without being copied and has to outlive the parser.
+     * @param data
+     */
+    StreamParser(std::string_view data) : stream_buffer(data) {}
+
     void readGames(Visitor &vis) {
         visitor = &vis;
 
@@ -156,10 +164,11 @@ class StreamParser {
     class StreamBuffer {
        private:
         static constexpr std::size_t N = BUFFER_SIZE;
-        using BufferType               = std::array<char, N * N>;
 
        public:
-        StreamBuffer(std::istream &stream) : stream_(stream) {}
+        StreamBuffer(std::istream &stream) : stream_(&stream) {}
+
+        StreamBuffer(std::string_view data) : view_(data) {}
 
         // Get the current character, skip carriage returns
         std::optional<char> some() {
@@ -214,12 +223,29 @@ class StreamParser {
         }
 
         bool fill() {
-            if (!stream_.good()) return false;
+            // In memory text is handed out as a single buffer
+            if (!stream_) {
+                if (view_consumed_) return false;
+
+                view_consumed_ = true;
+                buffer_        = view_.data();
+                buffer_index_  = 0;
+                bytes_read_    = static_cast<std::streamsize>(view_.size());
+
+                return bytes_read_ > 0;
+            }
+
+            if (!stream_->good()) return false;
+
+            if (storage_.empty()) {
+                storage_.resize(N * N);
+                buffer_ = storage_.data();
+            }
 
             buffer_index_ = 0;
 
-            stream_.read(buffer_.data(), N * N);
-            bytes_read_ = stream_.gcount();
+            stream_->read(storage_.data(), N * N);
+            bytes_read_ = stream_->gcount();
 
             return bytes_read_ > 0;
         }
@@ -234,7 +260,7 @@ class StreamParser {
 
         char peek() {
             if (buffer_index_ + 1 >= bytes_read_) {
-                return stream_.peek();
+                return stream_ ? static_cast<char>(stream_->peek()) : '\0';
             }
 
             return buffer_[buffer_index_ + 1];
@@ -249,8 +275,14 @@ class StreamParser {
         }
 
        private:
-        std::istream &stream_;
-        BufferType buffer_;
+        // Either a stream read in blocks of N * N bytes into storage_, or a view
+        std::istream *stream_ = nullptr;
+        std::vector<char> storage_;
+
+        std::string_view view_;
+        bool view_consumed_ = false;
+
+        const char *buffer_ = nullptr;
         std::streamsize bytes_read_   = 0;
         std::streamsize buffer_index_ = 0;
     };
@@ -2,7 +2,8 @@
 
 #include <cassert>
 #include <cctype>
-#include <sstream>
+#include <cstdint>
+#include <ostream>
 #include <stdexcept>
 #include <string>
 #include <string_view>
@@ -16,6 +17,39 @@
 namespace chess {
 class uci {
    public:
+    /**
+     * @brief Longest string the move writers produce, without the null terminator.
+     * A LAN capture promotion with check ("e7xd8=Q+") has 8 characters, every other
+     * SAN, LAN or UCI move is shorter.
+     */
+    static constexpr std::size_t MAX_MOVE_LENGTH = 8;
+
+    /**
+     * @brief Fixed size string holding a single move. Formatting into it never allocates.
+     */
+    class MoveString {
+       public:
+        [[nodiscard]] const char *c_str() const noexcept { return data_; }
+        [[nodiscard]] std::size_t size() const noexcept { return size_; }
+        [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+
+        [[nodiscard]] std::string_view view() const noexcept { return std::string_view(data_, size_); }
+        [[nodiscard]] std::string str() const { return std::string(data_, size_); }
+
+        operator std::string_view() const noexcept { return view(); }
+
+        bool operator==(std::string_view rhs) const noexcept { return view() == rhs; }
+        bool operator!=(std::string_view rhs) const noexcept { return view() != rhs; }
+
+        friend std::ostream &operator<<(std::ostream &os, const MoveString &str) { return os << str.view(); }
+
+       private:
+        friend class uci;
+
+        char data_[MAX_MOVE_LENGTH + 1] = {};
+        std::uint8_t size_              = 0;
+    };
+
     /**
      * @brief Converts an internal move to a UCI string
      * @param move
@@ -23,6 +57,18 @@ class uci {
      * @return
      */
     [[nodiscard]] static std::string moveToUci(const Move &move, bool chess960 = false) noexcept(false) {
+        return formatUci(move, chess960).str();
+    }
+
+    /**
+     * @brief Writes the UCI string of a move into out, which needs room for
+     * MAX_MOVE_LENGTH + 1 characters. The string is null terminated.
+     * @param move
+     * @param out
+     * @param chess960
+     * @return The length of the string
+     */
+    static std::size_t moveToUci(const Move &move, char *out, bool chess960 = false) noexcept {
         // Get the from and to squares
         Square from_sq = move.from();
         Square to_sq   = move.to();
@@ -33,18 +79,28 @@ class uci {
             to_sq = Square(to_sq > from_sq ? File::FILE_G : File::FILE_C, from_sq.rank());
         }
 
-        std::stringstream ss;
+        char *end = writeSquare(from_sq, out);
+        end       = writeSquare(to_sq, end);
 
-        // Add the from and to squares to the string stream
-        ss << from_sq;
-        ss << to_sq;
-
-        // If the move is a promotion, add the promoted piece to the string stream
+        // If the move is a promotion, add the promoted piece
         if (move.typeOf() == Move::PROMOTION) {
-            ss << static_cast<std::string>(move.promotionType());
+            *end++ = PIECE_CHARS[static_cast<int>(move.promotionType())];
         }
 
-        return ss.str();
+        *end = '\0';
+        return static_cast<std::size_t>(end - out);
+    }
+
+    /**
+     * @brief Converts an internal move to a UCI string without allocating
+     * @param move
+     * @param chess960
+     * @return
+     */
+    [[nodiscard]] static MoveString formatUci(const Move &move, bool chess960 = false) noexcept {
+        MoveString str;
+        str.size_ = static_cast<std::uint8_t>(moveToUci(move, str.data_, chess960));
+        return str;
     }
 
     /**
@@ -53,7 +109,7 @@ class uci {
      * @param uci
      * @return
      */
-    [[nodiscard]] static Move uciToMove(const Board &board, const std::string &uci) noexcept(false) {
+    [[nodiscard]] static Move uciToMove(const Board &board, std::string_view uci) noexcept(false) {
         if (uci.length() < 4) {
             return Move::NO_MOVE;
         }
@@ -112,9 +168,7 @@ class uci {
      * @return
      */
     [[nodiscard]] static std::string moveToSan(const Board &board, const Move &move) noexcept(false) {
-        std::string san;
-        moveToRep<false>(board, move, san);
-        return san;
+        return formatSan(board, move).str();
     }
 
     /**
@@ -124,9 +178,54 @@ class uci {
      * @return
      */
     [[nodiscard]] static std::string moveToLan(const Board &board, const Move &move) noexcept(false) {
-        std::string lan;
-        moveToRep<true>(board, move, lan);
-        return lan;
+        return formatLan(board, move).str();
+    }
+
+    /**
+     * @brief Writes the SAN of a legal move into out, which needs room for
+     * MAX_MOVE_LENGTH + 1 characters. The string is null terminated.
+     * @param board
+     * @param move
+     * @param out
+     * @return The length of the string
+     */
+    static std::size_t moveToSan(const Board &board, const Move &move, char *out) noexcept(false) {
+        return moveToRep<false>(board, move, out);
+    }
+
+    /**
+     * @brief Writes the LAN of a legal move into out, see moveToSan.
+     * @param board
+     * @param move
+     * @param out
+     * @return The length of the string
+     */
+    static std::size_t moveToLan(const Board &board, const Move &move, char *out) noexcept(false) {
+        return moveToRep<true>(board, move, out);
+    }
+
+    /**
+     * @brief Converts a move to a SAN string without allocating
+     * @param board
+     * @param move
+     * @return
+     */
+    [[nodiscard]] static MoveString formatSan(const Board &board, const Move &move) noexcept(false) {
+        MoveString str;
+        str.size_ = static_cast<std::uint8_t>(moveToRep<false>(board, move, str.data_));
+        return str;
+    }
+
+    /**
+     * @brief Converts a move to a LAN string without allocating
+     * @param board
+     * @param move
+     * @return
+     */
+    [[nodiscard]] static MoveString formatLan(const Board &board, const Move &move) noexcept(false) {
+        MoveString str;
+        str.size_ = static_cast<std::uint8_t>(moveToRep<true>(board, move, str.data_));
+        return str;
     }
 
     class SanParseError : public std::exception {
@@ -180,6 +279,12 @@ class uci {
         static constexpr auto pt_to_pgt = [](PieceType pt) { return 1 << (pt); };
         const SanMoveInformation info   = parseSanInfo<PEDANTIC>(san);
 
+        // Most moves are found from the destination square alone, the move generation
+        // below only runs for castling, ambiguous and invalid moves
+        if (const Move move = resolveSan(board, info); move != Move::NO_MOVE) {
+            return move;
+        }
+
         if (info.capture) {
             movegen::legalmoves<movegen::MoveGenType::CAPTURE>(moves, board, pt_to_pgt(info.piece));
         } else {
@@ -276,6 +381,133 @@ class uci {
         bool capture = false;
     };
 
+    /**
+     * @brief Finds the move of a parsed san without generating the legal moves. The origin
+     * squares come from reverse attack lookups on the destination square and only these
+     * candidates are checked for legality.
+     * @param board
+     * @param info
+     * @return The move, or NO_MOVE when there is not exactly one legal candidate or the
+     * san needs the full move generation (castling, missing promotion piece, ...)
+     */
+    [[nodiscard]] static Move resolveSan(const Board &board, const SanMoveInformation &info) noexcept {
+        if (info.castling_short || info.castling_long) return Move::NO_MOVE;
+        if (info.piece == PieceType::NONE || !info.to.is_valid()) return Move::NO_MOVE;
+
+        const Color us      = board.sideToMove();
+        const Square to     = info.to;
+        const Piece target  = board.at(to);
+        const bool is_pawn  = info.piece == PieceType::PAWN;
+        const bool is_ep    = is_pawn && info.capture && target == Piece::NONE && to == board.enpassantSq();
+        const Bitboard own  = board.pieces(info.piece, us);
+        const Bitboard occ  = board.occ();
+
+        // The capture sign has to agree with the destination, like in the move generation
+        if (target != Piece::NONE && target.color() == us) return Move::NO_MOVE;
+        if (info.capture != (target != Piece::NONE || is_ep)) return Move::NO_MOVE;
+
+        // Promotions need the promotion piece and only happen on the last rank
+        const Rank relative_rank = to.relative_square(us).rank();
+        if (is_pawn && (relative_rank == Rank::RANK_8) != (info.promotion != PieceType::NONE)) {
+            return Move::NO_MOVE;
+        }
+
+        Bitboard from_bb;
+
+        if (is_pawn && info.capture) {
+            from_bb = attacks::pawn(~us, to) & own;
+        } else if (is_pawn) {
+            if (relative_rank == Rank::RANK_1 || relative_rank == Rank::RANK_2) return Move::NO_MOVE;
+
+            const auto down    = make_direction(Direction::SOUTH, us);
+            const Square one   = to + down;
+            const Bitboard one_bb = Bitboard::fromSquare(one);
+
+            if (own & one_bb) {
+                from_bb = one_bb;
+            } else if (relative_rank == Rank::RANK_4 && !(occ & one_bb)) {
+                from_bb = own & Bitboard::fromSquare(one + down);
+            }
+        } else {
+            from_bb = pieceOrigins(board, info.piece, to);
+        }
+
+        if (info.from_file != File::NO_FILE) from_bb &= Bitboard(info.from_file);
+        if (info.from_rank != Rank::NO_RANK) from_bb &= Bitboard(info.from_rank);
+
+        const Square captured = is_ep ? to.ep_square() : to;
+        Move found            = Move::NO_MOVE;
+
+        while (from_bb) {
+            const Square from = from_bb.pop();
+
+            if (!leavesKingSafe(board, from, to, captured)) continue;
+
+            // Ambiguous, the move generation reports it
+            if (found != Move::NO_MOVE) return Move::NO_MOVE;
+
+            if (info.promotion != PieceType::NONE) {
+                found = Move::make<Move::PROMOTION>(from, to, info.promotion);
+            } else if (is_ep) {
+                found = Move::make<Move::ENPASSANT>(from, to);
+            } else {
+                found = Move::make(from, to);
+            }
+        }
+
+        return found;
+    }
+
+    /**
+     * @brief Squares of the pieces of the side to move with the given type, other than
+     * pawns, that attack the square. Legality is not checked.
+     * @param board
+     * @param pt
+     * @param to
+     * @return
+     */
+    [[nodiscard]] static Bitboard pieceOrigins(const Board &board, PieceType pt, Square to) noexcept {
+        const Bitboard own = board.pieces(pt, board.sideToMove());
+        const Bitboard occ = board.occ();
+
+        if (pt == PieceType::KNIGHT) return attacks::knight(to) & own;
+        if (pt == PieceType::BISHOP) return attacks::bishop(to, occ) & own;
+        if (pt == PieceType::ROOK) return attacks::rook(to, occ) & own;
+        if (pt == PieceType::QUEEN) return attacks::queen(to, occ) & own;
+        return attacks::king(to) & own;
+    }
+
+    /**
+     * @brief Checks if moving the piece on from to to (taking the piece on captured) leaves
+     * the own king out of check. Castling is not handled.
+     * @param board
+     * @param from
+     * @param to
+     * @param captured to, or the pawn square of an en passant capture
+     * @return
+     */
+    [[nodiscard]] static bool leavesKingSafe(const Board &board, Square from, Square to, Square captured) noexcept {
+        const Color us   = board.sideToMove();
+        const Color them = ~us;
+
+        const Square king_sq       = board.at(from).type() == PieceType::KING ? to : board.kingSq(us);
+        const Bitboard captured_bb = Bitboard::fromSquare(captured);
+        const Bitboard occ = (board.occ() & ~Bitboard::fromSquare(from) & ~captured_bb) | Bitboard::fromSquare(to);
+        const Bitboard enemies = board.us(them) & ~captured_bb;
+
+        const Bitboard queens  = board.pieces(PieceType::QUEEN, them);
+        const Bitboard bishops = board.pieces(PieceType::BISHOP, them) | queens;
+        const Bitboard rooks   = board.pieces(PieceType::ROOK, them) | queens;
+
+        const Bitboard attackers = (attacks::pawn(us, king_sq) & board.pieces(PieceType::PAWN, them)) |
+                                   (attacks::knight(king_sq) & board.pieces(PieceType::KNIGHT, them)) |
+                                   (attacks::bishop(king_sq, occ) & bishops) |
+                                   (attacks::rook(king_sq, occ) & rooks) |
+                                   (attacks::king(king_sq) & board.pieces(PieceType::KING, them));
+
+        return !(attackers & enemies);
+    }
+
     template <bool PEDANTIC = false>
     [[nodiscard]] static SanMoveInformation parseSanInfo(std::string_view san) noexcept(false) {
 #ifndef CHESS_NO_EXCEPTIONS
@@ -387,137 +619,115 @@ class uci {
         return info;
     }
 
+    static constexpr char PIECE_CHARS[] = "pnbrqk";
+
     template <bool LAN = false>
-    static void moveToRep(Board board, const Move &move, std::string &str) {
-        if (handleCastling(move, str)) {
-            return;
-        }
+    static std::size_t moveToRep(const Board &board, const Move &move, char *out) {
+        char *end = out;
 
-        const PieceType pt   = board.at(move.from()).type();
-        const bool isCapture = board.at(move.to()) != Piece::NONE || move.typeOf() == Move::ENPASSANT;
+        if (move.typeOf() == Move::CASTLING) {
+            const std::string_view castling = move.to() > move.from() ? "O-O" : "O-O-O";
+            for (const char c : castling) *end++ = c;
+        } else {
+            const PieceType pt   = board.at(move.from()).type();
+            const bool isCapture = board.at(move.to()) != Piece::NONE || move.typeOf() == Move::ENPASSANT;
 
-        assert(pt != PieceType::NONE);
+            assert(pt != PieceType::NONE);
 
-        if (pt != PieceType::PAWN) {
-            appendPieceSymbol(pt, str);
-        }
+            if (pt != PieceType::PAWN) {
+                *end++ = pieceSymbol(pt);
+            }
 
-        if constexpr (LAN) {
-            appendSquare(move.from(), str);
-        } else {
-            if (pt == PieceType::PAWN) {
-                str += isCapture ? static_cast<std::string>(move.from().file()) : "";
+            if constexpr (LAN) {
+                end = writeSquare(move.from(), end);
             } else {
-                resolveAmbiguity(board, move, pt, str);
+                if (pt == PieceType::PAWN) {
+                    if (isCapture) *end++ = fileChar(move.from());
+                } else {
+                    end = resolveAmbiguity(board, move, pt, end);
+                }
             }
-        }
 
-        if (isCapture) {
-            str += 'x';
-        }
+            if (isCapture) {
+                *end++ = 'x';
+            }
 
-        appendSquare(move.to(), str);
+            end = writeSquare(move.to(), end);
 
-        if (move.typeOf() == Move::PROMOTION) appendPromotion(move, str);
+            if (move.typeOf() == Move::PROMOTION) {
+                *end++ = '=';
+                *end++ = pieceSymbol(move.promotionType());
+            }
+        }
 
-        board.makeMove(move);
+        if (board.givesCheck(move)) {
+            *end++ = isMate(board, move) ? '#' : '+';
+        }
 
-        if (board.inCheck()) appendCheckSymbol(board, str);
+        *end = '\0';
+        return static_cast<std::size_t>(end - out);
     }
 
-    static bool handleCastling(const Move &move, std::string &str) {
-        if (move.typeOf() != Move::CASTLING) return false;
-
-        str = (move.to().file() > move.from().file()) ? "O-O" : "O-O-O";
-        return true;
+    static char pieceSymbol(PieceType pieceType) noexcept {
+        return static_cast<char>(PIECE_CHARS[static_cast<int>(pieceType)] - 'a' + 'A');
     }
 
-    static void appendPieceSymbol(PieceType pieceType, std::string &str) {
-        str += std::toupper(static_cast<std::string>(pieceType)[0]);
-    }
+    static char fileChar(Square square) noexcept { return static_cast<char>('a' + (square.index() & 7)); }
 
-    static void appendSquare(Square square, std::string &str) {
-        str += static_cast<std::string>(square.file());
-        str += static_cast<std::string>(square.rank());
-    }
+    static char rankChar(Square square) noexcept { return static_cast<char>('1' + (square.index() >> 3)); }
 
-    static void appendPromotion(const Move &move, std::string &str) {
-        str += '=';
-        str += std::toupper(static_cast<std::string>(move.promotionType())[0]);
+    static char *writeSquare(Square square, char *out) noexcept {
+        *out++ = fileChar(square);
+        *out++ = rankChar(square);
+        return out;
     }
 
-    static void appendCheckSymbol(Board &board, std::string &str) {
-        const auto gameState = board.isGameOver().second;
-        str += (gameState == GameResult::LOSE) ? '#' : '+';
-    }
+    // Only checking moves need the full board, the copy goes into a board that is
+    // reused by the thread so it does not allocate once it has grown
+    static bool isMate(const Board &board, const Move &move) {
+        thread_local Board scratch;
+        scratch = board;
+        scratch.makeMove(move);
 
-    static void resolveAmbiguity(const Board &board, const Move &move, PieceType pieceType, std::string &str) {
         Movelist moves;
-        movegen::legalmoves(moves, board, 1 << pieceType);
-
-        bool needFile         = false;
-        bool needRank         = false;
-        bool hasAmbiguousMove = false;
-
-        for (const auto &m : moves) {
-            if (m != move && m.to() == move.to()) {
-                hasAmbiguousMove = true;
+        movegen::legalmoves(moves, scratch);
+        return moves.empty();
+    }
 
-                /*
-                First, if the moving pieces can be distinguished by their originating files, the originating
-                file letter of the moving piece is inserted immediately after the moving piece letter.
+    static char *resolveAmbiguity(const Board &board, const Move &move, PieceType pieceType, char *out) {
+        /*
+        First, if the moving pieces can be distinguished by their originating files, the originating
+        file letter of the moving piece is inserted immediately after the moving piece letter.
 
-                Second (when the first step fails), if the moving pieces can be distinguished by their
-                originating ranks, the originating rank digit of the moving piece is inserted immediately after
-                the moving piece letter.
+        Second (when the first step fails), if the moving pieces can be distinguished by their
+        originating ranks, the originating rank digit of the moving piece is inserted immediately after
+        the moving piece letter.
 
-                Third (when both the first and the second steps fail), the two character square coordinate of
-                the originating square of the moving piece is inserted immediately after the moving piece
-                letter.
-                */
+        Third (when both the first and the second steps fail), the two character square coordinate of
+        the originating square of the moving piece is inserted immediately after the moving piece
+        letter.
+        */
 
-                if (isIdentifiableByType(moves, move, move.from().file())) {
-                    needFile = true;
-                    break;
-                }
+        // Other pieces of the same type that can legally move to the same square
+        Bitboard candidates = pieceOrigins(board, pieceType, move.to()) & ~Bitboard::fromSquare(move.from());
+        Bitboard rivals;
 
-                if (isIdentifiableByType(moves, move, move.from().rank())) {
-                    needRank = true;
-                    break;
-                }
-            }
+        while (candidates) {
+            const Square from = candidates.pop();
+            if (leavesKingSafe(board, from, move.to(), move.to())) rivals |= Bitboard::fromSquare(from);
         }
 
-        if (needFile) str += static_cast<std::string>(move.from().file());
-        if (needRank) str += static_cast<std::string>(move.from().rank());
-
-        // we weren't able to disambiguate the move by either file or rank, so we need to use both
-        if (hasAmbiguousMove && !needFile && !needRank) {
-            appendSquare(move.from(), str);
-        }
-    }
+        if (!rivals) return out;
 
-    template <typename CoordinateType>
-    static bool isIdentifiableByType(const Movelist &moves, const Move move, CoordinateType type) {
-        static_assert(std::is_same_v<CoordinateType, File> || std::is_same_v<CoordinateType, Rank>,
-                      "CoordinateType must be either File or Rank");
-
-        for (const auto &m : moves) {
-            if (m == move || m.to() != move.to()) {
-                continue;
-            }
-
-            // file
-            if constexpr (std::is_same_v<CoordinateType, File>) {
-                if (type == m.from().file()) return false;
-            }
-            // rank
-            else {
-                if (type == m.from().rank()) return false;
-            }
+        if (!(rivals & Bitboard(move.from().file()))) {
+            *out++ = fileChar(move.from());
+        } else if (!(rivals & Bitboard(move.from().rank()))) {
+            *out++ = rankChar(move.from());
+        } else {
+            out = writeSquare(move.from(), out);
         }
 
-        return true;
+        return out;
     }
 };
 }  // namespace chess
@@ -0,0 +1,218 @@
+#include <signal.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "./engine/engine.hpp"
+#include "./engine/pbin.hpp"
+#include "./play/openings.hpp"
+
+/*
+ * Training data generator
+ *
+ * Plays fixed-node self-play games from random openings and records the
+ * quiet positions with their search score, best move and the final result.
+ * Every worker thread writes its own .pbin shard, so the workers never wait
+ * for each other.
+ */
+
+struct DatagenConfig {
+  int games = 1000;
+  int concurrency = 1;
+  int nodes = 5000;      // Node limit per move
+  int maxMoves = 400;    // Max plies before declaring draw
+  int randomPlies = 8;   // Random opening plies, every other game plays one more
+  uint64_t seed = 0;
+  std::string output = "datagen";  // Shards are <output>_<thread>.pbin
+};
+
+std::atomic<bool> g_stopRequested{false};
+
+void signalHandler(int) { g_stopRequested = true; }
+
+struct DatagenStats {
+  std::mutex mutex;
+  int games = 0;
+  int64_t positions = 0;
+};
+
+// Plays one game and packs its quiet positions into records right away,
+// the result of the records is filled in by the caller. Returns false when
+// the game was interrupted.
+bool playGame(Engine& engine, const std::string& openingFen,
+              const DatagenConfig& config, std::vector<PbinRecord>& positions,
+              PbinResult& result) {
+  engine.setPosition(openingFen);
+  Board board(openingFen);
+  positions.clear();
+
+  for (int ply = 0;; ply++) {
+    if (g_stopRequested) return false;
+
+    auto [reason, outcome] = board.isGameOver();
+    if (outcome != GameResult::NONE) {
+      if (outcome == GameResult::LOSE) {
+        result = board.sideToMove() == Color::WHITE ? PbinResult::BLACK_WIN
+                                                    : PbinResult::WHITE_WIN;
+      } else {
+        result = PbinResult::DRAW;
+      }
+      return true;
+    }
+
+    if (ply >= config.maxMoves) {
+      result = PbinResult::DRAW;
+      return true;
+    }
+
+    SearchResult search = engine.searchNodes(config.nodes);
+    if (search.bestMove == Move::NO_MOVE) return false;
+
+    // Only quiet positions are useful for training a static evaluation
+    if (!board.inCheck() && !board.isCapture(search.bestMove)) {
+      // Mate scores donot fit, they are stored as a large win or loss
+      positions.push_back(PbinRecord::fromBoard(board, search.score,
+                                                search.bestMove,
+                                                PbinResult::DRAW));
+    }
+
+    board.makeMove(search.bestMove);
+    engine.makeMove(search.bestMove);
+  }
+}
+
+void runWorker(const DatagenConfig& config, int thread,
+               std::atomic<int>& nextGame, DatagenStats& stats) {
+  PbinWriter writer(config.output + "_" + std::to_string(thread) + ".pbin");
+  if (!writer.isOpen()) {
+    std::cerr << "Failed to open the output of thread " << thread << std::endl;
+    return;
+  }
+
+  Engine engine;
+  engine.setPrintInfo(false);
+
+  std::vector<PbinRecord> positions;
+
+  while (!g_stopRequested) {
+    int index = nextGame.fetch_add(1);
+    if (index >= config.games) break;
+
+    // An odd number of plies every other game, so both colors get to move
+    // first after the opening
+    std::string openingFen = randomOpening(config.randomPlies + (index & 1),
+                                           config.seed + index);
+
+    PbinResult result;
+    if (!playGame(engine, openingFen, config, positions, result)) continue;
+
+    // The result is only known at the end, so the game is written at once
+    for (auto& position : positions) position.result = result;
+    writer.write(positions.data(), positions.size());
+
+    std::lock_guard<std::mutex> lock(stats.mutex);
+    stats.games++;
+    stats.positions += static_cast<int64_t>(positions.size());
+    if (stats.games % 100 == 0) {
+      std::cout << "Games " << stats.games << ", positions " << stats.positions
+                << std::endl;
+    }
+  }
+
+  writer.flush();
+}
+
+void printUsage() {
+  std::cout << "Usage: pawnstar-datagen [options]\n"
+            << "  --games N         games to play (default 1000)\n"
+            << "  --concurrency N   worker threads (default 1)\n"
+            << "  --nodes N         nodes per move (default 5000)\n"
+            << "  --max-moves N     plies before a game is drawn (default 400)\n"
+            << "  --random-plies N  random opening plies (default 8)\n"
+            << "  --seed N          seed for the random openings\n"
+            << "  --output PREFIX   shards are PREFIX_<thread>.pbin "
+               "(default datagen)\n";
+}
+
+bool parseArgs(int argc, char* argv[], DatagenConfig& config) {
+  config.seed = static_cast<uint64_t>(
+      std::chrono::steady_clock::now().time_since_epoch().count());
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (i + 1 >= argc) return false;
+    std::string value = argv[++i];
+
+    if (arg == "--games") {
+      config.games = std::stoi(value);
+    } else if (arg == "--concurrency") {
+      config.concurrency = std::max(1, std::stoi(value));
+    } else if (arg == "--nodes") {
+      config.nodes = std::stoi(value);
+    } else if (arg == "--max-moves") {
+      config.maxMoves = std::stoi(value);
+    } else if (arg == "--random-plies") {
+      config.randomPlies = std::stoi(value);
+    } else if (arg == "--seed") {
+      config.seed = std::stoull(value);
+    } else if (arg == "--output") {
+      config.output = value;
+    } else {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+int main(int argc, char* argv[]) {
+  DatagenConfig config;
+
+  try {
+    if (!parseArgs(argc, argv, config)) {
+      printUsage();
+      return 1;
+    }
+  } catch (const std::exception&) {
+    printUsage();
+    return 1;
+  }
+
+  // Stop after the running games, everything written so far is kept
+  signal(SIGINT, signalHandler);
+  signal(SIGTERM, signalHandler);
+
+  std::cout << "Generating " << config.games << " games at " << config.nodes
+            << " nodes per move on " << config.concurrency
+            << " thread(s), seed " << config.seed << std::endl;
+
+  auto start = std::chrono::steady_clock::now();
+
+  std::atomic<int> nextGame{0};
+  DatagenStats stats;
+  std::vector<std::thread> workers;
+  for (int i = 0; i < config.concurrency; ++i) {
+    workers.emplace_back(runWorker, std::cref(config), i, std::ref(nextGame),
+                         std::ref(stats));
+  }
+  for (auto& worker : workers) worker.join();
+
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  std::cout << "Played " << stats.games << " games, " << stats.positions
+            << " positions in " << seconds << "s ("
+            << static_cast<int64_t>(stats.positions * 3600.0 /
+                                    std::max(seconds, 1e-3))
+            << " positions/hour)" << std::endl;
+
+  return 0;
+}
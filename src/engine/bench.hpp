@@ -0,0 +1,26 @@
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Result of a bench run. The node count only changes when the search does,
+// so it works as a signature of the search behaviour.
+struct BenchResult {
+  uint64_t nodes = 0;
+  uint64_t milliseconds = 0;
+  uint64_t nps = 0;
+};
+
+// Searches the built-in positions to `depth`, every position with a fresh
+// engine and transposition table of `hashMb` megabytes. The search itself
+// is single threaded, `threads` engines work through the positions in
+// parallel, which leaves the node count unchanged.
+BenchResult runBench(int depth = 4, int threads = 1, size_t hashMb = 16);
+
+// The bench positions as FENs, also used as a corpus by the microbenchmarks
+const std::vector<std::string>& benchPositions();
+
+#endif
@@ -0,0 +1,385 @@
+#include "bitbase-gen.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace {
+
+enum GenResult : uint8_t { GEN_UNKNOWN, GEN_WIN, GEN_LOSS, GEN_DRAW, GEN_INVALID };
+
+constexpr uint16_t UNDECIDED = 0xFFFF;
+constexpr int CAPTURED = -1;
+
+const PieceType PROMOTIONS[4] = {PieceType::QUEEN, PieceType::ROOK,
+                                 PieceType::BISHOP, PieceType::KNIGHT};
+
+// Runs work(index) for all indices below count on the given number of threads
+template <typename Work>
+void parallelFor(int threads, uint64_t count, const Work& work) {
+  constexpr uint64_t CHUNK = 1 << 16;
+  std::atomic<uint64_t> next{0};
+
+  auto worker = [&]() {
+    for (;;) {
+      uint64_t begin = next.fetch_add(CHUNK);
+      if (begin >= count) return;
+      uint64_t end = std::min(count, begin + CHUNK);
+      for (uint64_t index = begin; index < end; index++) work(index);
+    }
+  };
+
+  std::vector<std::thread> pool;
+  for (int i = 1; i < threads; i++) pool.emplace_back(worker);
+  worker();
+  for (auto& thread : pool) thread.join();
+}
+
+Bitboard pieceAttacks(Piece piece, int sq, Bitboard occupied) {
+  switch (static_cast<int>(piece.type())) {
+    case static_cast<int>(PieceType::PAWN):
+      return attacks::pawn(piece.color(), sq);
+    case static_cast<int>(PieceType::KNIGHT):
+      return attacks::knight(sq);
+    case static_cast<int>(PieceType::BISHOP):
+      return attacks::bishop(sq, occupied);
+    case static_cast<int>(PieceType::ROOK):
+      return attacks::rook(sq, occupied);
+    case static_cast<int>(PieceType::QUEEN):
+      return attacks::queen(sq, occupied);
+    default:
+      return attacks::king(sq);
+  }
+}
+
+// A position of the table being solved, captured pieces are on CAPTURED
+struct GenPosition {
+  const EndgameMaterial* material;
+  int squares[MAX_BITBASE_PIECES] = {};
+  Color stm;
+
+  GenPosition(const EndgameMaterial& material, uint64_t index)
+      : material(&material) {
+    for (int i = 0; i < material.count; i++) {
+      squares[i] = static_cast<int>((index >> (6 * i)) & 63);
+    }
+    stm = static_cast<int>(index >> (6 * material.count)) ? Color::BLACK
+                                                          : Color::WHITE;
+  }
+
+  uint64_t index() const {
+    uint64_t index = static_cast<uint64_t>(static_cast<int>(stm))
+                     << (6 * material->count);
+    for (int i = 0; i < material->count; i++) {
+      index |= static_cast<uint64_t>(squares[i]) << (6 * i);
+    }
+    return index;
+  }
+
+  Bitboard occupied(Color color) const {
+    Bitboard occupied;
+    for (int i = 0; i < material->count; i++) {
+      if (squares[i] != CAPTURED && material->pieces[i].color() == color) {
+        occupied |= Bitboard::fromSquare(squares[i]);
+      }
+    }
+    return occupied;
+  }
+
+  // Canonical order puts the white king first and the black king first of
+  // the black pieces
+  int kingSquare(Color color) const {
+    if (color == Color::WHITE) return squares[0];
+    int king = 1;
+    while (material->pieces[king].color() == Color::WHITE) king++;
+    return squares[king];
+  }
+
+  bool isAttacked(int target, Color by) const {
+    Bitboard occupied = this->occupied(Color::WHITE) | this->occupied(Color::BLACK);
+    for (int i = 0; i < material->count; i++) {
+      Piece piece = material->pieces[i];
+      if (squares[i] == CAPTURED || piece.color() != by) continue;
+      if (pieceAttacks(piece, squares[i], occupied).check(target)) return true;
+    }
+    return false;
+  }
+
+  // Squares overlap, a pawn on the first or last rank or the side that just
+  // moved left its king in check
+  bool isInvalid() const {
+    Bitboard occupied;
+    for (int i = 0; i < material->count; i++) {
+      if (occupied.check(squares[i])) return true;
+      occupied |= Bitboard::fromSquare(squares[i]);
+
+      int rank = squares[i] >> 3;
+      if (material->pieces[i].type() == PieceType::PAWN && (rank == 0 || rank == 7)) {
+        return true;
+      }
+    }
+    return isAttacked(kingSquare(~stm), stm);
+  }
+
+  // The same position outside of the table, with the captured piece removed
+  // and the promoted pawn replaced
+  EndgamePosition toEndgame(int promoted, PieceType promotion) const {
+    EndgamePosition position;
+    position.stm = stm;
+    for (int i = 0; i < material->count; i++) {
+      if (squares[i] == CAPTURED) continue;
+      Piece piece = material->pieces[i];
+      position.pieces[position.count] =
+          i == promoted ? Piece(promotion, piece.color()) : piece;
+      position.squares[position.count] = Square(squares[i]);
+      position.count++;
+    }
+    return position;
+  }
+};
+
+// Targets of the moves of piece i that do not leave the own king in check
+template <typename Visit>
+void forEachMove(const GenPosition& position, int i, const Visit& visit) {
+  const EndgameMaterial& material = *position.material;
+  Piece piece = material.pieces[i];
+  int from = position.squares[i];
+  Bitboard ours = position.occupied(piece.color());
+  Bitboard theirs = position.occupied(~piece.color());
+  Bitboard occupied = ours | theirs;
+
+  Bitboard targets;
+  if (piece.type() == PieceType::PAWN) {
+    int forward = piece.color() == Color::WHITE ? 8 : -8;
+    int startRank = piece.color() == Color::WHITE ? 1 : 6;
+    targets = attacks::pawn(piece.color(), from) & theirs;
+    if (!occupied.check(from + forward)) {
+      targets |= Bitboard::fromSquare(from + forward);
+      if ((from >> 3) == startRank && !occupied.check(from + 2 * forward)) {
+        targets |= Bitboard::fromSquare(from + 2 * forward);
+      }
+    }
+  } else {
+    targets = pieceAttacks(piece, from, occupied) & ~ours;
+  }
+
+  while (targets) {
+    int to = targets.pop();
+
+    GenPosition child = position;
+    int captured = CAPTURED;
+    for (int j = 0; j < material.count; j++) {
+      if (child.squares[j] == to) {
+        captured = j;
+        child.squares[j] = CAPTURED;
+      }
+    }
+    child.squares[i] = to;
+
+    int king = piece.type() == PieceType::KING ? to : child.kingSquare(piece.color());
+    if (child.isAttacked(king, ~piece.color())) continue;
+
+    child.stm = ~position.stm;
+    visit(child, captured);
+  }
+}
+
+}  // namespace
+
+BitbaseGenerator::BitbaseGenerator(int threads) : threads(std::max(1, threads)) {}
+
+bool BitbaseGenerator::generate(std::string_view name) {
+  EndgameMaterial material;
+  if (!EndgameMaterial::parse(name, material)) return false;
+  if (material.count > 2) solve(material);
+  return true;
+}
+
+Wdl BitbaseGenerator::probeSolved(const EndgamePosition& position) const {
+  if (position.count == 2) return Wdl::DRAW;
+
+  EndgameMaterial material;
+  uint64_t index;
+  position.canonicalize(material, index);
+  return getWdl(solved.at(material.name()).data(), index);
+}
+
+void BitbaseGenerator::solve(const EndgameMaterial& material) {
+  if (solved.count(material.name())) return;
+
+  // Endings reached by a capture or a promotion are solved first
+  for (int i = 0; i < material.count; i++) {
+    PieceType type = material.pieces[i].type();
+    if (type == PieceType::KING) continue;
+
+    EndgamePosition smaller;
+    for (int j = 0; j < material.count; j++) {
+      smaller.pieces[j] = material.pieces[j];
+      smaller.squares[j] = Square(j);
+    }
+    smaller.count = material.count;
+
+    EndgameMaterial next;
+    uint64_t index;
+    if (type == PieceType::PAWN) {
+      for (PieceType promotion : PROMOTIONS) {
+        smaller.pieces[i] = Piece(promotion, material.pieces[i].color());
+        smaller.canonicalize(next, index);
+        solve(next);
+      }
+    }
+
+    // Without piece i
+    std::copy(material.pieces + i + 1, material.pieces + material.count,
+              smaller.pieces + i);
+    smaller.count = material.count - 1;
+    smaller.canonicalize(next, index);
+    if (next.count > 2) solve(next);
+  }
+
+  uint64_t entries = material.entries();
+  std::vector<std::atomic<uint8_t>> result(entries);
+  std::vector<std::atomic<uint8_t>> moves(entries);  // Not yet refuted
+  std::vector<std::atomic<uint16_t>> ply(entries);
+
+  // Mates, stalemates and moves out of the table
+  parallelFor(threads, entries, [&](uint64_t index) {
+    GenPosition position(material, index);
+    ply[index].store(UNDECIDED, std::memory_order_relaxed);
+
+    if (position.isInvalid()) {
+      result[index].store(GEN_INVALID, std::memory_order_relaxed);
+      return;
+    }
+
+    int legal = 0;
+    int inTable = 0;
+    bool win = false;
+    bool drawExit = false;
+
+    auto exit = [&](Wdl wdl) {
+      if (wdl == Wdl::LOSS) win = true;
+      if (wdl == Wdl::DRAW) drawExit = true;
+    };
+
+    for (int i = 0; i < material.count; i++) {
+      if (material.pieces[i].color() != position.stm) continue;
+
+      bool pawn = material.pieces[i].type() == PieceType::PAWN;
+      forEachMove(position, i, [&](const GenPosition& child, int captured) {
+        legal++;
+
+        int rank = child.squares[i] >> 3;
+        if (pawn && (rank == 0 || rank == 7)) {
+          for (PieceType promotion : PROMOTIONS) {
+            exit(probeSolved(child.toEndgame(i, promotion)));
+          }
+        } else if (captured != CAPTURED) {
+          exit(probeSolved(child.toEndgame(CAPTURED, PieceType::NONE)));
+        } else {
+          inTable++;
+        }
+      });
+    }
+
+    uint8_t state = GEN_UNKNOWN;
+    if (win) {
+      state = GEN_WIN;
+    } else if (legal == 0) {
+      bool inCheck =
+          position.isAttacked(position.kingSquare(position.stm), ~position.stm);
+      state = inCheck ? GEN_LOSS : GEN_DRAW;
+    } else if (inTable == 0) {
+      state = drawExit ? GEN_DRAW : GEN_LOSS;
+    }
+
+    // A drawing move out of the table is never refuted
+    moves[index].store(static_cast<uint8_t>(inTable + (drawExit ? 1 : 0)),
+                       std::memory_order_relaxed);
+    result[index].store(state, std::memory_order_relaxed);
+    if (state == GEN_WIN || state == GEN_LOSS) {
+      ply[index].store(0, std::memory_order_relaxed);
+    }
+  });
+
+  // Walk back from the positions resolved in the last pass
+  for (uint16_t pass = 1;; pass++) {
+    std::atomic<bool> changed{false};
+
+    parallelFor(threads, entries, [&](uint64_t index) {
+      if (ply[index].load(std::memory_order_relaxed) != pass - 1) return;
+
+      GenPosition position(material, index);
+      bool lost = result[index].load(std::memory_order_relaxed) == GEN_LOSS;
+      Color mover = ~position.stm;
+      Bitboard occupied =
+          position.occupied(Color::WHITE) | position.occupied(Color::BLACK);
+
+      for (int i = 0; i < material.count; i++) {
+        Piece piece = material.pieces[i];
+        if (piece.color() != mover) continue;
+
+        int to = position.squares[i];
+        Bitboard origins;
+        if (piece.type() == PieceType::PAWN) {
+          int back = piece.color() == Color::WHITE ? -8 : 8;
+          int doubleRank = piece.color() == Color::WHITE ? 3 : 4;
+          int from = to + back;
+          if (!occupied.check(from) && (from >> 3) != 0 && (from >> 3) != 7) {
+            origins |= Bitboard::fromSquare(from);
+            if ((to >> 3) == doubleRank && !occupied.check(from + back)) {
+              origins |= Bitboard::fromSquare(from + back);
+            }
+          }
+        } else {
+          origins = pieceAttacks(piece, to, occupied) & ~occupied;
+        }
+
+        while (origins) {
+          GenPosition parent = position;
+          parent.squares[i] = origins.pop();
+          parent.stm = mover;
+          uint64_t parentIndex = parent.index();
+
+          uint8_t unknown = GEN_UNKNOWN;
+          if (result[parentIndex].load(std::memory_order_relaxed) != GEN_UNKNOWN) {
+            continue;
+          }
+
+          bool decided = false;
+          if (lost) {
+            decided = result[parentIndex].compare_exchange_strong(unknown, GEN_WIN);
+          } else if (moves[parentIndex].fetch_sub(1) == 1) {
+            decided = result[parentIndex].compare_exchange_strong(unknown, GEN_LOSS);
+          }
+
+          if (decided) {
+            ply[parentIndex].store(pass, std::memory_order_relaxed);
+            changed.store(true, std::memory_order_relaxed);
+          }
+        }
+      }
+    });
+
+    if (!changed) break;
+  }
+
+  std::vector<uint8_t> packed((entries + 3) / 4);
+  for (uint64_t index = 0; index < entries; index++) {
+    switch (result[index].load(std::memory_order_relaxed)) {
+      case GEN_WIN:
+        setWdl(packed.data(), index, Wdl::WIN);
+        break;
+      case GEN_LOSS:
+        setWdl(packed.data(), index, Wdl::LOSS);
+        break;
+      case GEN_INVALID:
+        setWdl(packed.data(), index, Wdl::INVALID);
+        break;
+      default:
+        break;  // Unknown positions are draws
+    }
+  }
+
+  solved[material.name()] = std::move(packed);
+}
@@ -0,0 +1,49 @@
+#ifndef BITBASE_GEN_HPP
+#define BITBASE_GEN_HPP
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bitbase.hpp"
+
+/*
+ * Retrograde bitbase generator
+ *
+ * Solves an ending of up to four pieces by retrograde analysis. All
+ * positions are set up first: mates and moves that capture or promote into
+ * an already solved smaller ending are resolved right away. Every pass then
+ * walks back one move from the positions resolved by the last pass, a
+ * position wins if one move reaches a lost position and loses once all of
+ * its moves reach won ones. What is left when a pass resolves nothing is a
+ * draw. Passes are split over the threads by index ranges.
+ *
+ * En passant captures are not generated, no position of the tables has an
+ * en passant square.
+ */
+class BitbaseGenerator {
+ private:
+  int threads;
+  std::map<std::string, std::vector<uint8_t>> solved;  // By canonical name
+
+  void solve(const EndgameMaterial& material);
+
+  // Result of a position of an ending solved before, KvK is a draw
+  Wdl probeSolved(const EndgamePosition& position) const;
+
+ public:
+  explicit BitbaseGenerator(int threads = 1);
+
+  // Solves the ending and every ending it turns into by captures and
+  // promotions, false if the name is not a valid ending
+  bool generate(std::string_view name);
+
+  // Results of all solved endings, two bits per position like .pbb files
+  const std::map<std::string, std::vector<uint8_t>>& getResults() const {
+    return solved;
+  }
+};
+
+#endif
@@ -0,0 +1,308 @@
+#include "bitbase.hpp"
+
+#include <algorithm>
+#include <bitset>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace {
+
+/*
+ * KPK with white having the pawn on one of the files a-d, the other files
+ * are mirrored. Positions are solved by iterating over all of them until
+ * nothing changes: white wins if one move reaches a win, black draws if one
+ * move reaches a draw. A pawn that promotes safely counts as a win.
+ */
+constexpr int KPK_ENTRIES = 2 * 24 * 64 * 64;
+
+// Results are bits, so the results of all moves can be or-ed together
+enum KpkResult : uint8_t {
+  KPK_INVALID = 0,
+  KPK_UNKNOWN = 1,
+  KPK_DRAW = 2,
+  KPK_WIN = 4
+};
+
+int kpkIndex(int stm, int blackKing, int whiteKing, int pawn) {
+  return whiteKing | (blackKing << 6) | (stm << 12) | ((pawn & 7) << 13) |
+         ((6 - (pawn >> 3)) << 15);
+}
+
+struct KpkPosition {
+  int stm;
+  int king[2];
+  int pawn;
+  uint8_t result;
+
+  explicit KpkPosition(int index) {
+    king[0] = index & 0x3F;
+    king[1] = (index >> 6) & 0x3F;
+    stm = (index >> 12) & 1;
+    pawn = ((index >> 13) & 3) + 8 * (6 - ((index >> 15) & 7));
+
+    int push = pawn + 8;
+    Bitboard whiteKingAttacks = attacks::king(king[0]);
+    Bitboard blackKingAttacks = attacks::king(king[1]);
+
+    if (Square::distance(king[0], king[1]) <= 1 || king[0] == pawn ||
+        king[1] == pawn ||
+        (stm == 0 && attacks::pawn(Color::WHITE, pawn).check(king[1]))) {
+      result = KPK_INVALID;
+    } else if (stm == 0 && pawn >= 48 && king[0] != push &&
+               (Square::distance(king[1], push) > 1 ||
+                whiteKingAttacks.check(push))) {
+      // The pawn promotes and the queen can not be taken
+      result = KPK_WIN;
+    } else if (stm == 1 &&
+               (!(blackKingAttacks &
+                  ~(whiteKingAttacks | attacks::pawn(Color::WHITE, pawn))) ||
+                (blackKingAttacks & ~whiteKingAttacks).check(pawn))) {
+      // Stalemate, or the pawn can be taken
+      result = KPK_DRAW;
+    } else {
+      result = KPK_UNKNOWN;
+    }
+  }
+
+  uint8_t classify(const std::vector<KpkPosition>& db) {
+    uint8_t reached = KPK_INVALID;
+
+    Bitboard moves = attacks::king(king[stm]);
+    while (moves) {
+      int to = moves.pop();
+      reached |= stm == 0 ? db[kpkIndex(1, king[1], to, pawn)].result
+                          : db[kpkIndex(0, to, king[0], pawn)].result;
+    }
+
+    if (stm == 0) {
+      int push = pawn + 8;
+      if (pawn < 48) reached |= db[kpkIndex(1, king[1], king[0], push)].result;
+      if (pawn < 16 && push != king[0] && push != king[1]) {
+        reached |= db[kpkIndex(1, king[1], king[0], push + 8)].result;
+      }
+    }
+
+    KpkResult good = stm == 0 ? KPK_WIN : KPK_DRAW;
+    KpkResult bad = stm == 0 ? KPK_DRAW : KPK_WIN;
+    return result = (reached & good) ? good : (reached & KPK_UNKNOWN) ? KPK_UNKNOWN : bad;
+  }
+};
+
+std::bitset<KPK_ENTRIES> solveKpk() {
+  std::vector<KpkPosition> db;
+  db.reserve(KPK_ENTRIES);
+  for (int index = 0; index < KPK_ENTRIES; index++) db.emplace_back(index);
+
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (auto& position : db) {
+      if (position.result == KPK_UNKNOWN) {
+        changed |= position.classify(db) != KPK_UNKNOWN;
+      }
+    }
+  }
+
+  std::bitset<KPK_ENTRIES> wins;
+  for (int index = 0; index < KPK_ENTRIES; index++) {
+    wins[index] = db[index].result == KPK_WIN;
+  }
+  return wins;
+}
+
+// Strength of a piece to pick the side that is stored as white
+int pieceWeight(PieceType type) {
+  static const int weights[6] = {1, 3, 3, 5, 9, 0};
+  return weights[static_cast<int>(type)];
+}
+
+}  // namespace
+
+bool probeKpk(const Board& board, Color strong) {
+  static const std::bitset<KPK_ENTRIES> wins = solveKpk();
+
+  // Mirror the board so the side with the pawn is white on files a-d
+  int flip = strong == Color::WHITE ? 0 : 56;
+  int whiteKing = board.kingSq(strong).index() ^ flip;
+  int blackKing = board.kingSq(~strong).index() ^ flip;
+  int pawn = board.pieces(PieceType::PAWN, strong).lsb() ^ flip;
+
+  if ((pawn & 7) >= 4) {
+    whiteKing ^= 7;
+    blackKing ^= 7;
+    pawn ^= 7;
+  }
+
+  int stm = board.sideToMove() == strong ? 0 : 1;
+  return wins[kpkIndex(stm, blackKing, whiteKing, pawn)];
+}
+
+bool EndgameMaterial::parse(std::string_view name, EndgameMaterial& material) {
+  size_t split = name.find('v');
+  if (split == std::string_view::npos) return false;
+
+  EndgamePosition position;
+  for (size_t i = 0; i < name.size(); i++) {
+    if (i == split) continue;
+    if (position.count == MAX_BITBASE_PIECES) return false;
+
+    PieceType type(std::string_view(&name[i], 1));
+    if (type == PieceType::NONE || !std::isupper(name[i])) return false;
+
+    Color color = i < split ? Color::WHITE : Color::BLACK;
+    position.pieces[position.count] = Piece(type, color);
+    position.squares[position.count] = Square(position.count);
+    position.count++;
+  }
+
+  // Both sides need their king
+  int kings = 0;
+  for (int i = 0; i < position.count; i++) {
+    if (position.pieces[i].type() == PieceType::KING) {
+      kings += position.pieces[i].color() == Color::WHITE ? 1 : 2;
+    }
+  }
+  if (kings != 3) return false;
+
+  uint64_t index;
+  position.canonicalize(material, index);
+  return true;
+}
+
+std::string EndgameMaterial::name() const {
+  std::string name;
+  for (int i = 0; i < count; i++) {
+    if (i > 0 && pieces[i].color() != pieces[i - 1].color()) name += 'v';
+    name += "PNBRQK"[static_cast<int>(pieces[i].type())];
+  }
+  return name;
+}
+
+bool EndgamePosition::fromBoard(const Board& board, EndgamePosition& position) {
+  Bitboard occupied = board.occ();
+  if (occupied.count() > MAX_BITBASE_PIECES) return false;
+
+  position.count = 0;
+  position.stm = board.sideToMove();
+  while (occupied) {
+    Square sq = occupied.pop();
+    position.pieces[position.count] = board.at(sq);
+    position.squares[position.count] = sq;
+    position.count++;
+  }
+  return true;
+}
+
+void EndgamePosition::canonicalize(EndgameMaterial& material,
+                                   uint64_t& index) const {
+  // White first, every side from the king down to the pawns. Pieces of the
+  // same kind keep their order.
+  int order[MAX_BITBASE_PIECES];
+  int weight[2] = {0, 0};
+  int whiteCount = 0;
+  for (int i = 0; i < count; i++) {
+    order[i] = i;
+    weight[pieces[i].color()] += pieceWeight(pieces[i].type());
+    if (pieces[i].color() == Color::WHITE) whiteCount++;
+  }
+
+  auto before = [&](int a, int b) {
+    if (pieces[a].color() != pieces[b].color()) {
+      return pieces[a].color() == Color::WHITE;
+    }
+    return pieces[a].type() > pieces[b].type();
+  };
+
+  for (int i = 1; i < count; i++) {
+    for (int j = i; j > 0 && before(order[j], order[j - 1]); j--) {
+      std::swap(order[j], order[j - 1]);
+    }
+  }
+
+  // The stronger side is stored as white. Between sides of equal weight it
+  // is the one with the better pieces, compared piece by piece.
+  bool flip = weight[1] > weight[0];
+  if (weight[0] == weight[1]) {
+    const int* white = order;
+    const int* black = order + whiteCount;
+    int blackCount = count - whiteCount;
+
+    flip = blackCount > whiteCount;
+    for (int i = 0; i < std::min(whiteCount, blackCount); i++) {
+      PieceType whiteType = pieces[white[i]].type();
+      PieceType blackType = pieces[black[i]].type();
+      if (whiteType != blackType) {
+        flip = blackType > whiteType;
+        break;
+      }
+    }
+  }
+
+  // Flipped, the black pieces come first as white pieces on mirrored squares
+  Square squares[MAX_BITBASE_PIECES];
+  for (int i = 0; i < count; i++) {
+    int from = order[flip ? (i + whiteCount) % count : i];
+    Piece piece = pieces[from];
+
+    material.pieces[i] = flip ? Piece(piece.type(), ~piece.color()) : piece;
+    squares[i] = flip ? Square(this->squares[from].index() ^ 56)
+                      : this->squares[from];
+  }
+  material.count = count;
+
+  index = bitbaseIndex(squares, count, flip ? ~stm : stm);
+}
+
+bool writeBitbase(const std::string& path, const EndgameMaterial& material,
+                  const uint8_t* data) {
+  std::ofstream out(path, std::ios::binary);
+  if (!out.is_open()) return false;
+
+  char name[8] = {};
+  std::string materialName = material.name();
+  std::memcpy(name, materialName.data(), std::min(materialName.size(), sizeof(name)));
+
+  uint64_t entries = material.entries();
+  uint32_t pieces = static_cast<uint32_t>(material.count);
+  out.write(PBB_MAGIC, sizeof(PBB_MAGIC));
+  out.write(reinterpret_cast<const char*>(&pieces), sizeof(pieces));
+  out.write(name, sizeof(name));
+  out.write(reinterpret_cast<const char*>(&entries), sizeof(entries));
+  out.write(reinterpret_cast<const char*>(data), (entries + 3) / 4);
+
+  return static_cast<bool>(out);
+}
+
+bool Bitbase::open(const std::string& path) {
+  results = nullptr;
+  if (!file.open(path) || file.size() < PBB_HEADER_BYTES) return false;
+
+  const uint8_t* header = file.data();
+  if (std::memcmp(header, PBB_MAGIC, sizeof(PBB_MAGIC)) != 0) return false;
+
+  char name[9] = {};
+  std::memcpy(name, header + 8, 8);
+  if (!EndgameMaterial::parse(name, material)) return false;
+
+  uint32_t pieces;
+  uint64_t entries;
+  std::memcpy(&pieces, header + 4, sizeof(pieces));
+  std::memcpy(&entries, header + 16, sizeof(entries));
+  if (static_cast<int>(pieces) != material.count ||
+      entries != material.entries() ||
+      file.size() < PBB_HEADER_BYTES + (entries + 3) / 4) {
+    return false;
+  }
+
+  results = header + PBB_HEADER_BYTES;
+  return true;
+}
+
+Wdl Bitbase::probe(const EndgamePosition& position) const {
+  EndgameMaterial canonical;
+  uint64_t index;
+  position.canonicalize(canonical, index);
+  return getWdl(results, index);
+}
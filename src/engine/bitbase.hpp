@@ -0,0 +1,111 @@
+#ifndef BITBASE_HPP
+#define BITBASE_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "../chess-library/include/chess.hpp"
+#include "mapped-file.hpp"
+
+using namespace chess;
+
+/*
+ * Endgame bitbases
+ *
+ * Win, draw or loss of every position of an ending with few pieces. KPK is
+ * small enough to be solved when it is first needed and is kept as one bit
+ * per position. Other endings of up to four pieces are solved offline by
+ * pawnstar-bitbasegen (see bitbase-gen.hpp) into .pbb files of two bits per
+ * position, which are memory mapped and probed in place.
+ */
+
+// True if the side with the pawn wins KPK, the board must hold exactly the
+// two kings and one pawn of `strong`
+bool probeKpk(const Board& board, Color strong);
+
+// Result from the side to move
+enum class Wdl : uint8_t { DRAW = 0, WIN = 1, LOSS = 2, INVALID = 3 };
+
+constexpr int MAX_BITBASE_PIECES = 4;
+
+// Pieces of an ending like "KQvKR", white first and every side ordered
+// KQRBNP. One table covers both colors: the canonical side to be white is
+// the one with more material, so "KvKQ" is probed in "KQvK" with the board
+// mirrored.
+struct EndgameMaterial {
+  int count = 0;
+  Piece pieces[MAX_BITBASE_PIECES];
+
+  // False for more than MAX_BITBASE_PIECES pieces or a side without king
+  static bool parse(std::string_view name, EndgameMaterial& material);
+  std::string name() const;
+
+  // Number of positions, every piece on every square for both sides to move
+  uint64_t entries() const { return 2ULL << (6 * count); }
+};
+
+// Pieces and squares of a position in any order
+struct EndgamePosition {
+  int count = 0;
+  Piece pieces[MAX_BITBASE_PIECES];
+  Square squares[MAX_BITBASE_PIECES];
+  Color stm = Color::WHITE;
+
+  // False if the board has too many pieces
+  static bool fromBoard(const Board& board, EndgamePosition& position);
+
+  // Canonical material of the position and the index in its table
+  void canonicalize(EndgameMaterial& material, uint64_t& index) const;
+};
+
+// Index of the squares of a canonically ordered position
+inline uint64_t bitbaseIndex(const Square* squares, int count, Color stm) {
+  uint64_t index = static_cast<uint64_t>(static_cast<int>(stm)) << (6 * count);
+  for (int i = 0; i < count; i++) {
+    index |= static_cast<uint64_t>(squares[i].index()) << (6 * i);
+  }
+  return index;
+}
+
+// Two bit results of the positions, four to a byte
+inline Wdl getWdl(const uint8_t* data, uint64_t index) {
+  return static_cast<Wdl>((data[index >> 2] >> (2 * (index & 3))) & 3);
+}
+
+inline void setWdl(uint8_t* data, uint64_t index, Wdl wdl) {
+  data[index >> 2] |= static_cast<uint8_t>(static_cast<int>(wdl) << (2 * (index & 3)));
+}
+
+/*
+ * .pbb files
+ *
+ * A 24 byte header ("PBB" + format version, the number of pieces, the
+ * ending's name padded with zeros to 8 bytes, the number of positions)
+ * followed by the results, two bits per position. Stored in the native
+ * (little endian) byte order.
+ */
+constexpr char PBB_MAGIC[4] = {'P', 'B', 'B', '1'};
+constexpr size_t PBB_HEADER_BYTES = 24;
+
+bool writeBitbase(const std::string& path, const EndgameMaterial& material,
+                  const uint8_t* data);
+
+class Bitbase {
+ private:
+  MappedFile file;
+  EndgameMaterial material;
+  const uint8_t* results = nullptr;
+
+ public:
+  // Maps the file, false if it is not a valid .pbb file
+  bool open(const std::string& path);
+
+  bool isOpen() const { return results != nullptr; }
+  const EndgameMaterial& getMaterial() const { return material; }
+
+  // The position must have the material of the table, with either color
+  Wdl probe(const EndgamePosition& position) const;
+};
+
+#endif
@@ -0,0 +1,138 @@
+#include "book.hpp"
+
+PolyglotEntry PolyglotEntry::read(const uint8_t* bytes) {
+  auto readBigEndian = [&](int offset, int count) {
+    uint64_t value = 0;
+    for (int i = 0; i < count; i++) value = (value << 8) | bytes[offset + i];
+    return value;
+  };
+
+  PolyglotEntry entry;
+  entry.key = readBigEndian(0, 8);
+  entry.move = static_cast<uint16_t>(readBigEndian(8, 2));
+  entry.weight = static_cast<uint16_t>(readBigEndian(10, 2));
+  entry.learn = static_cast<uint32_t>(readBigEndian(12, 4));
+  return entry;
+}
+
+void PolyglotEntry::write(uint8_t* bytes) const {
+  auto writeBigEndian = [&](int offset, int count, uint64_t value) {
+    for (int i = count - 1; i >= 0; i--) {
+      bytes[offset + i] = static_cast<uint8_t>(value & 0xFF);
+      value >>= 8;
+    }
+  };
+
+  writeBigEndian(0, 8, key);
+  writeBigEndian(8, 2, move);
+  writeBigEndian(10, 2, weight);
+  writeBigEndian(12, 4, learn);
+}
+
+Move decodePolyglotMove(const Board& board, uint16_t move) {
+  // Squares are numbered a1 = 0 .. h8 = 63 like in the library, the
+  // promotion piece is 1 (knight) to 4 (queen) like PieceType
+  int to = move & 63;
+  int from = (move >> 6) & 63;
+  int promotion = (move >> 12) & 7;
+
+  Movelist moves;
+  movegen::legalmoves(moves, board);
+
+  for (const auto& legal : moves) {
+    if (legal.from().index() != from || legal.to().index() != to) continue;
+
+    int legalPromotion = legal.typeOf() == Move::PROMOTION
+                             ? static_cast<int>(legal.promotionType())
+                             : 0;
+    if (legalPromotion == promotion) return legal;
+  }
+
+  return Move::NO_MOVE;
+}
+
+uint16_t encodePolyglotMove(Move move) {
+  int promotion = move.typeOf() == Move::PROMOTION
+                      ? static_cast<int>(move.promotionType())
+                      : 0;
+  return static_cast<uint16_t>(move.to().index() | (move.from().index() << 6) |
+                               (promotion << 12));
+}
+
+bool PolyglotBook::open(const std::string& path) {
+  close();
+
+  if (!file.open(path)) return false;
+
+  if (file.size() == 0 || file.size() % POLYGLOT_ENTRY_BYTES != 0) {
+    file.close();
+    return false;
+  }
+
+  entryCount = file.size() / POLYGLOT_ENTRY_BYTES;
+  return true;
+}
+
+void PolyglotBook::close() {
+  file.close();
+  entryCount = 0;
+}
+
+std::vector<BookMove> PolyglotBook::probe(const Board& board) const {
+  std::vector<BookMove> moves;
+  if (!isOpen()) return moves;
+
+  uint64_t key = board.polyglotKey();
+
+  // First entry of the key, the entries of a position are consecutive
+  size_t low = 0, high = entryCount;
+  while (low < high) {
+    size_t middle = low + (high - low) / 2;
+    if (entry(middle).key < key) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+
+  for (size_t i = low; i < entryCount; i++) {
+    PolyglotEntry current = entry(i);
+    if (current.key != key) break;
+
+    // Entries with an unknown move (or a key collision) are skipped
+    Move move = decodePolyglotMove(board, current.move);
+    if (move != Move::NO_MOVE) moves.push_back({move, current.weight});
+  }
+
+  return moves;
+}
+
+Move PolyglotBook::pick(const Board& board, bool bestOnly,
+                        std::mt19937_64& rng) const {
+  std::vector<BookMove> moves = probe(board);
+
+  if (bestOnly) {
+    Move best = Move::NO_MOVE;
+    int bestWeight = 0;
+    for (const auto& bookMove : moves) {
+      if (bookMove.weight > bestWeight) {
+        best = bookMove.move;
+        bestWeight = bookMove.weight;
+      }
+    }
+    return best;
+  }
+
+  // Moves with weight 0 are kept in the book but never played
+  uint64_t total = 0;
+  for (const auto& bookMove : moves) total += bookMove.weight;
+  if (total == 0) return Move::NO_MOVE;
+
+  uint64_t target = std::uniform_int_distribution<uint64_t>(0, total - 1)(rng);
+  for (const auto& bookMove : moves) {
+    if (target < bookMove.weight) return bookMove.move;
+    target -= bookMove.weight;
+  }
+
+  return Move::NO_MOVE;
+}
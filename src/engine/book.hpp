@@ -0,0 +1,72 @@
+#ifndef BOOK_HPP
+#define BOOK_HPP
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../chess-library/include/chess.hpp"
+#include "mapped-file.hpp"
+
+using namespace chess;
+
+/*
+ * Polyglot opening books (.bin)
+ *
+ * A book is a sorted array of 16 byte big endian entries: the Polyglot key
+ * of the position, the move, its weight and a learn field that is not used
+ * here. The file is memory mapped and searched in place, so even books of
+ * several hundred megabytes cost no heap memory and open instantly.
+ */
+
+constexpr size_t POLYGLOT_ENTRY_BYTES = 16;
+
+struct PolyglotEntry {
+  uint64_t key;
+  uint16_t move;
+  uint16_t weight;
+  uint32_t learn;
+
+  static PolyglotEntry read(const uint8_t* bytes);
+  void write(uint8_t* bytes) const;
+};
+
+struct BookMove {
+  Move move;
+  uint16_t weight;
+};
+
+// Legal move of the board for a Polyglot move, NO_MOVE if there is none.
+// Castling is stored as the king taking its own rook (e1h1), which is also
+// how the chess library encodes it.
+Move decodePolyglotMove(const Board& board, uint16_t move);
+uint16_t encodePolyglotMove(Move move);
+
+class PolyglotBook {
+ private:
+  MappedFile file;
+  size_t entryCount = 0;
+
+  PolyglotEntry entry(size_t index) const {
+    return PolyglotEntry::read(file.data() + index * POLYGLOT_ENTRY_BYTES);
+  }
+
+ public:
+  // Replaces the open book, false if the file is missing or not a book
+  bool open(const std::string& path);
+  void close();
+
+  bool isOpen() const { return entryCount > 0; }
+  size_t size() const { return entryCount; }
+
+  // All legal book moves of the position in file order
+  std::vector<BookMove> probe(const Board& board) const;
+
+  // Book move of the position, NO_MOVE when it is not in the book. Picks
+  // the move with the highest weight or a random move in proportion to the
+  // weights.
+  Move pick(const Board& board, bool bestOnly, std::mt19937_64& rng) const;
+};
+
+#endif
@@ -25,7 +25,7 @@ int Engine::getPieceValue(Piece piece) {
   }
 }
 
-void Engine::makeMove(std::string move) {
+void Engine::makeMove(std::string_view move) {
   board.makeMove(uci::uciToMove(board, move));
 }
 
@@ -2,9 +2,16 @@
 #define ENGINE_HPP
 
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "../chess-library/include/chess.hpp"
+#include "king-safety.hpp"
+#include "material.hpp"
+#include "pawns.hpp"
 #include "piece-maps.hpp"
+#include "syzygy.hpp"
+#include "tablebases.hpp"
 #include "utils.hpp"
 
 using namespace chess;
@@ -25,12 +32,42 @@ struct TTEntry {
   Move bestMove;     // Best move found for this position
 };
 
+// Evaluation cache entry, the score of a position evaluated in full
+struct EvalEntry {
+  uint32_t key;   // Upper half of the Zobrist hash with the low bit set, 0
+                  // for an empty entry. The lower bits of the hash index.
+  int16_t score;  // From the side to move
+};
+
+// Number of eval cache entries, a power of two
+constexpr size_t EVAL_CACHE_ENTRIES = 1 << 18;
+
+// Transposition table size in megabytes until setHashSize is called, the
+// default of the UCI Hash option
+constexpr size_t DEFAULT_HASH_MB = 64;
+
+// Outcome of a search from the root
+struct SearchResult {
+  Move bestMove = Move::NO_MOVE;  // NO_MOVE if there are no legal moves
+  int score = 0;                  // From the side to move
+  int depth = 0;                  // Last completed depth
+  int nodes = 0;
+  int tbHits = 0;                 // Positions found in the tablebases
+};
+
 class Engine {
  private:
+  // The microbenchmarks time the evaluation terms one by one
+  friend struct EngineBench;
+  // The tests check the lazy evaluation against the full one
+  friend struct EvalTest;
+
   Board board;
 
   // transpostion table realated
   std::unordered_map<uint64_t, TTEntry> transpositionTable;
+  // The table is cleared once it holds more entries than this
+  size_t ttMaxEntries = DEFAULT_HASH_MB * 1024 * 1024 / TT_ENTRY_BYTES;
   int ttHits = 0;
   void clearTranspositionTable();
   bool probeTT(uint64_t hash, int depth, int& score, int alpha, int beta,
@@ -42,17 +79,64 @@ class Engine {
   int getPieceValue(Piece piece);
 
   // Search related
+  // In copy-make mode a move is taken back by restoring the saved position
+  // with one copy instead of undoing it
+  bool copyMake = false;
+  // Self-play runs many engines at once and turns the info lines off
+  bool printInfo = true;
+  void makeSearchMove(Move move, Board::Position& saved);
+  void unmakeSearchMove(Move move, const Board::Position& saved);
+
+  // Node limit of the current iteration, 0 for none
+  int nodeLimit = 0;
+  bool searchStopped = false;
+
+  // Endgame tablebases, shared by all engines and probed in positions of up
+  // to tbProbeLimit pieces. nullptr without tablebases. The Syzygy tables
+  // are tried first, the bitbases cover the endings they miss.
+  const Tablebases* tablebases = nullptr;
+  int tbProbeLimit = MAX_BITBASE_PIECES;
+  const Syzygy* syzygy = nullptr;
+  int syzygyProbeLimit = MAX_SYZYGY_PIECES;
+  int tbHits = 0;
+  Wdl probeTablebases();
+  movegen::ScoredMove* rankRootMoves(movegen::ScoredMove* begin,
+                                     movegen::ScoredMove* end);
+
+  SearchResult searchRoot(int depth);
   int negaMax(int depth, int alpha, int beta, int ply);
   int extendedSearch(int alpha, int beta, int ply);
-  void orderMoves(Movelist& moves);
+  void orderMoves(movegen::ScoredMove* begin, movegen::ScoredMove* end);
 
   // Evaluation related fuctions
-  int evaluatePosition(const Board& board, int ply);
+  // Evaluates in stages and stops early once the score is far enough
+  // outside (alpha, beta) that the other terms cannot bring it back. Draws
+  // by rule are scored, mates and stalemates are left to the caller.
+  // `rootDistance` is the distance of the position to the search root, a
+  // repetition inside it is a draw (see Board::isRepetitionDraw).
+  int evaluatePosition(const Board& board, int ply, int rootDistance,
+                       int alpha = -MATE_SCORE, int beta = MATE_SCORE);
   int evaluateMaterial(const Board& board);
   int evaluatePieceSquareTables(const Board& board, bool isEndGame);
-  int evaluatePawnStructure(const Board& board);  // Todo
+  int evaluatePawnStructure(const Board& board);
   int evaluateRookFiles(const Board& board);      // Todo
-  int evaluateMobility(const Board& board);       // Todo did something
+  int evaluateMobility(const AttackTerms& attacks);
+  int evaluateKingSafety(const Board& board, const AttackTerms& attacks);
+
+  // Pawn hash table, every engine (and so every thread) has its own
+  std::vector<PawnEntry> pawnTable = std::vector<PawnEntry>(PAWN_HASH_ENTRIES);
+  uint64_t pawnProbes = 0;
+  uint64_t pawnHits = 0;
+
+  // Material hash table, per engine like the pawn hash table
+  std::vector<MaterialEntry> materialTable =
+      std::vector<MaterialEntry>(MATERIAL_HASH_ENTRIES);
+  const MaterialEntry& probeMaterial(const Board& board);
+
+  // Evaluation cache, per engine like the pawn hash table
+  std::vector<EvalEntry> evalCache = std::vector<EvalEntry>(EVAL_CACHE_ENTRIES);
+  uint64_t evalProbes = 0;
+  uint64_t evalHits = 0;
 
   // Engame Specific evalution stuff
   int kingEndgameScore(const Board& board, Color us, Color op);
@@ -72,22 +156,59 @@ class Engine {
 
   std::string getBestMove(int depth);
 
+  // Static evaluation of the current position from the side to move
+  int evaluate();
+
+  // Iterative deepening within `limit` nodes, returns the result of the
+  // last iteration that finished
+  SearchResult searchNodes(int limit, int maxDepth = 64);
+
+  void setCopyMake(bool enabled) { copyMake = enabled; }
+  void setPrintInfo(bool enabled) { printInfo = enabled; }
+
+  // The tables must outlive the engine, nullptr turns probing off
+  void setTablebases(const Tablebases* tables, int probeLimit) {
+    tablebases = tables;
+    tbProbeLimit = probeLimit;
+  }
+
+  void setSyzygy(const Syzygy* tables, int probeLimit) {
+    syzygy = tables;
+    syzygyProbeLimit = probeLimit;
+  }
+
   // Tts size
   size_t getTableSize() const { return transpositionTable.size(); }
 
+  // Size of each entry + size of the key (array)
+  static constexpr size_t TT_ENTRY_BYTES =
+      sizeof(TTEntry) + sizeof(std::array<unsigned char, 24>);
+
+  // Limits the table to about this many megabytes and clears it
+  void setHashSize(size_t megabytes);
+
   /* Get table size in Kilobytes */
   size_t getTableMemoryUsage() const {
-    // Size of each entry + size of the key (array) * number of entries
-    size_t size = (sizeof(TTEntry) + sizeof(std::array<unsigned char, 24>)) *
-                  transpositionTable.size();
+    size_t size = TT_ENTRY_BYTES * transpositionTable.size();
     return size / 1024;
   }
 
   // Move making
-  void makeMove(std::string move);
+  void makeMove(std::string_view move);
+  void makeMove(Move move) { board.makeMove(move); }
+
+  const Board& getBoard() const { return board; }
 
   int positionsSearched = 0;
 
+  // Pawn hash lookups since the engine was created
+  uint64_t getPawnHashProbes() const { return pawnProbes; }
+  uint64_t getPawnHashHits() const { return pawnHits; }
+
+  // Eval cache lookups since the engine was created
+  uint64_t getEvalCacheProbes() const { return evalProbes; }
+  uint64_t getEvalCacheHits() const { return evalHits; }
+
   bool isGameOver() {
     auto result = board.isGameOver();
     return result.second != GameResult::NONE;
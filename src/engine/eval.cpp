@@ -1,12 +1,15 @@
 #include "engine.hpp"
 
-int Engine::evaluateMaterial(const Board& board) {
-  constexpr int PAWN_VALUE = 100;
-  constexpr int KNIGHT_VALUE = 300;
-  constexpr int BISHOP_VALUE = 320;
-  constexpr int ROOK_VALUE = 500;
-  constexpr int QUEEN_VALUE = 900;
+namespace {
+
+// Largest swing of the terms left after each stage of the evaluation, from
+// the terms of random game positions (99% stay within them)
+constexpr int LAZY_MARGIN_MATERIAL = 450;  // Tables, pawns, mobility, king
+constexpr int LAZY_MARGIN_POSITIONAL = 350;  // Mobility and king
+
+}  // namespace
 
+int Engine::evaluateMaterial(const Board& board) {
   auto countMaterial = [&](Color color) {
     return board.pieces(PieceType::PAWN, color).count() * PAWN_VALUE +
            board.pieces(PieceType::KNIGHT, color).count() * KNIGHT_VALUE +
@@ -25,30 +28,26 @@ int Engine::evaluatePieceSquareTables(const Board& board, bool isEndGame) {
     Piece piece = board.at(sq);
     if (piece.type() == PieceType::NONE) continue;
 
+    // The tables are written from whites side with the 8th rank first
     int index =
-        (piece.color() == Color::WHITE) ? sq.index() : mirrorIndex(sq.index());
+        (piece.color() == Color::WHITE) ? mirrorIndex(sq.index()) : sq.index();
     int squareValue = 0;
 
-    switch (piece.type()) {
-      case PAWN:
-        squareValue = PAWN_TABLE[index];
-        break;
-      case KNIGHT:
-        squareValue = KNIGHT_TABLE[index];
-        break;
-      case BISHOP:
-        squareValue = BISHOP_TABLE[index];
-        break;
-      case ROOK:
-        squareValue = ROOK_TABLE[index];
-        break;
-      case QUEEN:
-        squareValue = QUEEN_TABLE[index];
-        break;
-      case KING:
-        squareValue =
-            isEndGame ? KING_END_TABLE[index] : KING_MIDDLE_TABLE[index];
-        break;
+    // PieceType values, not the PieceGenType move generation flags
+    PieceType type = piece.type();
+    if (type == PieceType::PAWN) {
+      squareValue = PAWN_TABLE[index];
+    } else if (type == PieceType::KNIGHT) {
+      squareValue = KNIGHT_TABLE[index];
+    } else if (type == PieceType::BISHOP) {
+      squareValue = BISHOP_TABLE[index];
+    } else if (type == PieceType::ROOK) {
+      squareValue = ROOK_TABLE[index];
+    } else if (type == PieceType::QUEEN) {
+      squareValue = QUEEN_TABLE[index];
+    } else {
+      squareValue =
+          isEndGame ? KING_END_TABLE[index] : KING_MIDDLE_TABLE[index];
     }
 
     eval += (piece.color() == Color::WHITE) ? squareValue : -squareValue;
@@ -58,8 +57,27 @@ int Engine::evaluatePieceSquareTables(const Board& board, bool isEndGame) {
 }
 
 int Engine::evaluatePawnStructure(const Board& board) {
-  int eval = 0;
-  return eval;
+  uint64_t key = board.pawnKey();
+  PawnEntry& entry = pawnTable[key & (PAWN_HASH_ENTRIES - 1)];
+
+  pawnProbes++;
+  if (entry.key == key) {
+    pawnHits++;
+    return entry.score;
+  }
+
+  entry.key = key;
+  entry.score = pawnStructureScore(board);
+  entry.kingSquare[0] = entry.kingSquare[1] = Square();
+  return entry.score;
+}
+
+const MaterialEntry& Engine::probeMaterial(const Board& board) {
+  uint64_t key = board.materialKey();
+  MaterialEntry& entry = materialTable[key & (MATERIAL_HASH_ENTRIES - 1)];
+
+  if (entry.key != key) computeMaterial(board, entry);
+  return entry;
 }
 
 int Engine::evaluateRookFiles(const Board& board) {
@@ -68,23 +86,26 @@ int Engine::evaluateRookFiles(const Board& board) {
 }
 
 /* The side which has more choices is generally better */
-int Engine::evaluateMobility(const Board& board) {
-  int eval = 0;
-  // Color us = board.sideToMove();
-  // Color op = us == Color::WHITE ? Color::BLACK : Color::WHITE;
-
-  // Create temporary board to generate moves
-  Board tempBoard = board;
-
-  Movelist ourMoves;
-  movegen::legalmoves(ourMoves, tempBoard);
-  eval += ourMoves.size() * 5;  // 5 points per legal move
+int Engine::evaluateMobility(const AttackTerms& attacks) {
+  return (attacks.mobility[0] - attacks.mobility[1]) * MOBILITY_WEIGHT;
+}
 
-  tempBoard.makeNullMove();
-  Movelist theirMoves;
-  movegen::legalmoves(theirMoves, tempBoard);
-  eval -= theirMoves.size() * 5;
-  tempBoard.unmakeNullMove();
+// Attacks on the king zones and the pawns around the kings. The pawn
+// entry is the one evaluatePawnStructure looked up for this position.
+int Engine::evaluateKingSafety(const Board& board, const AttackTerms& attacks) {
+  int eval = KING_SAFETY_TABLE[attacks.attackUnits[0]] -
+             KING_SAFETY_TABLE[attacks.attackUnits[1]];
+
+  PawnEntry& entry = pawnTable[board.pawnKey() & (PAWN_HASH_ENTRIES - 1)];
+  for (Color color : {Color::WHITE, Color::BLACK}) {
+    Square king = board.kingSq(color);
+    if (entry.kingSquare[color] != king) {
+      entry.kingSquare[color] = king;
+      entry.kingShelter[color] = kingShelterScore(board, color);
+    }
+    eval += color == Color::WHITE ? entry.kingShelter[color]
+                                  : -entry.kingShelter[color];
+  }
 
   return eval;
 }
@@ -101,12 +122,12 @@ int Engine::kingEndgameScore(const Board& board, Color us, Color op) {
   // Higher bonus for corner squares
   if ((opKingFile == 0 || opKingFile == 7) &&
       (opKingRank == 0 || opKingRank == 7)) {
-    score += 50;
+    score += KING_CORNER_BONUS;
   }
   // Bonus for being on the edge
   else if (opKingFile == 0 || opKingFile == 7 || opKingRank == 0 ||
            opKingRank == 7) {
-    score += 30;
+    score += KING_EDGE_BONUS;
   }
 
   int distance = manhattanDistance(ourKing, opponentKing);
@@ -115,16 +136,61 @@ int Engine::kingEndgameScore(const Board& board, Color us, Color op) {
   return score;
 }
 
-int Engine::evaluatePosition(const Board& board, int ply) {
-  if (isGameOver()) {
-    if (getGameOverReason() == GameResultReason::CHECKMATE) {
-      // Return a mate score that's adjusted by the current ply depth
-      // This ensures closer mates are valued higher than distant ones
-      return -MATE_SCORE + ply;  // The side to move is checkmated
-    }
-    return 0;  // Draw
+int Engine::evaluate() { return evaluatePosition(board, 0, 0); }
+
+int Engine::evaluatePosition(const Board& board, int ply, int rootDistance,
+                             int alpha, int beta) {
+  // Only the draws by rule are checked here, they need no move generation.
+  // Mates and stalemates are found by the searches, which generate the
+  // moves anyway.
+  if (board.isHalfMoveDraw()) {
+    return board.getHalfMoveDrawType().first == GameResultReason::CHECKMATE
+               ? -MATE_SCORE + ply
+               : 0;
+  }
+
+  if (board.isInsufficientMaterial() || board.isRepetitionDraw(rootDistance)) {
+    return 0;
+  }
+
+  // Positions seen before through transpositions or a second visit in the
+  // quiescence search. Only complete evaluations are cached, a lazy one
+  // depends on the window. The low bit of a stored key is always set, so
+  // the zeroed empty entries never match.
+  uint64_t hash = board.hash();
+  EvalEntry& cached = evalCache[hash & (EVAL_CACHE_ENTRIES - 1)];
+  uint32_t cacheKey = static_cast<uint32_t>(hash >> 32) | 1;
+
+  evalProbes++;
+  if (cached.key == cacheKey) {
+    evalHits++;
+    return cached.score;
+  }
+
+  const MaterialEntry& material = probeMaterial(board);
+
+  // Known endgames have their own evaluation
+  if (material.evaluate) {
+    int score = material.evaluate(board, material.strongSide);
+    return board.sideToMove() == material.strongSide ? score : -score;
   }
 
+  // Scaled score from the side to move
+  auto finish = [&](int eval) {
+    Color leader = eval > 0 ? Color::WHITE : Color::BLACK;
+    eval = eval * material.scaleFactor(board, leader) / SCALE_NORMAL;
+    return (board.sideToMove() == Color::WHITE) ? eval : -eval;
+  };
+
+  // The score so far is returned when the terms left cannot bring it back
+  // into the window. The margin is applied before the scaling, since
+  // finish() only grows with the eval, the scaled score is then a bound too.
+  auto outside = [&](int eval, int margin) {
+    int low = finish(eval - margin);
+    int high = finish(eval + margin);
+    return std::max(low, high) <= alpha || std::min(low, high) >= beta;
+  };
+
   int eval = 0;
 
   bool isEndgame = (board.pieces(PieceType::QUEEN, Color::WHITE).count() +
@@ -132,16 +198,29 @@ int Engine::evaluatePosition(const Board& board, int ply) {
                     0);
 
   eval += evaluateMaterial(board);
+  eval += material.imbalance;
+  if (outside(eval, LAZY_MARGIN_MATERIAL)) return finish(eval);
+
   eval += evaluatePieceSquareTables(board, isEndgame);
   eval += evaluatePawnStructure(board);
   eval += evaluateRookFiles(board);
-  eval += evaluateMobility(board);
+  if (outside(eval, LAZY_MARGIN_POSITIONAL)) return finish(eval);
+
+  AttackTerms attacks = countAttackTerms(board);
+  eval += evaluateMobility(attacks);
 
   //* If it is an endgame then we want the opponent king on specific squares
   if (isEndgame) {
     eval += kingEndgameScore(board, Color::WHITE, Color::BLACK) -
             kingEndgameScore(board, Color::BLACK, Color::WHITE);
+  } else {
+    eval += evaluateKingSafety(board, attacks);
   }
 
-  return (board.sideToMove() == Color::WHITE) ? eval : -eval;
+  // Drawish endgames scale down the advantage of the side ahead
+  int score = finish(eval);
+
+  cached.key = cacheKey;
+  cached.score = static_cast<int16_t>(score);
+  return score;
 }
@@ -0,0 +1,61 @@
+#include "king-safety.hpp"
+
+#include <algorithm>
+
+namespace {
+
+// Attack units per attacked king zone square, by piece type
+constexpr int ATTACK_WEIGHTS[6] = {0, 2, 2, 3, 5, 0};
+
+// The king, the squares around it and the ones in front of those
+Bitboard kingZone(Square king, Color color) {
+  Bitboard zone = attacks::king(king) | Bitboard::fromSquare(king);
+  return zone | (color == Color::WHITE ? zone << 8 : zone >> 8);
+}
+
+}  // namespace
+
+AttackTerms countAttackTerms(const Board& board) {
+  AttackTerms terms;
+  Bitboard occupied = board.occ();
+
+  for (Color color : {Color::WHITE, Color::BLACK}) {
+    Bitboard own = board.us(color);
+    Bitboard zone = kingZone(board.kingSq(~color), ~color);
+    int attackers = 0;
+    int units = 0;
+
+    for (PieceType type : {PieceType::KNIGHT, PieceType::BISHOP,
+                           PieceType::ROOK, PieceType::QUEEN}) {
+      Bitboard pieces = board.pieces(type, color);
+      while (pieces) {
+        Square sq = pieces.pop();
+        Bitboard attacked;
+        if (type == PieceType::KNIGHT) {
+          attacked = attacks::knight(sq);
+        } else if (type == PieceType::BISHOP) {
+          attacked = attacks::bishop(sq, occupied);
+        } else if (type == PieceType::ROOK) {
+          attacked = attacks::rook(sq, occupied);
+        } else {
+          attacked = attacks::queen(sq, occupied);
+        }
+
+        terms.mobility[color] += (attacked & ~own).count();
+
+        int zoneAttacks = (attacked & zone).count();
+        if (zoneAttacks) {
+          attackers++;
+          units += zoneAttacks * ATTACK_WEIGHTS[static_cast<int>(type)];
+        }
+      }
+    }
+
+    // A single attacker is no threat to the king
+    if (attackers >= 2) {
+      terms.attackUnits[color] = std::min(units, KING_SAFETY_UNITS - 1);
+    }
+  }
+
+  return terms;
+}
@@ -0,0 +1,30 @@
+#ifndef KING_SAFETY_HPP
+#define KING_SAFETY_HPP
+
+#include "../chess-library/include/chess.hpp"
+
+using namespace chess;
+
+/*
+ * Piece attacks and king safety
+ *
+ * The attacks of the knights, bishops, rooks and queens are looked up once
+ * per evaluation and shared by two terms: the mobility of both sides and
+ * the attack units against the enemy king zone, the king's square and the
+ * squares around it. The units go through the nonlinear KING_SAFETY_TABLE,
+ * so a few pieces attacking together count for much more than the sum of
+ * single attackers. The pawns around the king are counted in pawns.hpp.
+ */
+
+// Entries of KING_SAFETY_TABLE, larger unit counts use the last one
+constexpr int KING_SAFETY_UNITS = 64;
+
+// Attack counts of both sides, by the attacking color
+struct AttackTerms {
+  int mobility[2] = {0, 0};     // Attacked squares without own pieces
+  int attackUnits[2] = {0, 0};  // Weighted attacks on the enemy king zone
+};
+
+AttackTerms countAttackTerms(const Board& board);
+
+#endif
@@ -0,0 +1,109 @@
+#include "mapped-file.hpp"
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& path) {
+  close();
+
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE) return false;
+
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(file, &fileSize)) {
+    CloseHandle(file);
+    return false;
+  }
+
+  if (fileSize.QuadPart == 0) {
+    CloseHandle(file);
+    isEmptyFile = true;
+    return true;
+  }
+
+  HANDLE mapping =
+      CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping) {
+    CloseHandle(file);
+    return false;
+  }
+
+  void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (!view) {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    return false;
+  }
+
+  fileHandle = file;
+  mappingHandle = mapping;
+  bytes = static_cast<const uint8_t*>(view);
+  length = static_cast<size_t>(fileSize.QuadPart);
+  return true;
+}
+
+void MappedFile::close() {
+  if (bytes) UnmapViewOfFile(bytes);
+  if (mappingHandle) CloseHandle(mappingHandle);
+  if (fileHandle) CloseHandle(fileHandle);
+
+  bytes = nullptr;
+  length = 0;
+  fileHandle = nullptr;
+  mappingHandle = nullptr;
+  isEmptyFile = false;
+}
+
+#else
+
+bool MappedFile::open(const std::string& path) {
+  close();
+
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+
+  struct stat info;
+  if (fstat(fd, &info) != 0) {
+    ::close(fd);
+    return false;
+  }
+
+  // mmap refuses a zero length mapping
+  if (info.st_size == 0) {
+    ::close(fd);
+    isEmptyFile = true;
+    return true;
+  }
+
+  void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ,
+                    MAP_SHARED, fd, 0);
+  // The mapping keeps its own reference to the file
+  ::close(fd);
+  if (view == MAP_FAILED) return false;
+
+  bytes = static_cast<const uint8_t*>(view);
+  length = static_cast<size_t>(info.st_size);
+  return true;
+}
+
+void MappedFile::close() {
+  if (bytes) munmap(const_cast<uint8_t*>(bytes), length);
+
+  bytes = nullptr;
+  length = 0;
+  isEmptyFile = false;
+}
+
+#endif
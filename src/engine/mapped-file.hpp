@@ -0,0 +1,50 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/*
+ * Read-only memory mapping of a whole file
+ *
+ * Large data files (opening books, PGN databases) are read through the page
+ * cache instead of being copied into the heap. Pages are only loaded when
+ * they are touched, and several processes share the same physical memory.
+ */
+class MappedFile {
+ private:
+  const uint8_t* bytes = nullptr;
+  size_t length = 0;
+  bool isEmptyFile = false;
+#ifdef _WIN32
+  void* fileHandle = nullptr;
+  void* mappingHandle = nullptr;
+#endif
+
+ public:
+  MappedFile() = default;
+  explicit MappedFile(const std::string& path) { open(path); }
+  ~MappedFile() { close(); }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  // Maps the file, false if it can not be opened. An empty file maps fine
+  // but has no data.
+  bool open(const std::string& path);
+  void close();
+
+  bool isOpen() const { return bytes != nullptr || isEmptyFile; }
+
+  const uint8_t* data() const { return bytes; }
+  size_t size() const { return length; }
+
+  // The contents as text, for PGN and EPD files
+  std::string_view view() const {
+    return {reinterpret_cast<const char*>(bytes), length};
+  }
+};
+
+#endif
@@ -0,0 +1,174 @@
+#include "material.hpp"
+
+#include <algorithm>
+
+#include "bitbase.hpp"
+#include "piece-maps.hpp"
+
+namespace {
+
+constexpr uint64_t DARK_SQUARES = 0xAA55AA55AA55AA55ULL;
+
+int nonPawnMaterial(const Board& board, Color color) {
+  return board.pieces(PieceType::KNIGHT, color).count() * KNIGHT_VALUE +
+         board.pieces(PieceType::BISHOP, color).count() * BISHOP_VALUE +
+         board.pieces(PieceType::ROOK, color).count() * ROOK_VALUE +
+         board.pieces(PieceType::QUEEN, color).count() * QUEEN_VALUE;
+}
+
+// 0 on the four center squares up to 6 in a corner
+int centerDistance(Square sq) {
+  int file = sq.file();
+  int rank = sq.rank();
+  return std::max(3 - file, file - 4) + std::max(3 - rank, rank - 4);
+}
+
+// Lone king against a rook or more. The weak king is driven to the edge and
+// our king comes closer to help with the mate.
+int evaluateKXK(const Board& board, Color strong) {
+  Square strongKing = board.kingSq(strong);
+  Square weakKing = board.kingSq(~strong);
+  Bitboard pawns = board.pieces(PieceType::PAWN, strong);
+  Bitboard bishops = board.pieces(PieceType::BISHOP, strong);
+
+  bool bishopPair = (bishops & DARK_SQUARES) && (bishops & ~DARK_SQUARES);
+  bool canMate = board.pieces(PieceType::QUEEN, strong) ||
+                 board.pieces(PieceType::ROOK, strong) || bishopPair ||
+                 (bishops && board.pieces(PieceType::KNIGHT, strong));
+
+  // Knights or bishops of one color alone cannot force the mate
+  if (!canMate && !pawns) return 0;
+
+  int score = nonPawnMaterial(board, strong) + pawns.count() * PAWN_VALUE +
+              20 * centerDistance(weakKing) +
+              10 * (7 - Square::distance(strongKing, weakKing));
+
+  return canMate ? score + KNOWN_WIN : score;
+}
+
+// Bishop and knight only mate in a corner of the bishop's color
+int evaluateKBNK(const Board& board, Color strong) {
+  Square strongKing = board.kingSq(strong);
+  Square weakKing = board.kingSq(~strong);
+  Square bishop = board.pieces(PieceType::BISHOP, strong).lsb();
+
+  bool darkCorners = Square::same_color(bishop, Square::underlying::SQ_A1);
+  Square corner1 = darkCorners ? Square(Square::underlying::SQ_A1)
+                                : Square(Square::underlying::SQ_A8);
+  Square corner2 = darkCorners ? Square(Square::underlying::SQ_H8)
+                                : Square(Square::underlying::SQ_H1);
+  int cornerDistance = std::min(Square::distance(weakKing, corner1),
+                                Square::distance(weakKing, corner2));
+
+  return KNOWN_WIN + KNIGHT_VALUE + BISHOP_VALUE +
+         20 * (7 - cornerDistance) + 10 * centerDistance(weakKing) +
+         10 * (7 - Square::distance(strongKing, weakKing));
+}
+
+// King and pawn against king is known exactly from the KPK bitbase, a won
+// position is scored higher the further the pawn is
+int evaluateKPK(const Board& board, Color strong) {
+  if (!probeKpk(board, strong)) return 0;
+
+  Square pawn = board.pieces(PieceType::PAWN, strong).lsb();
+  return KNOWN_WIN + PAWN_VALUE + 10 * pawn.relative_square(strong).rank();
+}
+
+// Bishops of opposite colors make the extra pawns hard to win with, even
+// more so without any other pieces
+int scaleOppositeBishops(const Board& board, Color strong) {
+  Square ours = board.pieces(PieceType::BISHOP, strong).lsb();
+  Square theirs = board.pieces(PieceType::BISHOP, ~strong).lsb();
+  if (Square::same_color(ours, theirs)) return SCALE_NORMAL;
+
+  bool onlyBishops = nonPawnMaterial(board, strong) == BISHOP_VALUE &&
+                     nonPawnMaterial(board, ~strong) == BISHOP_VALUE;
+  return onlyBishops ? SCALE_NORMAL / 2 : SCALE_NORMAL * 3 / 4;
+}
+
+int scoreImbalance(const ImbalanceTerms& terms) {
+  return terms.bishopPair * BISHOP_PAIR_BONUS +
+         terms.knightPawns * KNIGHT_PAWN_ADJUST +
+         terms.rookPawns * ROOK_PAWN_ADJUST;
+}
+
+}  // namespace
+
+ImbalanceTerms countImbalanceTerms(const Board& board, Color color) {
+  ImbalanceTerms terms;
+  int pawns = board.pieces(PieceType::PAWN, color).count();
+
+  terms.bishopPair = board.pieces(PieceType::BISHOP, color).count() >= 2;
+  terms.knightPawns =
+      board.pieces(PieceType::KNIGHT, color).count() * (pawns - 5);
+  terms.rookPawns = board.pieces(PieceType::ROOK, color).count() * (pawns - 5);
+
+  return terms;
+}
+
+bool MaterialEntry::isSpecial(const Board& board) const {
+  return evaluate || scaleFactor(board, Color::WHITE) != SCALE_NORMAL ||
+         scaleFactor(board, Color::BLACK) != SCALE_NORMAL;
+}
+
+int MaterialEntry::scaleFactor(const Board& board, Color strong) const {
+  int scale = factor[strong];
+  if (this->scale[strong]) {
+    scale = std::min(scale, this->scale[strong](board, strong));
+  }
+  return scale;
+}
+
+void computeMaterial(const Board& board, MaterialEntry& entry) {
+  entry.key = board.materialKey();
+  entry.evaluate = nullptr;
+  entry.scale[0] = entry.scale[1] = nullptr;
+  entry.factor[0] = entry.factor[1] = SCALE_NORMAL;
+  entry.strongSide = Color::WHITE;
+
+  int phase = 0;
+  for (Color color : {Color::WHITE, Color::BLACK}) {
+    phase += board.pieces(PieceType::KNIGHT, color).count() +
+             board.pieces(PieceType::BISHOP, color).count() +
+             board.pieces(PieceType::ROOK, color).count() * 2 +
+             board.pieces(PieceType::QUEEN, color).count() * 4;
+  }
+  entry.phase = static_cast<uint8_t>(std::min(phase, 24));
+
+  entry.imbalance = static_cast<int16_t>(
+      scoreImbalance(countImbalanceTerms(board, Color::WHITE)) -
+      scoreImbalance(countImbalanceTerms(board, Color::BLACK)));
+
+  for (Color color : {Color::WHITE, Color::BLACK}) {
+    int npm = nonPawnMaterial(board, color);
+    int weakNpm = nonPawnMaterial(board, ~color);
+    int pawns = board.pieces(PieceType::PAWN, color).count();
+
+    if (board.us(~color).count() == 1) {
+      if (pawns == 0 && npm == KNIGHT_VALUE + BISHOP_VALUE &&
+          board.pieces(PieceType::KNIGHT, color).count() == 1) {
+        entry.evaluate = evaluateKBNK;
+      } else if (npm >= ROOK_VALUE) {
+        entry.evaluate = evaluateKXK;
+      } else if (npm == 0 && pawns == 1) {
+        entry.evaluate = evaluateKPK;
+      }
+
+      if (entry.evaluate) {
+        entry.strongSide = color;
+        return;
+      }
+    }
+
+    // Without pawns the side ahead needs more than a minor piece extra
+    if (pawns == 0 && npm - weakNpm <= BISHOP_VALUE) {
+      entry.factor[color] =
+          npm < ROOK_VALUE ? 0 : weakNpm <= BISHOP_VALUE ? 4 : 14;
+    }
+  }
+
+  if (board.pieces(PieceType::BISHOP, Color::WHITE).count() == 1 &&
+      board.pieces(PieceType::BISHOP, Color::BLACK).count() == 1) {
+    entry.scale[0] = entry.scale[1] = scaleOppositeBishops;
+  }
+}
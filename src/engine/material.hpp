@@ -0,0 +1,62 @@
+#ifndef MATERIAL_HPP
+#define MATERIAL_HPP
+
+#include <cstdint>
+
+#include "../chess-library/include/chess.hpp"
+
+using namespace chess;
+
+/*
+ * Material hash table
+ *
+ * Everything that only depends on how many pieces of each kind are on the
+ * board is computed once per material configuration and cached by
+ * Board::materialKey(): the game phase, the imbalance terms, and for the
+ * endgames we know something about, a specialized evaluation or a scale
+ * factor for the side that is ahead.
+ */
+
+// Scale factors are out of SCALE_NORMAL
+constexpr int SCALE_NORMAL = 64;
+
+// Added to the material of a won endgame, far below the mate scores
+constexpr int KNOWN_WIN = 10000;
+
+// Score of a known endgame from the strong side
+using EndgameEval = int (*)(const Board& board, Color strong);
+
+// Scale factor of a known endgame for the strong side, the side ahead
+using EndgameScale = int (*)(const Board& board, Color strong);
+
+// Imbalance counts of one side, the tuner uses them as coefficients
+struct ImbalanceTerms {
+  int bishopPair = 0;
+  int knightPawns = 0;  // Knights times own pawns above five
+  int rookPawns = 0;    // Rooks times own pawns above five
+};
+
+ImbalanceTerms countImbalanceTerms(const Board& board, Color color);
+
+struct MaterialEntry {
+  uint64_t key;  // Board::materialKey(), never 0 since the kings are hashed
+  EndgameEval evaluate;   // Replaces the whole evaluation when set
+  EndgameScale scale[2];  // By color of the side ahead, before factor
+  int16_t imbalance;      // From whites side
+  uint8_t factor[2];      // By color of the side ahead
+  uint8_t phase;          // 24 with all pieces on the board, 0 without
+  Color strongSide;       // The side `evaluate` scores for
+
+  // Specialized evaluations and scale factors are not sums of the tuned
+  // parameters
+  bool isSpecial(const Board& board) const;
+
+  int scaleFactor(const Board& board, Color strong) const;
+};
+
+void computeMaterial(const Board& board, MaterialEntry& entry);
+
+// Number of entries, a power of two
+constexpr size_t MATERIAL_HASH_ENTRIES = 1 << 13;
+
+#endif
@@ -0,0 +1,119 @@
+#include "pawns.hpp"
+
+#include "piece-maps.hpp"
+
+namespace {
+
+constexpr uint64_t FILE_A_MASK = 0x0101010101010101ULL;
+
+uint64_t fileMask(int file) { return FILE_A_MASK << file; }
+
+uint64_t adjacentFilesMask(int file) {
+  return (file > 0 ? fileMask(file - 1) : 0) | (file < 7 ? fileMask(file + 1) : 0);
+}
+
+// Ranks in front of `rank` as seen by `color`
+uint64_t forwardRanksMask(Color color, int rank) {
+  if (color == Color::WHITE) return rank == 7 ? 0 : ~0ULL << (8 * (rank + 1));
+  return (1ULL << (8 * rank)) - 1;
+}
+
+int scoreTerms(const PawnTerms& terms) {
+  int score = terms.doubled * DOUBLED_PAWN + terms.isolated * ISOLATED_PAWN +
+              terms.backward * BACKWARD_PAWN +
+              terms.connected * CONNECTED_PAWN +
+              terms.candidate * CANDIDATE_PAWN;
+
+  for (int rank = 0; rank < 8; rank++) {
+    score += terms.passed[rank] * PASSED_PAWN_BONUS[rank];
+  }
+
+  return score;
+}
+
+}  // namespace
+
+PawnTerms countPawnTerms(Bitboard ours, Bitboard theirs, Color us) {
+  PawnTerms terms;
+
+  Bitboard pawns = ours;
+  while (pawns) {
+    Square sq = pawns.pop();
+    int file = sq.file();
+    int rank = sq.rank();
+
+    uint64_t sameFile = fileMask(file);
+    uint64_t adjacent = adjacentFilesMask(file);
+    uint64_t front = forwardRanksMask(us, rank);
+
+    bool doubled = static_cast<bool>(ours & (sameFile & front));
+    bool opposed = static_cast<bool>(theirs & (sameFile & front));
+    bool isolated = !(ours & adjacent);
+    bool passed = !doubled && !(theirs & ((sameFile | adjacent) & front));
+
+    // Pawns next to it or behind it on the adjacent files can still
+    // advance to support it
+    Bitboard neighbours = ours & (adjacent & ~front);
+    Bitboard phalanx = ours & (adjacent & (0xFFULL << (8 * rank)));
+    Bitboard supporters = ours & attacks::pawn(~us, sq);
+
+    if (doubled) terms.doubled++;
+    if (isolated) terms.isolated++;
+    if (supporters || phalanx) terms.connected++;
+
+    if (passed) {
+      terms.passed[us == Color::WHITE ? rank : 7 - rank]++;
+      continue;
+    }
+
+    // Stop square is attacked by an enemy pawn and no neighbour can come up
+    // to defend it
+    Square stop(sq.index() + (us == Color::WHITE ? 8 : -8));
+    if (!isolated && !neighbours && (theirs & attacks::pawn(us, stop))) {
+      terms.backward++;
+    }
+
+    // Will become passed if the helpers trade off the enemy sentries
+    Bitboard sentries = theirs & (adjacent & front);
+    if (!doubled && !opposed && neighbours.count() >= sentries.count()) {
+      terms.candidate++;
+    }
+  }
+
+  return terms;
+}
+
+KingPawnTerms countKingPawnTerms(Bitboard ours, Bitboard theirs, Color us,
+                                 Square king) {
+  KingPawnTerms terms;
+
+  int file = king.file();
+  int rank = king.rank();
+  uint64_t files = fileMask(file) | adjacentFilesMask(file);
+  uint64_t front = forwardRanksMask(us, rank);
+
+  // Ranks further than `distance` in front of the king
+  auto beyond = [&](int distance) {
+    int limit = us == Color::WHITE ? rank + distance : rank - distance;
+    return limit < 0 || limit > 7 ? 0 : forwardRanksMask(us, limit);
+  };
+
+  terms.shield = (ours & (files & front & ~beyond(2))).count();
+  terms.storm = (theirs & (files & front & ~beyond(3))).count();
+  return terms;
+}
+
+int kingShelterScore(const Board& board, Color us) {
+  KingPawnTerms terms =
+      countKingPawnTerms(board.pieces(PieceType::PAWN, us),
+                         board.pieces(PieceType::PAWN, ~us), us, board.kingSq(us));
+  return terms.shield * PAWN_SHIELD + terms.storm * PAWN_STORM;
+}
+
+int pawnStructureScore(const Board& board) {
+  Bitboard white = board.pieces(PieceType::PAWN, Color::WHITE);
+  Bitboard black = board.pieces(PieceType::PAWN, Color::BLACK);
+
+  return scoreTerms(countPawnTerms(white, black, Color::WHITE)) -
+         scoreTerms(countPawnTerms(black, white, Color::BLACK));
+}
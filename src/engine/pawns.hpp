@@ -0,0 +1,62 @@
+#ifndef PAWNS_HPP
+#define PAWNS_HPP
+
+#include <cstdint>
+
+#include "../chess-library/include/chess.hpp"
+
+using namespace chess;
+
+/*
+ * Pawn structure
+ *
+ * The pawn terms only depend on the pawns, so their score is cached in a
+ * pawn hash table indexed by Board::pawnKey(). The pawns rarely change
+ * during a search and almost every lookup is a hit. The pawns in front of
+ * each king are cached in the same entry, together with the king square
+ * they were counted for.
+ */
+
+// Number of pawns of one side with each property, the tuner uses the counts
+// as coefficients
+struct PawnTerms {
+  int doubled = 0;    // Another pawn of the same side in front on the file
+  int isolated = 0;   // No pawn of the same side on the adjacent files
+  int backward = 0;   // Behind its neighbours and the stop square is attacked
+  int connected = 0;  // Defended by a pawn or next to one on the same rank
+  int candidate = 0;  // Open file, at least as many helpers as sentries
+  int passed[8] = {};  // Passed pawns by rank from the side's point of view
+};
+
+PawnTerms countPawnTerms(Bitboard ours, Bitboard theirs, Color us);
+
+// Score of both sides' pawn terms from whites side
+int pawnStructureScore(const Board& board);
+
+// Pawns on the king's file and the files next to it, the tuner uses the
+// counts as coefficients
+struct KingPawnTerms {
+  int shield = 0;  // Own pawns one or two ranks in front of the king
+  int storm = 0;   // Enemy pawns up to three ranks in front of the king
+};
+
+KingPawnTerms countKingPawnTerms(Bitboard ours, Bitboard theirs, Color us,
+                                 Square king);
+
+// Score of the pawns around the king of `us`, from that side
+int kingShelterScore(const Board& board, Color us);
+
+struct PawnEntry {
+  uint64_t key;  // Board::pawnKey(), 0 for no pawns which also scores 0
+  int score;     // From whites side
+
+  // Shelter score of each side's king, valid while the king stands on
+  // kingSquare. NO_SQ when the pawns were not counted yet.
+  Square kingSquare[2];
+  int kingShelter[2];
+};
+
+// Number of entries, a power of two
+constexpr size_t PAWN_HASH_ENTRIES = 1 << 14;
+
+#endif
@@ -0,0 +1,105 @@
+#include "pbin.hpp"
+
+#include <cstring>
+
+PbinRecord PbinRecord::fromBoard(const Board& board, int score, Move bestMove,
+                                 PbinResult result) {
+  PbinRecord record;
+  record.board = Board::Compact::encode(board);
+  record.score = static_cast<int16_t>(std::clamp(score, -32000, 32000));
+  record.bestMove = bestMove.move();
+  record.result = result;
+  record.halfMoves = static_cast<uint8_t>(board.halfMoveClock());
+  record.fullMoves = static_cast<uint16_t>(board.fullMoveNumber());
+  return record;
+}
+
+Board PbinRecord::toBoard() const { return Board::Compact::decode(board); }
+
+PbinWriter::PbinWriter(const std::string& path, size_t bufferedRecords)
+    : file(path, std::ios::binary | std::ios::app),
+      capacity(bufferedRecords) {
+  buffer.reserve(capacity);
+  if (!file.is_open()) return;
+
+  // Only a new file gets a header
+  file.seekp(0, std::ios::end);
+  if (file.tellp() == 0) {
+    file.write(PBIN_MAGIC, sizeof(PBIN_MAGIC));
+    file.write(reinterpret_cast<const char*>(&PBIN_VERSION),
+               sizeof(PBIN_VERSION));
+  }
+}
+
+PbinWriter::~PbinWriter() { flush(); }
+
+void PbinWriter::write(const PbinRecord& record) {
+  buffer.push_back(record);
+  if (buffer.size() >= capacity) flush();
+}
+
+void PbinWriter::write(const PbinRecord* records, size_t count) {
+  // Large blocks bypass the buffer
+  if (count >= capacity) {
+    flush();
+    file.write(reinterpret_cast<const char*>(records),
+               count * sizeof(PbinRecord));
+    written += count;
+    return;
+  }
+
+  buffer.insert(buffer.end(), records, records + count);
+  if (buffer.size() >= capacity) flush();
+}
+
+void PbinWriter::write(const Board* boards, const int16_t* scores,
+                       const Move* bestMoves, size_t count,
+                       PbinResult result) {
+  std::vector<PackedBoard> packed(count);
+  Board::Compact::encode(boards, count, packed.data());
+
+  for (size_t i = 0; i < count; i++) {
+    PbinRecord record;
+    record.board = packed[i];
+    record.score = scores[i];
+    record.bestMove = bestMoves[i].move();
+    record.result = result;
+    record.halfMoves = static_cast<uint8_t>(boards[i].halfMoveClock());
+    record.fullMoves = static_cast<uint16_t>(boards[i].fullMoveNumber());
+    write(record);
+  }
+}
+
+void PbinWriter::flush() {
+  if (buffer.empty() || !file.is_open()) return;
+
+  file.write(reinterpret_cast<const char*>(buffer.data()),
+             buffer.size() * sizeof(PbinRecord));
+  file.flush();
+  written += buffer.size();
+  buffer.clear();
+}
+
+PbinReader::PbinReader(const std::string& path, size_t bufferedRecords)
+    : file(path, std::ios::binary), buffer(bufferedRecords) {
+  if (!file.is_open()) return;
+
+  char magic[sizeof(PBIN_MAGIC)];
+  uint32_t version = 0;
+  file.read(magic, sizeof(magic));
+  file.read(reinterpret_cast<char*>(&version), sizeof(version));
+
+  valid = file.good() && std::memcmp(magic, PBIN_MAGIC, sizeof(magic)) == 0 &&
+          version == PBIN_VERSION;
+}
+
+size_t PbinReader::next(const PbinRecord*& records) {
+  if (!valid) return 0;
+
+  file.read(reinterpret_cast<char*>(buffer.data()),
+            buffer.size() * sizeof(PbinRecord));
+  size_t count = file.gcount() / sizeof(PbinRecord);
+
+  records = buffer.data();
+  return count;
+}
@@ -0,0 +1,89 @@
+#ifndef PBIN_HPP
+#define PBIN_HPP
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "../chess-library/include/chess.hpp"
+
+using namespace chess;
+
+/*
+ * .pbin position files
+ *
+ * An 8 byte header ("PBIN" + format version) followed by fixed size 32 byte
+ * records. New records are only ever appended, so several runs can write
+ * into the same file. Records are stored in the native (little endian)
+ * byte order.
+ */
+
+constexpr char PBIN_MAGIC[4] = {'P', 'B', 'I', 'N'};
+constexpr uint32_t PBIN_VERSION = 1;
+
+// Game result from whites point of view
+enum class PbinResult : int8_t { BLACK_WIN = -1, DRAW = 0, WHITE_WIN = 1 };
+
+struct PbinRecord {
+  PackedBoard board;   // Board::Compact encoding
+  int16_t score;       // Search score from the side to move
+  uint16_t bestMove;   // Move::move() of the best move
+  PbinResult result;   // Final game result
+  uint8_t halfMoves;   // Half move clock
+  uint16_t fullMoves;  // Full move number
+
+  static PbinRecord fromBoard(const Board& board, int score, Move bestMove,
+                              PbinResult result);
+  Board toBoard() const;
+};
+
+static_assert(sizeof(PbinRecord) == 32, "PbinRecord must stay 32 bytes");
+
+/* Appends records to a .pbin file through an in-memory buffer */
+class PbinWriter {
+ private:
+  std::ofstream file;
+  std::vector<PbinRecord> buffer;
+  size_t capacity;
+  uint64_t written = 0;
+
+ public:
+  explicit PbinWriter(const std::string& path, size_t bufferedRecords = 4096);
+  ~PbinWriter();
+
+  PbinWriter(const PbinWriter&) = delete;
+  PbinWriter& operator=(const PbinWriter&) = delete;
+
+  bool isOpen() const { return file.is_open(); }
+
+  void write(const PbinRecord& record);
+  void write(const PbinRecord* records, size_t count);
+
+  // Encodes the boards as a batch and writes one record per board
+  void write(const Board* boards, const int16_t* scores, const Move* bestMoves,
+             size_t count, PbinResult result);
+
+  void flush();
+
+  uint64_t recordsWritten() const { return written; }
+};
+
+/* Reads a .pbin file in large blocks, records are handed out as views into
+ * the internal buffer which stay valid until the next call to next() */
+class PbinReader {
+ private:
+  std::ifstream file;
+  std::vector<PbinRecord> buffer;
+  bool valid = false;
+
+ public:
+  explicit PbinReader(const std::string& path, size_t bufferedRecords = 65536);
+
+  bool isOpen() const { return valid; }
+
+  // Returns the number of records in the block, 0 at the end of the file
+  size_t next(const PbinRecord*& records);
+};
+
+#endif
@@ -0,0 +1,57 @@
+#include "pgn-reader.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+std::vector<std::string_view> splitPgnGames(std::string_view data,
+                                            size_t parts) {
+  std::vector<std::string_view> chunks;
+  size_t begin = 0;
+
+  for (size_t i = 1; i < parts && begin < data.size(); i++) {
+    size_t target = std::max(begin + 1, data.size() * i / parts);
+    size_t end = data.find("\n[Event ", target);
+    if (end == std::string_view::npos) break;
+
+    end++;
+    chunks.push_back(data.substr(begin, end - begin));
+    begin = end;
+  }
+
+  if (begin < data.size()) chunks.push_back(data.substr(begin));
+  return chunks;
+}
+
+size_t readPgnParallel(std::string_view data,
+                       const std::vector<pgn::Visitor*>& visitors,
+                       size_t chunksPerThread) {
+  if (visitors.empty()) return 0;
+
+  // More chunks than threads, so a thread with slow games does not hold up
+  // the rest
+  auto chunks = splitPgnGames(data, visitors.size() * chunksPerThread);
+  std::atomic<size_t> nextChunk{0};
+  std::atomic<size_t> failedChunks{0};
+
+  auto parseChunks = [&](pgn::Visitor& visitor) {
+    for (size_t i = nextChunk++; i < chunks.size(); i = nextChunk++) {
+      try {
+        pgn::StreamParser parser(chunks[i]);
+        parser.readGames(visitor);
+      } catch (const std::exception&) {
+        failedChunks++;
+      }
+    }
+  };
+
+  // The calling thread takes the first visitor
+  std::vector<std::thread> workers;
+  for (size_t t = 1; t < visitors.size(); t++) {
+    workers.emplace_back(parseChunks, std::ref(*visitors[t]));
+  }
+  parseChunks(*visitors[0]);
+  for (auto& worker : workers) worker.join();
+
+  return failedChunks;
+}
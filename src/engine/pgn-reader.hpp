@@ -0,0 +1,31 @@
+#ifndef PGN_READER_HPP
+#define PGN_READER_HPP
+
+#include <string_view>
+#include <vector>
+
+#include "../chess-library/include/chess.hpp"
+
+using namespace chess;
+
+/*
+ * Parallel PGN parsing
+ *
+ * The text (normally a memory mapped file) is cut into chunks at game
+ * boundaries and every thread runs its own pgn::StreamParser over the
+ * chunks it takes, reading the text in place. Each thread has its own
+ * visitor, so visitors need no locking but only see part of the games.
+ */
+
+// Cuts the text into about `parts` chunks. Every chunk but the first starts
+// at an [Event tag at the beginning of a line, so no game is split.
+std::vector<std::string_view> splitPgnGames(std::string_view data,
+                                            size_t parts);
+
+// Parses the text with one thread per visitor. An invalid game ends the
+// chunk it is in, returns the number of chunks that ended early.
+size_t readPgnParallel(std::string_view data,
+                       const std::vector<pgn::Visitor*>& visitors,
+                       size_t chunksPerThread = 16);
+
+#endif
@@ -1,56 +1,136 @@
 #ifndef PIECE_VALUES_HPP
 #define PIECE_VALUES_HPP
 
+// Evaluation parameters, pawnstar-tune writes this file. The
+// piece-square tables are from whites side with the 8th rank first.
+
+// Material values
+constexpr int PAWN_VALUE = 100;
+constexpr int KNIGHT_VALUE = 300;
+constexpr int BISHOP_VALUE = 320;
+constexpr int ROOK_VALUE = 500;
+constexpr int QUEEN_VALUE = 900;
+
+// Imbalance, knights gain and rooks lose value with more own pawns
+constexpr int BISHOP_PAIR_BONUS = 30;
+constexpr int KNIGHT_PAWN_ADJUST = 6;  // Per knight and pawn above five
+constexpr int ROOK_PAWN_ADJUST = -12;  // Per rook and pawn above five
+
+// Bonus per legal move
+constexpr int MOBILITY_WEIGHT = 5;
+
+// Endgame bonus for the opponent king standing in a corner or on an edge
+constexpr int KING_CORNER_BONUS = 50;
+constexpr int KING_EDGE_BONUS = 30;
+
+// Pawn structure, per pawn
+constexpr int DOUBLED_PAWN = -12;
+constexpr int ISOLATED_PAWN = -10;
+constexpr int BACKWARD_PAWN = -8;
+constexpr int CONNECTED_PAWN = 6;
+constexpr int CANDIDATE_PAWN = 8;
+
+// Passed pawn bonus by rank from the pawn's side
+constexpr int PASSED_PAWN_BONUS[8] = {0, 5, 10, 15, 25, 40, 60, 0};
+
+// Pawns around the own king in the middle game, per pawn
+constexpr int PAWN_SHIELD = 12;
+constexpr int PAWN_STORM = -8;
+
+// Middle game bonus for attacking the enemy king zone, by attack units
+constexpr int KING_SAFETY_TABLE[64] = {
+       0,    0,    1,    2,    3,    4,    6,    8,
+      11,   14,   17,   20,   24,   28,   33,   38,
+      43,   48,   54,   60,   67,   74,   81,   88,
+      96,  104,  113,  122,  131,  140,  150,  160,
+     171,  182,  193,  204,  216,  228,  241,  254,
+     267,  280,  294,  308,  323,  338,  353,  368,
+     384,  400,  417,  434,  451,  468,  486,  500,
+     500,  500,  500,  500,  500,  500,  500,  500
+};
+
+// Pawn piece-square table
 constexpr int PAWN_TABLE[64] = {
-    0,  0,  0,  0,   0,   0,  0,  0,  50, 50, 50,  50, 50, 50,  50, 50,
-    10, 10, 20, 30,  30,  20, 10, 10, 5,  5,  10,  25, 25, 10,  5,  5,
-    0,  0,  0,  20,  20,  0,  0,  0,  5,  -5, -10, 0,  0,  -10, -5, 5,
-    5,  10, 10, -20, -20, 10, 10, 5,  0,  0,  0,   0,  0,  0,   0,  0};
+       0,    0,    0,    0,    0,    0,    0,    0,
+      50,   50,   50,   50,   50,   50,   50,   50,
+      10,   10,   20,   30,   30,   20,   10,   10,
+       5,    5,   10,   25,   25,   10,    5,    5,
+       0,    0,    0,   20,   20,    0,    0,    0,
+       5,   -5,  -10,    0,    0,  -10,   -5,    5,
+       5,   10,   10,  -20,  -20,   10,   10,    5,
+       0,    0,    0,    0,    0,    0,    0,    0
+};
 
 // Knight piece-square table
 constexpr int KNIGHT_TABLE[64] = {
-    -50, -40, -30, -30, -30, -30, -40, -50, -40, -20, 0,   0,   0,
-    0,   -20, -40, -30, 0,   10,  15,  15,  10,  0,   -30, -30, 5,
-    15,  20,  20,  15,  5,   -30, -30, 0,   15,  20,  20,  15,  0,
-    -30, -30, 5,   10,  15,  15,  10,  5,   -30, -40, -20, 0,   5,
-    5,   0,   -20, -40, -50, -40, -30, -30, -30, -30, -40, -50};
+     -50,  -40,  -30,  -30,  -30,  -30,  -40,  -50,
+     -40,  -20,    0,    0,    0,    0,  -20,  -40,
+     -30,    0,   10,   15,   15,   10,    0,  -30,
+     -30,    5,   15,   20,   20,   15,    5,  -30,
+     -30,    0,   15,   20,   20,   15,    0,  -30,
+     -30,    5,   10,   15,   15,   10,    5,  -30,
+     -40,  -20,    0,    5,    5,    0,  -20,  -40,
+     -50,  -40,  -30,  -30,  -30,  -30,  -40,  -50
+};
 
 // Bishop piece-square table
 constexpr int BISHOP_TABLE[64] = {
-    -20, -10, -10, -10, -10, -10, -10, -20, -10, 0,   0,   0,   0,
-    0,   0,   -10, -10, 0,   10,  10,  10,  10,  0,   -10, -10, 5,
-    5,   10,  10,  5,   5,   -10, -10, 0,   5,   10,  10,  5,   0,
-    -10, -10, 5,   5,   5,   5,   5,   5,   -10, -10, 0,   5,   0,
-    0,   5,   0,   -10, -20, -10, -10, -10, -10, -10, -10, -20};
+     -20,  -10,  -10,  -10,  -10,  -10,  -10,  -20,
+     -10,    0,    0,    0,    0,    0,    0,  -10,
+     -10,    0,   10,   10,   10,   10,    0,  -10,
+     -10,    5,    5,   10,   10,    5,    5,  -10,
+     -10,    0,    5,   10,   10,    5,    0,  -10,
+     -10,    5,    5,    5,    5,    5,    5,  -10,
+     -10,    0,    5,    0,    0,    5,    0,  -10,
+     -20,  -10,  -10,  -10,  -10,  -10,  -10,  -20
+};
 
 // Rook piece-square table
-constexpr int ROOK_TABLE[64] = {0,  0,  0, 0,  0, 0,  0,  0, 5,  10, 10, 10, 10,
-                                10, 10, 5, -5, 0, 0,  0,  0, 0,  0,  -5, -5, 0,
-                                0,  0,  0, 0,  0, -5, -5, 0, 0,  0,  0,  0,  0,
-                                -5, -5, 0, 0,  0, 0,  0,  0, -5, -5, 0,  0,  0,
-                                0,  0,  0, -5, 0, 0,  0,  5, 5,  0,  0,  0};
+constexpr int ROOK_TABLE[64] = {
+       0,    0,    0,    0,    0,    0,    0,    0,
+       5,   10,   10,   10,   10,   10,   10,    5,
+      -5,    0,    0,    0,    0,    0,    0,   -5,
+      -5,    0,    0,    0,    0,    0,    0,   -5,
+      -5,    0,    0,    0,    0,    0,    0,   -5,
+      -5,    0,    0,    0,    0,    0,    0,   -5,
+      -5,    0,    0,    0,    0,    0,    0,   -5,
+       0,    0,    0,    5,    5,    0,    0,    0
+};
 
 // Queen piece-square table
 constexpr int QUEEN_TABLE[64] = {
-    -20, -10, -10, -5, -5, -10, -10, -20, -10, 0,   0,   0,  0,  0,   0,   -10,
-    -10, 0,   5,   5,  5,  5,   0,   -10, -5,  0,   5,   5,  5,  5,   0,   -5,
-    0,   0,   5,   5,  5,  5,   0,   -5,  -10, 5,   5,   5,  5,  5,   0,   -10,
-    -10, 0,   5,   0,  0,  0,   0,   -10, -20, -10, -10, -5, -5, -10, -10, -20};
+     -20,  -10,  -10,   -5,   -5,  -10,  -10,  -20,
+     -10,    0,    0,    0,    0,    0,    0,  -10,
+     -10,    0,    5,    5,    5,    5,    0,  -10,
+      -5,    0,    5,    5,    5,    5,    0,   -5,
+       0,    0,    5,    5,    5,    5,    0,   -5,
+     -10,    5,    5,    5,    5,    5,    0,  -10,
+     -10,    0,    5,    0,    0,    0,    0,  -10,
+     -20,  -10,  -10,   -5,   -5,  -10,  -10,  -20
+};
 
 // King middle game piece-square table
 constexpr int KING_MIDDLE_TABLE[64] = {
-    -30, -40, -40, -50, -50, -40, -40, -30, -30, -40, -40, -50, -50,
-    -40, -40, -30, -30, -40, -40, -50, -50, -40, -40, -30, -30, -40,
-    -40, -50, -50, -40, -40, -30, -20, -30, -30, -40, -40, -30, -30,
-    -20, -10, -20, -20, -20, -20, -20, -20, -10, 20,  20,  0,   0,
-    0,   0,   20,  20,  20,  30,  10,  0,   0,   10,  30,  20};
+     -30,  -40,  -40,  -50,  -50,  -40,  -40,  -30,
+     -30,  -40,  -40,  -50,  -50,  -40,  -40,  -30,
+     -30,  -40,  -40,  -50,  -50,  -40,  -40,  -30,
+     -30,  -40,  -40,  -50,  -50,  -40,  -40,  -30,
+     -20,  -30,  -30,  -40,  -40,  -30,  -30,  -20,
+     -10,  -20,  -20,  -20,  -20,  -20,  -20,  -10,
+      20,   20,    0,    0,    0,    0,   20,   20,
+      20,   30,   10,    0,    0,   10,   30,   20
+};
 
 // King end game piece-square table
 constexpr int KING_END_TABLE[64] = {
-    -50, -40, -30, -20, -20, -30, -40, -50, -30, -20, -10, 0,   0,
-    -10, -20, -30, -30, -10, 20,  30,  30,  20,  -10, -30, -30, -10,
-    30,  40,  40,  30,  -10, -30, -30, -10, 30,  40,  40,  30,  -10,
-    -30, -30, -10, 20,  30,  30,  20,  -10, -30, -30, -30, 0,   0,
-    0,   0,   -30, -30, -50, -30, -30, -30, -30, -30, -30, -50};
+     -50,  -40,  -30,  -20,  -20,  -30,  -40,  -50,
+     -30,  -20,  -10,    0,    0,  -10,  -20,  -30,
+     -30,  -10,   20,   30,   30,   20,  -10,  -30,
+     -30,  -10,   30,   40,   40,   30,  -10,  -30,
+     -30,  -10,   30,   40,   40,   30,  -10,  -30,
+     -30,  -10,   20,   30,   30,   20,  -10,  -30,
+     -30,  -30,    0,    0,    0,    0,  -30,  -30,
+     -50,  -30,  -30,  -30,  -30,  -30,  -30,  -50
+};
 
 #endif
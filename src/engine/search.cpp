@@ -1,16 +1,27 @@
 #include "engine.hpp"
 
-void Engine::orderMoves(Movelist& moves) {
-  std::vector<std::pair<Move, int>> scoredMoves;
-  scoredMoves.reserve(moves.size());
+void Engine::makeSearchMove(Move move, Board::Position& saved) {
+  if (copyMake) saved = board.position();
+  board.makeMove(move);
+}
+
+void Engine::unmakeSearchMove(Move move, const Board::Position& saved) {
+  if (copyMake) {
+    board.unmakeMove(saved);
+  } else {
+    board.unmakeMove(move);
+  }
+}
 
-  for (const auto& move : moves) {
+// Scores and sorts the moves in the buffer they were generated into, so
+// ordering doesnot need a second list
+void Engine::orderMoves(movegen::ScoredMove* begin, movegen::ScoredMove* end) {
+  for (auto* it = begin; it != end; ++it) {
+    const Move move = it->move;
     int score = 0;  // worst queen takes pawn
 
-    // ! If we make n moves on the board for each reacursive call that is
-    // computationally heavy If we skip this step the engine will still look
-    // at all the moves but 50% performace boost with same result. So we donot
-    // need to check for checks and mates here
+    // Checks are detected from the precomputed check squares of the
+    // position, so we donot need to make the move on the board here
 
     // Prioritize captures using MVV-LVA
     if (board.isCapture(move)) {
@@ -27,52 +38,132 @@ void Engine::orderMoves(Movelist& moves) {
     if (move.promotionType() == BISHOP) score += 320;
     if (move.promotionType() == KNIGHT) score += 300;
 
-    scoredMoves.emplace_back(move, score);
+    // Checking moves go before other quiet moves
+    if (board.givesCheck(move)) score += 50;
+
+    it->score = static_cast<int16_t>(score);
   }
 
   // Todo Need to learn this sorting magic function ask gpt for now
   // Sort moves by descending score
-  std::sort(scoredMoves.begin(), scoredMoves.end(),
-            [](const auto& a, const auto& b) { return a.second > b.second; });
+  std::sort(begin, end,
+            [](const auto& a, const auto& b) { return a.score > b.score; });
+}
+
+// Result of the position from the tablebases, Wdl::INVALID if it has too
+// many pieces, no table, or castling rights that the tables leave out. The
+// bitbases also leave out en passant squares. Cursed wins and blessed
+// losses are draws under the fifty move rule.
+Wdl Engine::probeTablebases() {
+  int pieces = static_cast<int>(board.occ().count());
+  if (!board.castlingRights().isEmpty()) return Wdl::INVALID;
+
+  SyzygyWdl result;
+  if (syzygy && pieces <= syzygyProbeLimit && syzygy->probeWdl(board, result)) {
+    tbHits++;
+    return result == SyzygyWdl::WIN    ? Wdl::WIN
+           : result == SyzygyWdl::LOSS ? Wdl::LOSS
+                                       : Wdl::DRAW;
+  }
 
-  // Replace original move list with sorted moves
-  moves.clear();
-  for (const auto& [move, score] : scoredMoves) {
-    moves.add(move);
+  if (!tablebases || pieces > tbProbeLimit ||
+      board.enpassantSq() != Square::underlying::NO_SQ) {
+    return Wdl::INVALID;
   }
+
+  Wdl wdl = tablebases->probe(board);
+  if (wdl != Wdl::INVALID) tbHits++;
+  return wdl;
+}
+
+// Keeps only the root moves that hold the best tablebase result, when the
+// root and all the positions after its moves have one. Returns the new end.
+// With the Syzygy tables the moves are ranked by their distance to zeroing,
+// so a won ending makes progress even where the search sees no conversion.
+movegen::ScoredMove* Engine::rankRootMoves(movegen::ScoredMove* begin,
+                                           movegen::ScoredMove* end) {
+  if (syzygy && static_cast<int>(board.occ().count()) <= syzygyProbeLimit &&
+      board.castlingRights().isEmpty()) {
+    Move moves[constants::MAX_MOVES];
+    int ranks[constants::MAX_MOVES];
+    int count = static_cast<int>(end - begin);
+    for (int i = 0; i < count; i++) moves[i] = begin[i].move;
+
+    if (syzygy->rankRootMoves(board, moves, count, ranks)) {
+      tbHits += count;
+      int best = *std::max_element(ranks, ranks + count);
+      for (int i = 0; i < count; i++) begin[i].score = ranks[i];
+
+      return std::partition(
+          begin, end, [best](const auto& move) { return move.score == best; });
+    }
+  }
+
+  if (!tablebases || probeTablebases() == Wdl::INVALID) return end;
+
+  int best = 0;
+  for (auto* it = begin; it != end; ++it) {
+    Board::Position saved;
+    makeSearchMove(it->move, saved);
+    Wdl wdl = probeTablebases();
+    unmakeSearchMove(it->move, saved);
+
+    if (wdl == Wdl::INVALID) return end;
+
+    // Results are from the opponent after the move
+    it->score = wdl == Wdl::LOSS ? 2 : wdl == Wdl::DRAW ? 1 : 0;
+    best = std::max<int>(best, it->score);
+  }
+
+  return std::partition(begin, end,
+                        [best](const auto& move) { return move.score == best; });
 }
 
 /* Extend the search to explore tactical possibilites */
 int Engine::extendedSearch(int alpha, int beta, int ply) {
   positionsSearched++;
   ply++;
-  int evaluation = evaluatePosition(board, ply);
-
-  // Alpha-beta pruning: If the evaluation is greater than or equal to beta,
-  // the minimizing player has found a move that the maximizing player would
-  // never allow. So, we prune this branch.
-  if (evaluation >= beta) return beta;
 
-  // Update alpha to track the best score found so far for the maximizing
-  // player.
-  alpha = std::max(evaluation, alpha);
+  // The stand pat comes before the move generation, so a lazy evaluation
+  // outside the window costs no moves. In check the moves are needed first
+  // to find the mates, a stalemate is only missed when the stalemated side
+  // stands at or above beta. negaMax already counted this position, so the
+  // root is two plies below `ply`.
+  bool inCheck = board.inCheck();
+  int evaluation = 0;
+  if (!inCheck) {
+    evaluation = evaluatePosition(board, ply, ply - 2, alpha, beta);
+
+    // Alpha-beta pruning: If the evaluation is greater than or equal to
+    // beta, the minimizing player has found a move that the maximizing
+    // player would never allow. So, we prune this branch.
+    if (evaluation >= beta) return beta;
+  }
 
-  Movelist moves;
-  movegen::legalmoves(moves, board);
+  Move moves[constants::MAX_MOVES];
+  Move* movesEnd = movegen::generate(board, moves);
 
-  if (moves.empty()) {
-    if (board.inCheck()) {
+  if (movesEnd == moves) {
+    if (inCheck) {
       return -MATE_SCORE + ply;
     } else {
       return 0;
     }
   }
 
-  for (const auto& move : moves) {
-    board.makeMove(move);
-    bool inCheck = board.inCheck();
-    board.unmakeMove(move);
-    if (!board.isCapture(move) || !inCheck)
+  if (inCheck) {
+    evaluation = evaluatePosition(board, ply, ply - 2, alpha, beta);
+    if (evaluation >= beta) return beta;
+  }
+
+  // Update alpha to track the best score found so far for the maximizing
+  // player.
+  alpha = std::max(evaluation, alpha);
+
+  for (const Move* it = moves; it != movesEnd; ++it) {
+    const Move move = *it;
+    bool givesCheck = board.givesCheck(move);
+    if (!board.isCapture(move) || !givesCheck)
       continue;  // Only consider captures in quiescence search.
 
     // The following line is really necessary. I donot know if it is the best
@@ -92,12 +183,17 @@ int Engine::extendedSearch(int alpha, int beta, int ply) {
     }
 
   makeMove:
-    board.makeMove(move);
+    Board::Position saved;
+    makeSearchMove(move, saved);
     // Negamax with alpha-beta pruning: The roles of alpha and beta are
     // swapped because each layer alternates between maximizing and
     // minimizing.
-    int score = -evaluatePosition(board, ply);
-    board.unmakeMove(move);
+    // Every move searched here gives check, so it may also be mate
+    Move replies[constants::MAX_MOVES];
+    int score = movegen::generate(board, replies) == replies
+                    ? MATE_SCORE - ply
+                    : -evaluatePosition(board, ply, ply - 1, -beta, -alpha);
+    unmakeSearchMove(move, saved);
 
     // Beta cutoff: If we find a move better than beta for the maximizing
     // player, the minimizing player will never allow this position, so we
@@ -117,8 +213,31 @@ int Engine::negaMax(int depth, int alpha, int beta, int ply) {
   positionsSearched++;
   ply++;
 
-  if (isGameOver()) {
-    return evaluatePosition(board, ply);
+  // Out of nodes, the caller throws the whole iteration away
+  if (nodeLimit && positionsSearched >= nodeLimit) {
+    searchStopped = true;
+    return 0;
+  }
+
+  // Distance from the root, the root itself is searched in getBestMove
+  int rootDistance = ply - 1;
+
+  // Rule based draws are detected without generating the moves, a single
+  // repetition inside the search path already counts as a draw
+  if (board.isHalfMoveDraw()) {
+    return board.getHalfMoveDrawType().first == GameResultReason::CHECKMATE
+               ? -MATE_SCORE + ply
+               : 0;
+  }
+
+  if (board.isInsufficientMaterial() || board.isRepetitionDraw(rootDistance)) {
+    return 0;
+  }
+
+  // If we can repeat an earlier position we can at least hold the draw
+  if (alpha < 0 && board.hasUpcomingRepetition(rootDistance)) {
+    alpha = 0;
+    if (alpha >= beta) return alpha;
   }
 
   // Check the tts for matches
@@ -130,41 +249,57 @@ int Engine::negaMax(int depth, int alpha, int beta, int ply) {
     return ttScore;
   }
 
+  // The tables only know if a position is won, not how to make progress.
+  // They are probed right after captures and pawn moves, so inside a won
+  // ending the search still looks for the next conversion.
+  if (board.halfMoveClock() == 0) {
+    Wdl wdl = probeTablebases();
+    if (wdl == Wdl::WIN) return TB_WIN_SCORE - ply;
+    if (wdl == Wdl::LOSS) return -TB_WIN_SCORE + ply;
+    if (wdl == Wdl::DRAW) return 0;
+  }
+
   if (depth <= 0) {
     int eval = extendedSearch(alpha, beta, ply);
     return eval;
   }
 
-  Movelist moves;
-  movegen::legalmoves(moves, board);
+  // Moves are generated straight into this frame's buffer
+  movegen::ScoredMove moves[constants::MAX_MOVES];
+  movegen::ScoredMove* movesEnd = movegen::generate(board, moves);
 
-  if (moves.empty()) {
-    return evaluatePosition(board, ply);
+  if (movesEnd == moves) {
+    return board.inCheck() ? -MATE_SCORE + ply : 0;
   }
 
   // If we got a move from TT, try that first
   if (ttMove != Move::NULL_MOVE) {
     // Check for safety if the tt move is in the list
-    for (size_t i = 0; i < moves.size(); i++) {
-      if (moves[i] == ttMove) {
-        std::swap(moves[0], moves[i]);
+    for (auto* it = moves; it != movesEnd; ++it) {
+      if (it->move == ttMove) {
+        std::swap(moves[0], *it);
         break;
       }
     }
   } else {
-    orderMoves(moves);
+    orderMoves(moves, movesEnd);
   }
 
   int maxScore = -MATE_SCORE;  // Should be defined as a very negative number
   Move bestMove = Move::NULL_MOVE;
   TTEntryType entryType = TTEntryType::UPPER;
 
-  for (const auto& move : moves) {
-    board.makeMove(move);
+  for (const auto* it = moves; it != movesEnd; ++it) {
+    const Move move = it->move;
+    Board::Position saved;
+    makeSearchMove(move, saved);
     int score = -negaMax(depth - 1, -beta, -alpha, ply);
 
     // std::cout << "Move: " << uci::moveToUci(move) << " " << score << "\n";
-    board.unmakeMove(move);
+    unmakeSearchMove(move, saved);
+
+    // Scores of a stopped search are not stored in the tt
+    if (searchStopped) return 0;
 
     if (score > maxScore) {
       maxScore = score;
@@ -187,29 +322,34 @@ int Engine::negaMax(int depth, int alpha, int beta, int ply) {
   return maxScore;
 }
 
-std::string Engine::getBestMove(int depth) {
-  if (isGameOver()) {
-    return "";
-  }
+SearchResult Engine::searchRoot(int depth) {
+  SearchResult result;
 
-  Movelist moves;
-  chess::movegen::legalmoves(moves, board);
+  movegen::ScoredMove moves[constants::MAX_MOVES];
+  movegen::ScoredMove* movesEnd = movegen::generate(board, moves);
 
-  if (moves.empty()) {
-    return "";
+  if (movesEnd == moves) {
+    return result;
   }
 
-  orderMoves(moves);
-
   positionsSearched = 0;
-  Move bestMove = moves[0];
+  tbHits = 0;
+
+  movesEnd = rankRootMoves(moves, movesEnd);
+  orderMoves(moves, movesEnd);
+
+  Move bestMove = moves[0].move;
   int bestScore = -MATE_SCORE;
 
-  for (const auto& move : moves) {
-    board.makeMove(move);
+  for (const auto* it = moves; it != movesEnd; ++it) {
+    const Move move = it->move;
+    Board::Position saved;
+    makeSearchMove(move, saved);
 
     int score = -negaMax(depth - 1, -MATE_SCORE, MATE_SCORE, 1);
-    board.unmakeMove(move);
+    unmakeSearchMove(move, saved);
+
+    if (searchStopped) break;
 
     if (score > bestScore) {
       bestScore = score;
@@ -217,7 +357,61 @@ std::string Engine::getBestMove(int depth) {
     }
   }
 
-  std::cout << "info depth 4 score cp " << bestScore << "\n";
+  result.bestMove = bestMove;
+  result.score = bestScore;
+  result.depth = depth;
+  result.nodes = positionsSearched;
+  result.tbHits = tbHits;
+  return result;
+}
+
+SearchResult Engine::searchNodes(int limit, int maxDepth) {
+  SearchResult result;
+  int nodes = 0;
+  int hits = 0;
+
+  // Depth 1 always runs to the end so there is a move to play. Deeper
+  // iterations get the nodes that are left and are thrown away when they
+  // run out before finishing.
+  for (int depth = 1; depth <= maxDepth && nodes < limit; depth++) {
+    nodeLimit = depth == 1 ? 0 : limit - nodes;
+    searchStopped = false;
+
+    SearchResult iteration = searchRoot(depth);
+    nodes += iteration.nodes;
+    hits += iteration.tbHits;
+
+    if (searchStopped) break;
+    result = iteration;
+    if (result.bestMove == Move::NO_MOVE) break;
+  }
+
+  nodeLimit = 0;
+  searchStopped = false;
+
+  result.nodes = nodes;
+  result.tbHits = hits;
+  return result;
+}
+
+std::string Engine::getBestMove(int depth) {
+  if (isGameOver()) {
+    return "";
+  }
+
+  SearchResult result = searchRoot(depth);
+  if (result.bestMove == Move::NO_MOVE) {
+    return "";
+  }
+
+  Move bestMove = result.bestMove;
+  int bestScore = result.score;
+
+  if (printInfo) {
+    std::cout << "info depth 4 score cp " << bestScore;
+    if (tablebases || syzygy) std::cout << " tbhits " << result.tbHits;
+    std::cout << "\n";
+  }
 
   // ! Fix this uci format mate distance reporting
   // if (std::abs(bestScore) > MATE_SCORE - 100) {  // It's a mate score
@@ -0,0 +1,981 @@
+#include "syzygy.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <map>
+
+namespace {
+
+#ifdef _WIN32
+constexpr char PATH_SEPARATOR = ';';
+#else
+constexpr char PATH_SEPARATOR = ':';
+#endif
+
+constexpr uint8_t WDL_MAGIC[4] = {0x71, 0xE8, 0x23, 0x5D};
+constexpr uint8_t DTZ_MAGIC[4] = {0xD7, 0x66, 0x0C, 0xA5};
+
+// Flags of the first header byte
+constexpr uint8_t TB_SPLIT = 1;  // Both sides to move are stored
+constexpr uint8_t TB_HAS_PAWNS = 2;
+
+// Flags of the pairs data of a table
+constexpr uint8_t TB_STM = 1;  // Side to move of a DTZ table
+constexpr uint8_t TB_MAPPED = 2;
+constexpr uint8_t TB_WIN_PLIES = 4;
+constexpr uint8_t TB_LOSS_PLIES = 8;
+constexpr uint8_t TB_WIDE = 16;
+constexpr uint8_t TB_SINGLE_VALUE = 128;
+
+// Map of a DTZ table used for each result, from LOSS to WIN
+constexpr int WDL_TO_MAP[5] = {1, 3, 0, 2, 0};
+
+template <typename T>
+T readLittle(const uint8_t* bytes) {
+  T value = 0;
+  for (size_t i = 0; i < sizeof(T); i++) {
+    value |= static_cast<T>(bytes[i]) << (8 * i);
+  }
+  return value;
+}
+
+template <typename T>
+T readBig(const uint8_t* bytes) {
+  T value = 0;
+  for (size_t i = 0; i < sizeof(T); i++) value = (value << 8) | bytes[i];
+  return value;
+}
+
+// Distance of a square above the a1-h8 diagonal, negative below it
+int offA1H8(int sq) { return (sq >> 3) - (sq & 7); }
+
+// Pieces as stored in the tables, 1 to 6 for the white pawn to king and
+// 9 to 14 for the black ones
+int pieceCode(Piece piece) {
+  return static_cast<int>(piece.type()) + 1 +
+         (piece.color() == Color::BLACK ? 8 : 0);
+}
+
+SyzygyWdl operator-(SyzygyWdl wdl) {
+  return static_cast<SyzygyWdl>(-static_cast<int>(wdl));
+}
+
+int sign(int value) { return (value > 0) - (value < 0); }
+
+// Distance to zeroing of a position whose best move is a capture or a pawn
+// move with this result
+int dtzBeforeZeroing(SyzygyWdl wdl) {
+  switch (wdl) {
+    case SyzygyWdl::WIN:
+      return 1;
+    case SyzygyWdl::CURSED_WIN:
+      return 101;
+    case SyzygyWdl::BLESSED_LOSS:
+      return -101;
+    case SyzygyWdl::LOSS:
+      return -1;
+    default:
+      return 0;
+  }
+}
+
+// Index maps of the encoding, shared by all tables
+struct IndexTables {
+  int mapB1H1H7[64] = {};  // Squares below the a1-h8 diagonal to 0..27
+  int mapA1D1D4[64] = {};  // The a1-d1-d4 triangle to 0..9, diagonal last
+  int mapKK[10][64] = {};  // The 462 placements of two kings
+  uint64_t binomial[MAX_SYZYGY_PIECES][64] = {};
+  int mapPawns[64] = {};  // a2-h7 to 0..47, edge files and low ranks first
+  int leadPawnIdx[MAX_SYZYGY_PIECES][64] = {};
+  int leadPawnsSize[MAX_SYZYGY_PIECES][4] = {};
+
+  IndexTables() {
+    int code = 0;
+    for (int sq = 0; sq < 64; sq++) {
+      if (offA1H8(sq) < 0) mapB1H1H7[sq] = code++;
+    }
+
+    std::vector<int> diagonal;
+    code = 0;
+    for (int sq = 0; sq <= 27; sq++) {
+      if (offA1H8(sq) < 0 && (sq & 7) <= 3) {
+        mapA1D1D4[sq] = code++;
+      } else if (offA1H8(sq) == 0 && (sq & 7) <= 3) {
+        diagonal.push_back(sq);
+      }
+    }
+    for (int sq : diagonal) mapA1D1D4[sq] = code++;
+
+    // With the first king on the diagonal the second one is not above it,
+    // both kings on the diagonal come last
+    std::vector<std::pair<int, int>> bothOnDiagonal;
+    code = 0;
+    for (int idx = 0; idx < 10; idx++) {
+      for (int s1 = 0; s1 <= 27; s1++) {
+        if (mapA1D1D4[s1] != idx || (idx == 0 && s1 != 1)) continue;
+
+        Bitboard near = attacks::king(Square(s1)) | Bitboard::fromSquare(s1);
+        for (int s2 = 0; s2 < 64; s2++) {
+          if (near.check(s2)) continue;
+          if (offA1H8(s1) == 0 && offA1H8(s2) > 0) continue;
+
+          if (offA1H8(s1) == 0 && offA1H8(s2) == 0) {
+            bothOnDiagonal.emplace_back(idx, s2);
+          } else {
+            mapKK[idx][s2] = code++;
+          }
+        }
+      }
+    }
+    for (auto [idx, sq] : bothOnDiagonal) mapKK[idx][sq] = code++;
+
+    binomial[0][0] = 1;
+    for (int n = 1; n < 64; n++) {
+      for (int k = 0; k < MAX_SYZYGY_PIECES && k <= n; k++) {
+        binomial[k][n] = (k > 0 ? binomial[k - 1][n - 1] : 0) +
+                         (k < n ? binomial[k][n - 1] : 0);
+      }
+    }
+
+    // Tables with pawns are split by the file of the leading pawn, the one
+    // with the highest mapPawns value
+    int available = 47;
+    for (int leadPawns = 1; leadPawns < MAX_SYZYGY_PIECES - 1; leadPawns++) {
+      for (int file = 0; file < 4; file++) {
+        int idx = 0;
+        for (int rank = 1; rank <= 6; rank++) {
+          int sq = rank * 8 + file;
+          if (leadPawns == 1) {
+            mapPawns[sq] = available--;
+            mapPawns[sq ^ 7] = available--;
+          }
+          leadPawnIdx[leadPawns][sq] = idx;
+          idx += static_cast<int>(binomial[leadPawns - 1][mapPawns[sq]]);
+        }
+        leadPawnsSize[leadPawns][file] = idx;
+      }
+    }
+  }
+};
+
+const IndexTables& indexTables() {
+  static const IndexTables tables;
+  return tables;
+}
+
+// Parses a table name like "KRPvKR" into the pieces of both sides
+bool parseName(const std::string& name, std::string& white,
+               std::string& black) {
+  size_t split = name.find('v');
+  if (split == std::string::npos) return false;
+  white = name.substr(0, split);
+  black = name.substr(split + 1);
+
+  if (white.empty() || black.empty() || white[0] != 'K' || black[0] != 'K' ||
+      white.size() + black.size() > MAX_SYZYGY_PIECES) {
+    return false;
+  }
+
+  for (const auto& side : {white, black}) {
+    if (std::count(side.begin(), side.end(), 'K') != 1) return false;
+    for (char c : side) {
+      if (std::string("KQRBNP").find(c) == std::string::npos) return false;
+    }
+  }
+  return true;
+}
+
+// Material key of a board with the white and black pieces
+uint64_t materialKey(const std::string& white, const std::string& black) {
+  std::string rank = white;
+  for (char c : black) rank += static_cast<char>(std::tolower(c));
+  if (rank.size() < 8) rank += std::to_string(8 - rank.size());
+
+  return Board("8/8/8/8/8/8/" + rank + "/8 w - - 0 1").materialKey();
+}
+
+}  // namespace
+
+// Compressed values of one side to move and one leading pawn file
+struct Syzygy::PairsData {
+  uint8_t flags = 0;
+  int pieces[MAX_SYZYGY_PIECES] = {};  // Piece codes in the encoding order
+  int groupLen[MAX_SYZYGY_PIECES + 1] = {};  // Zero terminated
+  uint64_t groupIdx[MAX_SYZYGY_PIECES + 1] = {};  // The last is the size
+  uint64_t sizeofBlock = 0;
+  uint64_t span = 0;  // Values between two sparse index entries
+  uint64_t sparseIndexSize = 0;
+  uint64_t blocksNum = 0;
+  uint64_t blockLengthSize = 0;
+  int maxSymLen = 0;
+  int minSymLen = 0;  // The value itself for a single value table
+  const uint8_t* lowestSym = nullptr;  // Lowest symbol of each code length
+  const uint8_t* btree = nullptr;  // Two 12 bit halves of every symbol
+  const uint8_t* sparseIndex = nullptr;
+  const uint8_t* blockLength = nullptr;
+  const uint8_t* data = nullptr;
+  std::vector<uint64_t> base64;  // Lowest code of each length, 64 bit
+  std::vector<uint8_t> symlen;   // Values of each symbol minus one
+  uint16_t mapIdx[4] = {};       // DTZ maps of the results
+
+  // Number of indexes, the last group index
+  uint64_t size() const {
+    int n = 0;
+    while (groupLen[n]) n++;
+    return groupIdx[n];
+  }
+
+  int left(int sym) const {
+    const uint8_t* lr = btree + 3 * sym;
+    return ((lr[1] & 0xF) << 8) | lr[0];
+  }
+
+  int right(int sym) const {
+    const uint8_t* lr = btree + 3 * sym;
+    return (lr[2] << 4) | (lr[1] >> 4);
+  }
+
+  int setSymlen(int sym, std::vector<bool>& visited) {
+    visited[sym] = true;
+    int r = right(sym);
+    if (r == 0xFFF) return 0;
+
+    int l = left(sym);
+    if (!visited[l]) symlen[l] = static_cast<uint8_t>(setSymlen(l, visited));
+    if (!visited[r]) symlen[r] = static_cast<uint8_t>(setSymlen(r, visited));
+    return symlen[l] + symlen[r] + 1;
+  }
+
+  const uint8_t* setSizes(const uint8_t* bytes) {
+    flags = *bytes++;
+
+    if (flags & TB_SINGLE_VALUE) {
+      minSymLen = *bytes++;
+      return bytes;
+    }
+
+    sizeofBlock = uint64_t(1) << *bytes++;
+    span = uint64_t(1) << *bytes++;
+    sparseIndexSize = (size() + span - 1) / span;
+    int padding = *bytes++;
+    blocksNum = readLittle<uint32_t>(bytes);
+    bytes += 4;
+    blockLengthSize = blocksNum + padding;
+    maxSymLen = *bytes++;
+    minSymLen = *bytes++;
+    lowestSym = bytes;
+    base64.assign(maxSymLen - minSymLen + 1, 0);
+
+    // Canonical Huffman codes, longer codes have lower values. base64[i] is
+    // the lowest code of length minSymLen + i padded to 64 bits.
+    for (int i = static_cast<int>(base64.size()) - 2; i >= 0; i--) {
+      base64[i] = (base64[i + 1] + readLittle<uint16_t>(lowestSym + 2 * i) -
+                   readLittle<uint16_t>(lowestSym + 2 * (i + 1))) /
+                  2;
+    }
+    for (size_t i = 0; i < base64.size(); i++) {
+      base64[i] <<= 64 - i - minSymLen;
+    }
+
+    bytes += base64.size() * 2;
+    symlen.assign(readLittle<uint16_t>(bytes), 0);
+    bytes += 2;
+    btree = bytes;
+
+    std::vector<bool> visited(symlen.size());
+    for (size_t sym = 0; sym < symlen.size(); sym++) {
+      if (!visited[sym]) {
+        int length = setSymlen(static_cast<int>(sym), visited);
+        symlen[sym] = static_cast<uint8_t>(length);
+      }
+    }
+
+    return bytes + symlen.size() * 3 + (symlen.size() & 1);
+  }
+
+  // Value at the index. The sparse index points near the block holding it,
+  // the block is decoded up to the symbol covering it, and the symbol is
+  // expanded through its pairs.
+  int decompress(uint64_t index) const {
+    if (flags & TB_SINGLE_VALUE) return minSymLen;
+
+    uint64_t k = index / span;
+    const uint8_t* entry = sparseIndex + 6 * k;
+    uint32_t block = readLittle<uint32_t>(entry);
+    int offset = readLittle<uint16_t>(entry + 4);
+
+    offset += static_cast<int>(index % span) - static_cast<int>(span / 2);
+
+    while (offset < 0) {
+      offset += readLittle<uint16_t>(blockLength + 2 * --block) + 1;
+    }
+    while (offset > readLittle<uint16_t>(blockLength + 2 * block)) {
+      offset -= readLittle<uint16_t>(blockLength + 2 * block++) + 1;
+    }
+
+    const uint8_t* ptr = data + block * sizeofBlock;
+    uint64_t buf64 = readBig<uint64_t>(ptr);
+    ptr += 8;
+    int buf64Size = 64;
+    int sym;
+
+    for (;;) {
+      int len = 0;
+      while (buf64 < base64[len]) len++;
+
+      sym = static_cast<int>((buf64 - base64[len]) >> (64 - len - minSymLen));
+      sym += readLittle<uint16_t>(lowestSym + 2 * len);
+
+      if (offset < symlen[sym] + 1) break;
+
+      offset -= symlen[sym] + 1;
+      len += minSymLen;
+      buf64 <<= len;
+      buf64Size -= len;
+
+      if (buf64Size <= 32) {
+        buf64Size += 32;
+        uint64_t refill = readBig<uint32_t>(ptr);
+        buf64 |= refill << (64 - buf64Size);
+        ptr += 4;
+      }
+    }
+
+    while (symlen[sym]) {
+      int l = left(sym);
+      if (offset < symlen[l] + 1) {
+        sym = l;
+      } else {
+        offset -= symlen[l] + 1;
+        sym = right(sym);
+      }
+    }
+
+    return left(sym);
+  }
+};
+
+// The WDL and DTZ files of one material
+struct Syzygy::Table {
+  uint64_t key = 0;   // White is the side with the first pieces of the name
+  uint64_t key2 = 0;  // Colors swapped
+  int pieceCount = 0;
+  bool hasPawns = false;
+  bool hasUniquePieces = false;
+  int pawnCount[2] = {};  // Leading color first
+
+  MappedFile wdlFile;
+  MappedFile dtzFile;
+  bool hasDtz = false;
+
+  PairsData wdl[2][4];  // By side to move and leading pawn file
+  PairsData dtz[4];     // One side to move
+  const uint8_t* dtzMap = nullptr;
+
+  Table(const std::string& white, const std::string& black) {
+    key = materialKey(white, black);
+    key2 = materialKey(black, white);
+    pieceCount = static_cast<int>(white.size() + black.size());
+
+    auto pawns = [](const std::string& side) {
+      return static_cast<int>(std::count(side.begin(), side.end(), 'P'));
+    };
+    int whitePawns = pawns(white);
+    int blackPawns = pawns(black);
+    hasPawns = whitePawns + blackPawns > 0;
+
+    for (const auto& side : {white, black}) {
+      for (char c : std::string("QRBNP")) {
+        if (std::count(side.begin(), side.end(), c) == 1) {
+          hasUniquePieces = true;
+        }
+      }
+    }
+
+    // The side with fewer pawns leads, it compresses better
+    bool whiteLeads = !blackPawns || (whitePawns && blackPawns >= whitePawns);
+    pawnCount[0] = whiteLeads ? whitePawns : blackPawns;
+    pawnCount[1] = whiteLeads ? blackPawns : whitePawns;
+  }
+
+  PairsData& get(bool isDtz, int stm, int file) {
+    return isDtz ? dtz[hasPawns ? file : 0] : wdl[stm][hasPawns ? file : 0];
+  }
+
+  const PairsData& get(bool isDtz, int stm, int file) const {
+    return isDtz ? dtz[hasPawns ? file : 0] : wdl[stm][hasPawns ? file : 0];
+  }
+
+  // Sizes of the groups of pieces encoded together and their place in the
+  // index, in the order given by the table
+  void setGroups(PairsData& d, const int order[2], int file) {
+    const IndexTables& t = indexTables();
+    int n = 0;
+    int firstLen = hasPawns ? 0 : hasUniquePieces ? 3 : 2;
+    d.groupLen[n] = 1;
+
+    for (int i = 1; i < pieceCount; i++) {
+      if (--firstLen > 0 || d.pieces[i] == d.pieces[i - 1]) {
+        d.groupLen[n]++;
+      } else {
+        d.groupLen[++n] = 1;
+      }
+    }
+    d.groupLen[++n] = 0;
+
+    bool pawnsOnBothSides = hasPawns && pawnCount[1];
+    int next = pawnsOnBothSides ? 2 : 1;
+    int freeSquares =
+        64 - d.groupLen[0] - (pawnsOnBothSides ? d.groupLen[1] : 0);
+    uint64_t idx = 1;
+
+    for (int k = 0; next < n || k == order[0] || k == order[1]; k++) {
+      if (k == order[0]) {
+        d.groupIdx[0] = idx;
+        idx *= hasPawns ? t.leadPawnsSize[d.groupLen[0]][file]
+               : hasUniquePieces ? 31332
+                                 : 462;
+      } else if (k == order[1]) {
+        d.groupIdx[1] = idx;
+        idx *= t.binomial[d.groupLen[1]][48 - d.groupLen[0]];
+      } else {
+        d.groupIdx[next] = idx;
+        idx *= t.binomial[d.groupLen[next]][freeSquares];
+        freeSquares -= d.groupLen[next++];
+      }
+    }
+
+    d.groupIdx[n] = idx;
+  }
+
+  const uint8_t* setDtzMap(const uint8_t* bytes, int maxFile) {
+    dtzMap = bytes;
+
+    for (int f = 0; f <= maxFile; f++) {
+      PairsData& d = get(true, 0, f);
+      if (!(d.flags & TB_MAPPED)) continue;
+
+      if (d.flags & TB_WIDE) {
+        bytes += reinterpret_cast<uintptr_t>(bytes) & 1;
+        for (int i = 0; i < 4; i++) {
+          d.mapIdx[i] = static_cast<uint16_t>((bytes - dtzMap) / 2 + 1);
+          bytes += 2 * readLittle<uint16_t>(bytes) + 2;
+        }
+      } else {
+        for (int i = 0; i < 4; i++) {
+          d.mapIdx[i] = static_cast<uint16_t>(bytes - dtzMap + 1);
+          bytes += *bytes + 1;
+        }
+      }
+    }
+
+    return bytes + (reinterpret_cast<uintptr_t>(bytes) & 1);
+  }
+
+  // Reads the header of the mapped file, false if it is not a table of
+  // this material
+  bool init(bool isDtz) {
+    const MappedFile& file = isDtz ? dtzFile : wdlFile;
+    if (file.size() < 8 ||
+        std::memcmp(file.data(), isDtz ? DTZ_MAGIC : WDL_MAGIC, 4) != 0) {
+      return false;
+    }
+
+    const uint8_t* bytes = file.data() + 4;
+    const uint8_t* end = file.data() + file.size();
+
+    uint8_t header = *bytes++;
+    if (bool(header & TB_HAS_PAWNS) != hasPawns) return false;
+    if (!isDtz && bool(header & TB_SPLIT) != (key != key2)) return false;
+
+    int sides = !isDtz && key != key2 ? 2 : 1;
+    int maxFile = hasPawns ? 3 : 0;
+    bool pawnsOnBothSides = hasPawns && pawnCount[1];
+
+    for (int f = 0; f <= maxFile; f++) {
+      int order[2][2] = {
+          {bytes[0] & 0xF, pawnsOnBothSides ? bytes[1] & 0xF : 0xF},
+          {bytes[0] >> 4, pawnsOnBothSides ? bytes[1] >> 4 : 0xF}};
+      bytes += 1 + pawnsOnBothSides;
+
+      for (int k = 0; k < pieceCount; k++, bytes++) {
+        for (int i = 0; i < sides; i++) {
+          get(isDtz, i, f).pieces[k] = i ? *bytes >> 4 : *bytes & 0xF;
+        }
+      }
+
+      for (int i = 0; i < sides; i++) setGroups(get(isDtz, i, f), order[i], f);
+    }
+
+    bytes += reinterpret_cast<uintptr_t>(bytes) & 1;
+
+    for (int f = 0; f <= maxFile; f++) {
+      for (int i = 0; i < sides; i++) {
+        bytes = get(isDtz, i, f).setSizes(bytes);
+        if (bytes > end) return false;
+      }
+    }
+
+    if (isDtz) bytes = setDtzMap(bytes, maxFile);
+
+    for (int f = 0; f <= maxFile; f++) {
+      for (int i = 0; i < sides; i++) {
+        PairsData& d = get(isDtz, i, f);
+        d.sparseIndex = bytes;
+        bytes += d.sparseIndexSize * 6;
+      }
+    }
+
+    for (int f = 0; f <= maxFile; f++) {
+      for (int i = 0; i < sides; i++) {
+        PairsData& d = get(isDtz, i, f);
+        d.blockLength = bytes;
+        bytes += d.blockLengthSize * 2;
+      }
+    }
+
+    for (int f = 0; f <= maxFile; f++) {
+      for (int i = 0; i < sides; i++) {
+        bytes += (64 - (reinterpret_cast<uintptr_t>(bytes) & 63)) & 63;
+        PairsData& d = get(isDtz, i, f);
+        d.data = bytes;
+        bytes += d.blocksNum * d.sizeofBlock;
+      }
+    }
+
+    return bytes <= end;
+  }
+};
+
+Syzygy::Syzygy() = default;
+Syzygy::~Syzygy() = default;
+
+void Syzygy::clear() {
+  byMaterial.clear();
+  tables.clear();
+  maxPieces = 0;
+}
+
+size_t Syzygy::load(const std::string& paths) {
+  clear();
+
+  // The first directory with a file of a name wins
+  std::map<std::string, std::string> wdlPaths;
+  std::map<std::string, std::string> dtzPaths;
+
+  size_t begin = 0;
+  while (begin <= paths.size()) {
+    size_t end = paths.find(PATH_SEPARATOR, begin);
+    if (end == std::string::npos) end = paths.size();
+    std::string directory = paths.substr(begin, end - begin);
+    begin = end + 1;
+
+    std::error_code error;
+    if (directory.empty() || !std::filesystem::is_directory(directory, error)) {
+      continue;
+    }
+
+    for (const auto& entry :
+         std::filesystem::directory_iterator(directory, error)) {
+      std::string extension = entry.path().extension().string();
+      std::string name = entry.path().stem().string();
+      if (extension == ".rtbw") wdlPaths.emplace(name, entry.path().string());
+      if (extension == ".rtbz") dtzPaths.emplace(name, entry.path().string());
+    }
+  }
+
+  for (const auto& [name, path] : wdlPaths) {
+    std::string white, black;
+    if (!parseName(name, white, black)) continue;
+
+    auto table = std::make_unique<Table>(white, black);
+    if (byMaterial.count(table->key)) continue;
+    if (!table->wdlFile.open(path) || !table->init(false)) continue;
+
+    auto dtz = dtzPaths.find(name);
+    if (dtz != dtzPaths.end() && table->dtzFile.open(dtz->second)) {
+      table->hasDtz = table->init(true);
+    }
+
+    byMaterial[table->key] = table.get();
+    byMaterial[table->key2] = table.get();
+    maxPieces = std::max(maxPieces, table->pieceCount);
+    tables.push_back(std::move(table));
+  }
+
+  return tables.size();
+}
+
+const Syzygy::Table* Syzygy::findTable(const Board& board) const {
+  auto it = byMaterial.find(board.materialKey());
+  return it == byMaterial.end() ? nullptr : it->second;
+}
+
+// Index of the position in the table of its material, with the side to
+// move and the leading pawn file that select the values
+uint64_t Syzygy::encode(const Table& table, const Board& board, bool isDtz,
+                        int& stm, int& tbFile) {
+  const IndexTables& t = indexTables();
+  auto pawnsBefore = [&](int a, int b) {
+    return t.mapPawns[a] < t.mapPawns[b];
+  };
+
+  int squares[MAX_SYZYGY_PIECES];
+  int pieces[MAX_SYZYGY_PIECES];
+  int size = 0;
+  int leadPawnsCount = 0;
+  Bitboard leadPawns;
+  tbFile = 0;
+
+  // The tables have white as the side with the pieces of the name, and a
+  // table with the same pieces on both sides only white to move. Other
+  // positions are looked up with the colors swapped and the board
+  // mirrored.
+  bool blackToMove = board.sideToMove() == Color::BLACK;
+  bool flip = (table.key == table.key2 && blackToMove) ||
+              board.materialKey() != table.key;
+  int flipColor = flip ? 8 : 0;
+  int flipSquares = flip ? 56 : 0;
+  stm = flip != blackToMove;
+
+  // The pawns of the leading color come first, the table of the file of
+  // the leading pawn is used
+  if (table.hasPawns) {
+    int code = table.get(isDtz, 0, 0).pieces[0] ^ flipColor;
+    leadPawns = board.pieces(PieceType::PAWN,
+                             code & 8 ? Color::BLACK : Color::WHITE);
+
+    Bitboard b = leadPawns;
+    while (b) squares[size++] = b.pop() ^ flipSquares;
+    leadPawnsCount = size;
+
+    std::swap(squares[0], *std::max_element(squares, squares + leadPawnsCount,
+                                            pawnsBefore));
+
+    tbFile = squares[0] & 7;
+    if (tbFile > 3) tbFile = (squares[0] ^ 7) & 7;
+  }
+
+  Bitboard b = board.occ() ^ leadPawns;
+  while (b) {
+    int sq = b.pop();
+    squares[size] = sq ^ flipSquares;
+    pieces[size++] = pieceCode(board.at(Square(sq))) ^ flipColor;
+  }
+
+  const PairsData& d = table.get(isDtz, stm, tbFile);
+
+  // Same piece order as the table
+  for (int i = leadPawnsCount; i < size - 1; i++) {
+    for (int j = i + 1; j < size; j++) {
+      if (d.pieces[i] == pieces[j]) {
+        std::swap(pieces[i], pieces[j]);
+        std::swap(squares[i], squares[j]);
+        break;
+      }
+    }
+  }
+
+  // The leading piece goes to the a-d files
+  if ((squares[0] & 7) > 3) {
+    for (int i = 0; i < size; i++) squares[i] ^= 7;
+  }
+
+  uint64_t idx;
+  if (table.hasPawns) {
+    idx = t.leadPawnIdx[leadPawnsCount][squares[0]];
+
+    std::stable_sort(squares + 1, squares + leadPawnsCount, pawnsBefore);
+    for (int i = 1; i < leadPawnsCount; i++) {
+      idx += t.binomial[i][t.mapPawns[squares[i]]];
+    }
+  } else {
+    // Without pawns also to the first four ranks and below the a1-h8
+    // diagonal, the first piece of the leading group off the diagonal
+    // decides
+    if ((squares[0] >> 3) > 3) {
+      for (int i = 0; i < size; i++) squares[i] ^= 56;
+    }
+
+    for (int i = 0; i < d.groupLen[0]; i++) {
+      if (!offA1H8(squares[i])) continue;
+
+      if (offA1H8(squares[i]) > 0) {
+        for (int j = i; j < size; j++) {
+          squares[j] = ((squares[j] >> 3) | (squares[j] << 3)) & 63;
+        }
+      }
+      break;
+    }
+
+    if (table.hasUniquePieces) {
+      // Three unique pieces are encoded together, by how many of them are
+      // on the diagonal
+      int adjust1 = squares[1] > squares[0];
+      int adjust2 = (squares[2] > squares[0]) + (squares[2] > squares[1]);
+
+      if (offA1H8(squares[0])) {
+        idx = (t.mapA1D1D4[squares[0]] * 63 + (squares[1] - adjust1)) * 62 +
+              squares[2] - adjust2;
+      } else if (offA1H8(squares[1])) {
+        idx = (6 * 63 + (squares[0] >> 3) * 28 + t.mapB1H1H7[squares[1]]) * 62 +
+              squares[2] - adjust2;
+      } else if (offA1H8(squares[2])) {
+        idx = 6 * 63 * 62 + 4 * 28 * 62 + (squares[0] >> 3) * 7 * 28 +
+              ((squares[1] >> 3) - adjust1) * 28 + t.mapB1H1H7[squares[2]];
+      } else {
+        idx = 6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28 +
+              (squares[0] >> 3) * 7 * 6 + ((squares[1] >> 3) - adjust1) * 6 +
+              ((squares[2] >> 3) - adjust2);
+      }
+    } else {
+      idx = t.mapKK[t.mapA1D1D4[squares[0]]][squares[1]];
+    }
+  }
+
+  // The other groups in ascending squares, counting only the squares the
+  // groups before leave free
+  idx *= d.groupIdx[0];
+  int* groupSq = squares + d.groupLen[0];
+  bool remainingPawns = table.hasPawns && table.pawnCount[1];
+
+  for (int next = 1; d.groupLen[next]; next++) {
+    std::stable_sort(groupSq, groupSq + d.groupLen[next]);
+
+    uint64_t n = 0;
+    for (int i = 0; i < d.groupLen[next]; i++) {
+      int adjust = static_cast<int>(std::count_if(
+          squares, groupSq, [&](int sq) { return groupSq[i] > sq; }));
+      n += t.binomial[i + 1][groupSq[i] - adjust - 8 * remainingPawns];
+    }
+
+    remainingPawns = false;
+    idx += n * d.groupIdx[next];
+    groupSq += d.groupLen[next];
+  }
+
+  return idx;
+}
+
+// Number of values of every side to move and leading pawn file, files first
+std::vector<uint64_t> Syzygy::sizes(const Table& table, bool isDtz) {
+  std::vector<uint64_t> result;
+  int sides = !isDtz && table.key != table.key2 ? 2 : 1;
+
+  for (int f = 0; f <= (table.hasPawns ? 3 : 0); f++) {
+    for (int i = 0; i < sides; i++) {
+      result.push_back(table.get(isDtz, i, f).size());
+    }
+  }
+  return result;
+}
+
+// Value stored for the position: the result for a WDL table, the distance
+// to zeroing for a DTZ table, which needs the result of the position
+int Syzygy::probeTable(const Board& board, bool isDtz, SyzygyWdl wdl,
+                       ProbeState& state) const {
+  // Bare kings have no table
+  if (board.occ().count() == 2) return 0;
+
+  const Table* table = findTable(board);
+  if (!table || (isDtz && !table->hasDtz)) {
+    state = ProbeState::FAIL;
+    return 0;
+  }
+
+  int stm, tbFile;
+  uint64_t idx = encode(*table, board, isDtz, stm, tbFile);
+  const PairsData& d = table->get(isDtz, stm, tbFile);
+
+  // A DTZ table only has one side to move
+  if (isDtz) {
+    if ((d.flags & TB_STM) != stm &&
+        !(table->key == table->key2 && !table->hasPawns)) {
+      state = ProbeState::CHANGE_STM;
+      return 0;
+    }
+  }
+
+  int value = d.decompress(idx);
+  if (!isDtz) return value - 2;
+
+  // DTZ values are plies or moves, mapped or not, by the result
+  const PairsData& d0 = table->get(true, 0, tbFile);
+  int result = static_cast<int>(wdl);
+  if (d0.flags & TB_MAPPED) {
+    int at = d0.mapIdx[WDL_TO_MAP[result + 2]] + value;
+    value = d0.flags & TB_WIDE ? readLittle<uint16_t>(table->dtzMap + 2 * at)
+                               : table->dtzMap[at];
+  }
+
+  if ((wdl == SyzygyWdl::WIN && !(d0.flags & TB_WIN_PLIES)) ||
+      (wdl == SyzygyWdl::LOSS && !(d0.flags & TB_LOSS_PLIES)) ||
+      wdl == SyzygyWdl::CURSED_WIN || wdl == SyzygyWdl::BLESSED_LOSS) {
+    value *= 2;
+  }
+
+  return value + 1;
+}
+
+// Result of the position with the captures (and the pawn moves when
+// `zeroing` is set) searched, the tables hold no useful value where one of
+// them is the best move. ZEROING_BEST_MOVE tells that it is.
+SyzygyWdl Syzygy::search(Board& board, bool zeroing, ProbeState& state) const {
+  SyzygyWdl best = SyzygyWdl::LOSS;
+
+  Movelist moves;
+  movegen::legalmoves(moves, board);
+  int searched = 0;
+
+  for (const Move move : moves) {
+    if (!board.isCapture(move) &&
+        (!zeroing || board.at(move.from()).type() != PieceType::PAWN)) {
+      continue;
+    }
+    searched++;
+
+    board.makeMove(move);
+    SyzygyWdl value = -search(board, false, state);
+    board.unmakeMove(move);
+
+    if (state == ProbeState::FAIL) return SyzygyWdl::DRAW;
+
+    if (value > best) {
+      best = value;
+      if (value >= SyzygyWdl::WIN) {
+        state = ProbeState::ZEROING_BEST_MOVE;
+        return value;
+      }
+    }
+  }
+
+  // With every move searched the table is not needed, it could be wrong
+  // for an en passant square or only captures
+  bool noMoreMoves = searched && searched == static_cast<int>(moves.size());
+
+  SyzygyWdl value = best;
+  if (!noMoreMoves) {
+    int stored = probeTable(board, false, SyzygyWdl::DRAW, state);
+    value = static_cast<SyzygyWdl>(stored);
+    if (state == ProbeState::FAIL) return SyzygyWdl::DRAW;
+  }
+
+  if (best >= value) {
+    state = best > SyzygyWdl::DRAW || noMoreMoves
+                ? ProbeState::ZEROING_BEST_MOVE
+                : ProbeState::OK;
+    return best;
+  }
+
+  state = ProbeState::OK;
+  return value;
+}
+
+int Syzygy::searchDtz(Board& board, ProbeState& state) const {
+  state = ProbeState::OK;
+  SyzygyWdl wdl = search(board, true, state);
+
+  // Draws are not stored
+  if (state == ProbeState::FAIL || wdl == SyzygyWdl::DRAW) return 0;
+
+  if (state == ProbeState::ZEROING_BEST_MOVE) return dtzBeforeZeroing(wdl);
+
+  int dtz = probeTable(board, true, wdl, state);
+  if (state == ProbeState::FAIL) return 0;
+
+  if (state != ProbeState::CHANGE_STM) {
+    bool rule50 =
+        wdl == SyzygyWdl::BLESSED_LOSS || wdl == SyzygyWdl::CURSED_WIN;
+    return (dtz + (rule50 ? 100 : 0)) * sign(static_cast<int>(wdl));
+  }
+
+  // The table has the other side to move, the best move is found by one
+  // ply of search
+  int minDtz = 0xFFFF;
+
+  Movelist moves;
+  movegen::legalmoves(moves, board);
+  for (const Move move : moves) {
+    bool zeroingMove = board.isCapture(move) ||
+                       board.at(move.from()).type() == PieceType::PAWN;
+
+    board.makeMove(move);
+
+    // A zeroing move ends the count, the position after it only gives the
+    // result
+    dtz = zeroingMove ? -dtzBeforeZeroing(search(board, false, state))
+                      : -searchDtz(board, state);
+
+    if (dtz == 1 && board.inCheck()) {
+      Movelist replies;
+      movegen::legalmoves(replies, board);
+      if (replies.empty()) minDtz = 1;
+    }
+
+    if (!zeroingMove) dtz += sign(dtz);
+    if (dtz < minDtz && sign(dtz) == sign(static_cast<int>(wdl))) minDtz = dtz;
+
+    board.unmakeMove(move);
+
+    if (state == ProbeState::FAIL) return 0;
+  }
+
+  // Without legal moves the position is mate
+  return minDtz == 0xFFFF ? -1 : minDtz;
+}
+
+bool Syzygy::probeWdl(Board& board, SyzygyWdl& wdl) const {
+  ProbeState state = ProbeState::OK;
+  wdl = search(board, false, state);
+  return state != ProbeState::FAIL;
+}
+
+bool Syzygy::probeDtz(Board& board, int& dtz) const {
+  ProbeState state = ProbeState::OK;
+  dtz = searchDtz(board, state);
+  return state != ProbeState::FAIL;
+}
+
+bool Syzygy::rankRootMoves(Board& board, const Move* moves, int count,
+                           int* ranks) const {
+  int halfMoves = static_cast<int>(board.halfMoveClock());
+  ProbeState state = ProbeState::OK;
+
+  for (int i = 0; i < count; i++) {
+    board.makeMove(moves[i]);
+
+    // Distance to zeroing from the root, a zeroing move is one ply
+    int dtz;
+    if (board.halfMoveClock() == 0) {
+      state = ProbeState::OK;
+      dtz = dtzBeforeZeroing(-search(board, false, state));
+    } else {
+      dtz = -searchDtz(board, state);
+      dtz += sign(dtz);
+    }
+
+    // A mate is always one ply
+    if (dtz == 2 && board.inCheck()) {
+      Movelist replies;
+      movegen::legalmoves(replies, board);
+      if (replies.empty()) dtz = 1;
+    }
+
+    board.unmakeMove(moves[i]);
+    if (state == ProbeState::FAIL) return false;
+
+    // A zeroing move beyond the fifty moves only draws
+    bool inTime = std::abs(dtz) + halfMoves <= 100;
+    if (dtz > 0) {
+      ranks[i] = inTime ? 2000 - dtz : 1000 - std::min(dtz, 999);
+    } else if (dtz < 0) {
+      ranks[i] = inTime ? -2000 - dtz : -1000 + std::min(-dtz, 999);
+    } else {
+      ranks[i] = 0;
+    }
+  }
+
+  return true;
+}
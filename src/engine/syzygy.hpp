@@ -0,0 +1,104 @@
+#ifndef SYZYGY_HPP
+#define SYZYGY_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../chess-library/include/chess.hpp"
+#include "mapped-file.hpp"
+
+using namespace chess;
+
+/*
+ * Syzygy tablebases
+ *
+ * Probes the .rtbw (win/draw/loss) and .rtbz (distance to zeroing) files of
+ * the Syzygy format, the way Fathom does. Every table found in the
+ * SyzygyPath directories is mapped and its header read once by load(), so
+ * the probes only read the mapped files and can run on any thread.
+ *
+ * A table stores the positions of one material for white to be the
+ * stronger side. The squares of a position are mirrored into a canonical
+ * corner and turned into an index, the value at that index is found in
+ * blocks of canonical Huffman codes over a recursive pairing of the values.
+ * The tables leave out castling rights, and hold wrong values where a
+ * capture or en passant is the best move, so a probe first searches the
+ * captures.
+ */
+
+constexpr int MAX_SYZYGY_PIECES = 7;
+
+// Result from the side to move. A cursed win or a blessed loss is a win or
+// a loss that the fifty move rule turns into a draw.
+enum class SyzygyWdl : int8_t {
+  LOSS = -2,
+  BLESSED_LOSS = -1,
+  DRAW = 0,
+  CURSED_WIN = 1,
+  WIN = 2
+};
+
+class Syzygy {
+ private:
+  // Tests write small tables through the index encoding of the reader
+  friend struct SyzygyTest;
+
+  struct PairsData;
+  struct Table;
+
+  // Outcome of a table probe
+  enum class ProbeState { FAIL, OK, CHANGE_STM, ZEROING_BEST_MOVE };
+
+  std::vector<std::unique_ptr<Table>> tables;
+  std::unordered_map<uint64_t, const Table*> byMaterial;
+  int maxPieces = 0;
+
+  const Table* findTable(const Board& board) const;
+  int probeTable(const Board& board, bool dtz, SyzygyWdl wdl,
+                 ProbeState& state) const;
+  SyzygyWdl search(Board& board, bool zeroing, ProbeState& state) const;
+  int searchDtz(Board& board, ProbeState& state) const;
+
+  static uint64_t encode(const Table& table, const Board& board, bool isDtz,
+                         int& stm, int& tbFile);
+  static std::vector<uint64_t> sizes(const Table& table, bool isDtz);
+
+ public:
+  Syzygy();
+  ~Syzygy();
+
+  Syzygy(const Syzygy&) = delete;
+  Syzygy& operator=(const Syzygy&) = delete;
+
+  // Maps the tables of the directories, separated by ':' (';' on Windows),
+  // instead of the ones mapped before. A .rtbz file is used with the .rtbw
+  // file of the same name. Returns the number of WDL tables found.
+  size_t load(const std::string& paths);
+  void clear();
+
+  size_t size() const { return tables.size(); }
+  int getMaxPieces() const { return maxPieces; }
+
+  // Result of the position from the side to move, false if a table is
+  // missing. The board is left as it was, the position must not have
+  // castling rights.
+  bool probeWdl(Board& board, SyzygyWdl& wdl) const;
+
+  // Plies to the next capture, pawn move or mate with the best play, from
+  // the side to move: positive when winning, negative when losing and 0 for
+  // a draw. A cursed win or blessed loss is 100 plies further. False if a
+  // table is missing.
+  bool probeDtz(Board& board, int& dtz) const;
+
+  // Rank of every root move from its distance to zeroing and the fifty move
+  // counter, higher is better. Wins inside the fifty moves rank above
+  // cursed wins, draws, blessed losses and losses, faster wins and slower
+  // losses rank higher. False if a table is missing.
+  bool rankRootMoves(Board& board, const Move* moves, int count,
+                     int* ranks) const;
+};
+
+#endif
@@ -0,0 +1,84 @@
+#include "tablebases.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+
+namespace {
+
+#ifdef _WIN32
+constexpr char PATH_SEPARATOR = ';';
+#else
+constexpr char PATH_SEPARATOR = ':';
+#endif
+
+// Material key of a board with the pieces of the table, with the colors
+// swapped when `flip` is set
+uint64_t materialKey(const EndgameMaterial& material, bool flip) {
+  std::string rank;
+  for (int i = 0; i < material.count; i++) {
+    char c = "PNBRQK"[static_cast<int>(material.pieces[i].type())];
+    bool white = (material.pieces[i].color() == Color::WHITE) != flip;
+    rank += white ? c : static_cast<char>(std::tolower(c));
+  }
+  rank += std::to_string(8 - material.count);
+
+  return Board("8/8/8/8/8/8/" + rank + "/8 w - - 0 1").materialKey();
+}
+
+}  // namespace
+
+void Tablebases::clear() {
+  byMaterial.clear();
+  tables.clear();
+  maxPieces = 0;
+}
+
+size_t Tablebases::load(const std::string& paths) {
+  clear();
+
+  size_t begin = 0;
+  while (begin <= paths.size()) {
+    size_t end = paths.find(PATH_SEPARATOR, begin);
+    if (end == std::string::npos) end = paths.size();
+    std::string directory = paths.substr(begin, end - begin);
+    begin = end + 1;
+
+    std::error_code error;
+    if (directory.empty() || !std::filesystem::is_directory(directory, error)) {
+      continue;
+    }
+
+    for (const auto& entry :
+         std::filesystem::directory_iterator(directory, error)) {
+      if (entry.path().extension() != ".pbb") continue;
+
+      auto table = std::make_unique<Bitbase>();
+      if (!table->open(entry.path().string())) continue;
+
+      // A table found twice is only used from the first directory
+      const EndgameMaterial& material = table->getMaterial();
+      uint64_t key = materialKey(material, false);
+      if (byMaterial.count(key)) continue;
+
+      byMaterial[key] = table.get();
+      byMaterial[materialKey(material, true)] = table.get();
+      maxPieces = std::max(maxPieces, material.count);
+      tables.push_back(std::move(table));
+    }
+  }
+
+  return tables.size();
+}
+
+Wdl Tablebases::probe(const Board& board) const {
+  auto it = byMaterial.find(board.materialKey());
+  if (it == byMaterial.end()) {
+    // Bare kings have no table
+    return board.occ().count() == 2 ? Wdl::DRAW : Wdl::INVALID;
+  }
+
+  EndgamePosition position;
+  if (!EndgamePosition::fromBoard(board, position)) return Wdl::INVALID;
+  return it->second->probe(position);
+}
@@ -0,0 +1,50 @@
+#ifndef TABLEBASES_HPP
+#define TABLEBASES_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../chess-library/include/chess.hpp"
+#include "bitbase.hpp"
+#include "utils.hpp"
+
+using namespace chess;
+
+/*
+ * Endgame tablebases
+ *
+ * All .pbb bitbases (see bitbase.hpp) found in a list of directories,
+ * mapped once and shared by every engine. A board is matched to its table
+ * by Board::materialKey(), every table is registered under the keys of
+ * both colorings of its material.
+ */
+
+// Score of a tablebase win, below the mate scores and above any evaluation
+constexpr int TB_WIN_SCORE = MATE_SCORE / 2;
+
+class Tablebases {
+ private:
+  std::vector<std::unique_ptr<Bitbase>> tables;
+  std::unordered_map<uint64_t, const Bitbase*> byMaterial;
+  int maxPieces = 0;
+
+ public:
+  // Maps the .pbb files of the directories, separated by ':' (';' on
+  // Windows), instead of the ones mapped before. Returns the number of
+  // tables found.
+  size_t load(const std::string& paths);
+  void clear();
+
+  size_t size() const { return tables.size(); }
+  int getMaxPieces() const { return maxPieces; }
+
+  // Result from the side to move, Wdl::INVALID if there is no table for the
+  // position. Castling and en passant are not in the tables, the caller
+  // only probes positions without them.
+  Wdl probe(const Board& board) const;
+};
+
+#endif
@@ -5,6 +5,11 @@ void Engine::clearTranspositionTable() {
   ttHits = 0;
 }
 
+void Engine::setHashSize(size_t megabytes) {
+  ttMaxEntries = std::max<size_t>(1, megabytes * 1024 * 1024 / TT_ENTRY_BYTES);
+  clearTranspositionTable();
+}
+
 bool Engine::probeTT(uint64_t hash, int depth, int& score, int alpha, int beta,
                      Move& bestMove) {
   auto it = transpositionTable.find(hash);
@@ -39,11 +44,9 @@ bool Engine::probeTT(uint64_t hash, int depth, int& score, int alpha, int beta,
 void Engine::storeTT(uint64_t hash, int depth, int score, TTEntryType type,
                      Move bestMove) {
   // keep the table of a constant size
-  if (transpositionTable.size() > 1000000) {
-    // Todo implement a replacement scheme
-    if (transpositionTable.size() > 2000000) {
-      clearTranspositionTable();
-    }
+  // Todo implement a replacement scheme
+  if (transpositionTable.size() > ttMaxEntries) {
+    clearTranspositionTable();
   }
 
   TTEntry entry;
@@ -1,13 +1,38 @@
+#include <algorithm>
 #include <atomic>
 #include <iostream>
+#include <random>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <thread>
+#include <vector>
 
+#include "./engine/bench.hpp"
+#include "./engine/book.hpp"
 #include "./engine/engine.hpp"
+#include "./engine/syzygy.hpp"
+#include "./engine/tablebases.hpp"
 
 //! Claude generated slappy code
 
+// Next space separated token, the string is advanced past it. Empty at the
+// end of the string.
+std::string_view nextToken(std::string_view& str) {
+  size_t begin = str.find_first_not_of(" \t\r");
+  if (begin == std::string_view::npos) {
+    str = {};
+    return {};
+  }
+
+  size_t end = str.find_first_of(" \t\r", begin);
+  if (end == std::string_view::npos) end = str.size();
+
+  std::string_view token = str.substr(begin, end - begin);
+  str.remove_prefix(end);
+  return token;
+}
+
 class UCIAdapter {
  private:
   // Pointer to your engine
@@ -16,6 +41,26 @@ class UCIAdapter {
   std::thread searchThread;
   std::atomic<bool> stopRequested;
 
+  // Opening book, only used with OwnBook on
+  PolyglotBook book;
+  bool ownBook = false;
+  bool bookBestMove = false;
+  std::mt19937_64 bookRng{std::random_device{}()};
+
+  // Bitbases of the BitbasePath directories
+  Tablebases tablebases;
+  int tbProbeLimit = MAX_BITBASE_PIECES;
+
+  // Syzygy tables of the SyzygyPath directories
+  Syzygy syzygy;
+  int syzygyProbeLimit = MAX_SYZYGY_PIECES;
+
+  // Game of the last position command. A command that only adds moves to it
+  // plays the new moves instead of setting up the whole game again.
+  std::string positionFen;
+  std::vector<std::string> positionMoves;
+  std::vector<std::string_view> moveTokens;
+
  public:
   UCIAdapter(Engine* e) : engine(e), stopRequested(false) {}
 
@@ -37,19 +82,23 @@ class UCIAdapter {
     } else if (token == "isready") {
       std::cout << "readyok" << std::endl;
     } else if (token == "position") {
-      handlePosition(iss);
+      handlePosition(cmd);
     } else if (token == "d") {
       engine->printBoard();
     } else if (token == "go") {
-      handleGo();
+      handleGo(iss);
     } else if (token == "stop") {
       handleStop();
     } else if (token == "quit") {
       exit(0);
     } else if (token == "ucinewgame") {
       engine->initilizeEngine();
+      positionFen.clear();
+      positionMoves.clear();
     } else if (token == "setoption") {
       handleSetOption(iss);
+    } else if (token == "bench") {
+      handleBench(iss);
     }
   }
 
@@ -58,53 +107,88 @@ class UCIAdapter {
     std::cout << "id author Razamindset" << std::endl;
 
     // Output available options if any
-    // std::cout << "option name Hash type spin default 64 min 1 max 1024" <<
-    // std::endl;
+    std::cout << "option name Hash type spin default " << DEFAULT_HASH_MB
+              << " min 1 max 1024" << std::endl;
+    std::cout << "option name OwnBook type check default false" << std::endl;
+    std::cout << "option name BookFile type string default <empty>"
+              << std::endl;
+    std::cout << "option name BookBestMove type check default false"
+              << std::endl;
+    std::cout << "option name BitbasePath type string default <empty>"
+              << std::endl;
+    std::cout << "option name BitbaseProbeLimit type spin default "
+              << MAX_BITBASE_PIECES << " min 0 max " << MAX_BITBASE_PIECES
+              << std::endl;
+    std::cout << "option name SyzygyPath type string default <empty>"
+              << std::endl;
+    std::cout << "option name SyzygyProbeLimit type spin default "
+              << MAX_SYZYGY_PIECES << " min 0 max " << MAX_SYZYGY_PIECES
+              << std::endl;
 
     std::cout << "uciok" << std::endl;
   }
 
-  void handlePosition(std::istringstream& iss) {
-    std::string token;
-    iss >> token;
+  void handlePosition(std::string_view line) {
+    nextToken(line);  // "position"
+    std::string_view token = nextToken(line);
 
+    std::string fen;
     if (token == "startpos") {
-      engine->setPosition(
-          "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");  // Standard
-                                                                        // starting
-                                                                        // FEN
-
-      // Process any moves that come after "startpos moves"
-      iss >> token;  // Skip "moves" token if present
-      if (token == "moves") {
-        std::string move;
-        while (iss >> move) {
-          engine->makeMove(move);
-        }
-      }
+      fen = constants::STARTPOS;
+      token = nextToken(line);
     } else if (token == "fen") {
-      std::string fen;
       // Collect all parts of the FEN string
-      for (int i = 0; i < 6; i++) {
-        iss >> token;
-        fen += token + " ";
+      while (!(token = nextToken(line)).empty() && token != "moves") {
+        if (!fen.empty()) fen += ' ';
+        fen += token;
       }
+    } else {
+      return;
+    }
+
+    moveTokens.clear();
+    if (token == "moves") {
+      while (!(token = nextToken(line)).empty()) moveTokens.push_back(token);
+    }
+
+    // GUIs resend the whole game before every search, normally the previous
+    // position plus a move or two
+    bool continuesGame =
+        fen == positionFen && moveTokens.size() >= positionMoves.size() &&
+        std::equal(positionMoves.begin(), positionMoves.end(),
+                   moveTokens.begin());
+
+    if (!continuesGame) {
       engine->setPosition(fen);
+      positionFen = fen;
+      positionMoves.clear();
+    }
 
-      // Process any moves after the FEN
-      iss >> token;  // Check for "moves" token
-      if (token == "moves") {
-        std::string move;
-        while (iss >> move) {
-          engine->makeMove(move);
-        }
-      }
+    for (size_t i = positionMoves.size(); i < moveTokens.size(); i++) {
+      engine->makeMove(moveTokens[i]);
+      positionMoves.emplace_back(moveTokens[i]);
     }
   }
 
-  void handleGo() {
-    // Simply get the best move without time controls
-    std::string bestMove = engine->getBestMove(4);
+  void handleGo(std::istringstream& iss) {
+    // Only "go depth N" is used, there are no time controls yet so any other
+    // limit searches the default depth
+    int depth = 4;
+    std::string token;
+    while (iss >> token) {
+      if (token == "depth") iss >> depth;
+    }
+
+    // Book moves are played without searching
+    if (ownBook && book.isOpen()) {
+      Move bookMove = book.pick(engine->getBoard(), bookBestMove, bookRng);
+      if (bookMove != Move::NO_MOVE) {
+        std::cout << "bestmove " << uci::moveToUci(bookMove) << std::endl;
+        return;
+      }
+    }
+
+    std::string bestMove = engine->getBestMove(depth);
     std::cout << "bestmove " << bestMove << std::endl;
   }
 
@@ -136,12 +220,73 @@ class UCIAdapter {
     }
 
     // Set the option in your engine
-    // engine->setOption(nameStr, valueStr);
+    if (nameStr == "Hash" && !valueStr.empty()) {
+      engine->setHashSize(std::stoul(valueStr));
+    } else if (nameStr == "OwnBook") {
+      ownBook = valueStr == "true";
+    } else if (nameStr == "BookBestMove") {
+      bookBestMove = valueStr == "true";
+    } else if (nameStr == "BookFile") {
+      if (valueStr.empty() || valueStr == "<empty>") {
+        book.close();
+      } else if (book.open(valueStr)) {
+        std::cout << "info string Book " << valueStr << " with " << book.size()
+                  << " entries" << std::endl;
+      } else {
+        std::cout << "info string Could not open book " << valueStr
+                  << std::endl;
+      }
+    } else if (nameStr == "BitbasePath") {
+      if (valueStr.empty() || valueStr == "<empty>") {
+        tablebases.clear();
+      } else {
+        std::cout << "info string Found " << tablebases.load(valueStr)
+                  << " bitbases in " << valueStr << std::endl;
+      }
+      updateTablebases();
+    } else if (nameStr == "BitbaseProbeLimit" && !valueStr.empty()) {
+      tbProbeLimit = std::stoi(valueStr);
+      updateTablebases();
+    } else if (nameStr == "SyzygyPath") {
+      if (valueStr.empty() || valueStr == "<empty>") {
+        syzygy.clear();
+      } else {
+        std::cout << "info string Found " << syzygy.load(valueStr)
+                  << " Syzygy tables in " << valueStr << std::endl;
+      }
+      updateTablebases();
+    } else if (nameStr == "SyzygyProbeLimit" && !valueStr.empty()) {
+      syzygyProbeLimit = std::stoi(valueStr);
+      updateTablebases();
+    }
+  }
+
+  void updateTablebases() {
+    engine->setTablebases(tablebases.size() ? &tablebases : nullptr,
+                          tbProbeLimit);
+    engine->setSyzygy(syzygy.size() ? &syzygy : nullptr, syzygyProbeLimit);
+  }
+
+  // bench [depth] [threads] [hash]
+  void handleBench(std::istringstream& iss) {
+    int depth = 4, threads = 1;
+    size_t hash = 16;
+    iss >> depth >> threads >> hash;
+    runBench(depth, threads, hash);
   }
 };
 
 // Usage example
-int main() {
+int main(int argc, char* argv[]) {
+  // ./pawnstar bench [depth] [threads] [hash]
+  if (argc > 1 && std::string(argv[1]) == "bench") {
+    int depth = argc > 2 ? std::stoi(argv[2]) : 4;
+    int threads = argc > 3 ? std::stoi(argv[3]) : 1;
+    size_t hash = argc > 4 ? std::stoul(argv[4]) : 16;
+    runBench(depth, threads, hash);
+    return 0;
+  }
+
   Engine engine;
   UCIAdapter adapter(&engine);
   adapter.start();
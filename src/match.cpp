@@ -0,0 +1,262 @@
+#include <signal.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "./play/game.hpp"
+#include "./play/openings.hpp"
+#include "./play/pgn-writer.hpp"
+#include "./play/player.hpp"
+#include "./play/sprt.hpp"
+
+/*
+ * SPRT match between two engines
+ *
+ * Every engine is either an external UCI executable (cmd=...) or the engine
+ * of this build with its own search options. Each opening is played twice
+ * with the colors reversed. The match stops as soon as the SPRT accepts one
+ * of the hypotheses, or after --games games.
+ */
+
+struct MatchConfig {
+  std::string specs[2];
+  int games = 20000;     // Upper limit, the SPRT normally stops earlier
+  int concurrency = 1;   // Game pairs played at the same time
+  int depth = 4;         // Default depth of both engines
+  int movetime = 0;      // Default movetime of UCI engines
+  int maxMoves = 200;    // Max plies before declaring draw
+  int randomPlies = 8;   // Random opening plies when there is no book
+  uint64_t seed = 0;
+  std::string openingFile;
+  std::string pgnFile;   // No PGN output when empty
+  double elo0 = 0.0;
+  double elo1 = 5.0;
+  double alpha = 0.05;
+  double beta = 0.05;
+};
+
+std::atomic<bool> g_stopRequested{false};
+
+void signalHandler(int) { g_stopRequested = true; }
+
+// Shared between the workers, guarded by the mutex
+struct MatchState {
+  std::mutex mutex;
+  MatchStats stats;
+  std::optional<bool> h1Accepted;
+};
+
+double scoreFor(const std::string& result, bool white) {
+  if (result == "1/2-1/2") return 0.5;
+  return (result == "1-0") == white ? 1.0 : 0.0;
+}
+
+void printStatus(const MatchConfig& config, const MatchStats& stats,
+                 const SprtBounds& bounds) {
+  std::cout << std::fixed << std::setprecision(2) << "Games " << stats.games()
+            << ": +" << stats.wins << " =" << stats.draws << " -"
+            << stats.losses << " | Elo " << stats.elo() << " +/- "
+            << stats.eloError() << " | LLR "
+            << stats.llr(config.elo0, config.elo1) << " [" << bounds.lower
+            << ", " << bounds.upper << "]" << std::endl;
+}
+
+void runWorker(const MatchConfig& config, const SprtBounds& bounds,
+               const std::vector<std::string>& openings, Player& first,
+               Player& second, std::atomic<int>& nextPair, PgnWriter* writer,
+               MatchState& state) {
+  while (!g_stopRequested) {
+    int index = nextPair.fetch_add(1);
+    if (index * 2 >= config.games) break;
+
+    std::string openingFen =
+        openings.empty() ? randomOpening(config.randomPlies, config.seed + index)
+                         : openings[index % openings.size()];
+
+    GameRecord games[2] = {
+        playGame(first, second, openingFen, config.maxMoves, g_stopRequested),
+        playGame(second, first, openingFen, config.maxMoves, g_stopRequested)};
+
+    // An unfinished game makes the whole pair unusable
+    if (games[0].result == "*" || games[1].result == "*") continue;
+
+    for (int i = 0; i < 2; i++) {
+      games[i].event = "SPRT Match";
+      games[i].round = index * 2 + i + 1;
+      if (writer) writer->write(games[i]);
+    }
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (state.h1Accepted) break;
+
+    state.stats.addPair(scoreFor(games[0].result, true),
+                        scoreFor(games[1].result, false));
+    printStatus(config, state.stats, bounds);
+
+    double llr = state.stats.llr(config.elo0, config.elo1);
+    if (llr >= bounds.upper || llr <= bounds.lower) {
+      state.h1Accepted = llr >= bounds.upper;
+      g_stopRequested = true;
+    }
+  }
+}
+
+void printUsage() {
+  std::cout
+      << "Usage: pawnstar-match --engine SPEC --engine SPEC [options]\n"
+      << "  SPEC is key=value,... with the keys\n"
+      << "    name=NAME, cmd=PATH (a UCI engine, this build if missing),\n"
+      << "    depth=N, movetime=MS (UCI engines only), copymake=on\n"
+      << "  --games N         maximum number of games (default 20000)\n"
+      << "  --concurrency N   game pairs played in parallel (default 1)\n"
+      << "  --depth N         default depth of both engines (default 4)\n"
+      << "  --movetime MS     default movetime of UCI engines\n"
+      << "  --max-moves N     plies before a game is drawn (default 200)\n"
+      << "  --openings FILE   .epd or .pgn file with start positions\n"
+      << "  --random-plies N  random opening plies without a file "
+         "(default 8)\n"
+      << "  --seed N          seed for the random openings\n"
+      << "  --pgn FILE        save the games\n"
+      << "  --elo0 E --elo1 E SPRT hypotheses (default 0 and 5)\n"
+      << "  --alpha A --beta B SPRT error rates (default 0.05)\n";
+}
+
+bool parseArgs(int argc, char* argv[], MatchConfig& config) {
+  config.seed = static_cast<uint64_t>(
+      std::chrono::steady_clock::now().time_since_epoch().count());
+  int engines = 0;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (i + 1 >= argc) return false;
+    std::string value = argv[++i];
+
+    if (arg == "--engine" && engines < 2) {
+      config.specs[engines++] = value;
+    } else if (arg == "--games") {
+      config.games = std::stoi(value);
+    } else if (arg == "--concurrency") {
+      config.concurrency = std::max(1, std::stoi(value));
+    } else if (arg == "--depth") {
+      config.depth = std::stoi(value);
+    } else if (arg == "--movetime") {
+      config.movetime = std::stoi(value);
+    } else if (arg == "--max-moves") {
+      config.maxMoves = std::stoi(value);
+    } else if (arg == "--openings") {
+      config.openingFile = value;
+    } else if (arg == "--random-plies") {
+      config.randomPlies = std::stoi(value);
+    } else if (arg == "--seed") {
+      config.seed = std::stoull(value);
+    } else if (arg == "--pgn") {
+      config.pgnFile = value;
+    } else if (arg == "--elo0") {
+      config.elo0 = std::stod(value);
+    } else if (arg == "--elo1") {
+      config.elo1 = std::stod(value);
+    } else if (arg == "--alpha") {
+      config.alpha = std::stod(value);
+    } else if (arg == "--beta") {
+      config.beta = std::stod(value);
+    } else {
+      return false;
+    }
+  }
+
+  return engines == 2;
+}
+
+int main(int argc, char* argv[]) {
+  MatchConfig config;
+
+  try {
+    if (!parseArgs(argc, argv, config)) {
+      printUsage();
+      return 1;
+    }
+  } catch (const std::exception&) {
+    printUsage();
+    return 1;
+  }
+
+  PlayerOptions options[2];
+  for (int i = 0; i < 2; i++) {
+    options[i].name = "Engine" + std::to_string(i + 1);
+    options[i].depth = config.depth;
+    options[i].movetime = config.movetime;
+    if (!options[i].parse(config.specs[i])) {
+      std::cerr << "Invalid engine: " << config.specs[i] << std::endl;
+      return 1;
+    }
+  }
+
+  signal(SIGINT, signalHandler);
+  signal(SIGTERM, signalHandler);
+
+  std::vector<std::string> openings;
+  if (!config.openingFile.empty()) {
+    openings = loadOpenings(config.openingFile);
+    if (openings.empty()) {
+      std::cerr << "No openings found in " << config.openingFile << std::endl;
+      return 1;
+    }
+  }
+
+  // Every worker gets its own pair of engines. They are all started here,
+  // before any game runs.
+  std::vector<std::unique_ptr<Player>> players;
+  try {
+    for (int i = 0; i < config.concurrency * 2; i++) {
+      players.push_back(createPlayer(options[i % 2]));
+    }
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  std::unique_ptr<PgnWriter> writer;
+  if (!config.pgnFile.empty()) {
+    writer = std::make_unique<PgnWriter>(config.pgnFile);
+  }
+
+  SprtBounds bounds = SprtBounds::fromErrors(config.alpha, config.beta);
+  std::cout << options[0].name << " vs " << options[1].name << ", SPRT elo0 "
+            << config.elo0 << " elo1 " << config.elo1 << " alpha "
+            << config.alpha << " beta " << config.beta << std::endl;
+
+  std::atomic<int> nextPair{0};
+  MatchState state;
+  std::vector<std::thread> workers;
+  for (int i = 0; i < config.concurrency; ++i) {
+    workers.emplace_back(runWorker, std::cref(config), std::cref(bounds),
+                         std::cref(openings), std::ref(*players[i * 2]),
+                         std::ref(*players[i * 2 + 1]), std::ref(nextPair),
+                         writer.get(), std::ref(state));
+  }
+  for (auto& worker : workers) worker.join();
+
+  if (writer) writer->flush();
+
+  printStatus(config, state.stats, bounds);
+  if (!state.h1Accepted) {
+    std::cout << "No decision" << std::endl;
+  } else if (*state.h1Accepted) {
+    std::cout << "H1 accepted: " << options[0].name << " is stronger"
+              << std::endl;
+  } else {
+    std::cout << "H0 accepted: " << options[0].name << " is not stronger"
+              << std::endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,270 @@
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+#include "./engine/bench.hpp"
+#include "./engine/engine.hpp"
+
+/*
+ * Microbenchmarks of the chess library and evaluation hot paths
+ *
+ * Every benchmark runs over the positions of the bench command, so the
+ * numbers come from a mix of openings, middle games and endgames instead
+ * of the start position only. Items processed are positions, moves or
+ * squares, whichever the benchmark works on.
+ */
+
+namespace {
+
+std::vector<Board> corpus() {
+  std::vector<Board> boards;
+  for (const auto& fen : benchPositions()) boards.emplace_back(fen);
+  return boards;
+}
+
+std::vector<Movelist> corpusMoves(const std::vector<Board>& boards) {
+  std::vector<Movelist> moves(boards.size());
+  for (size_t i = 0; i < boards.size(); i++) {
+    movegen::legalmoves(moves[i], boards[i]);
+  }
+  return moves;
+}
+
+template <movegen::MoveGenType mt>
+void BM_LegalMoves(benchmark::State& state) {
+  auto boards = corpus();
+  Movelist moves;
+
+  for (auto _ : state) {
+    for (const auto& board : boards) {
+      movegen::legalmoves<mt>(moves, board);
+      benchmark::DoNotOptimize(moves.size());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * boards.size());
+}
+BENCHMARK_TEMPLATE(BM_LegalMoves, movegen::MoveGenType::ALL)->Name("legalmoves/all");
+BENCHMARK_TEMPLATE(BM_LegalMoves, movegen::MoveGenType::CAPTURE)->Name("legalmoves/captures");
+BENCHMARK_TEMPLATE(BM_LegalMoves, movegen::MoveGenType::QUIET)->Name("legalmoves/quiets");
+
+void BM_MakeUnmake(benchmark::State& state) {
+  auto boards = corpus();
+  auto moves = corpusMoves(boards);
+  int64_t count = 0;
+
+  for (auto _ : state) {
+    for (size_t i = 0; i < boards.size(); i++) {
+      for (const auto& move : moves[i]) {
+        boards[i].makeMove(move);
+        boards[i].unmakeMove(move);
+      }
+      count += moves[i].size();
+    }
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(count);
+}
+BENCHMARK(BM_MakeUnmake)->Name("board/makeMove+unmakeMove");
+
+void BM_Hash(benchmark::State& state) {
+  auto boards = corpus();
+
+  for (auto _ : state) {
+    for (const auto& board : boards) benchmark::DoNotOptimize(board.hash());
+  }
+  state.SetItemsProcessed(state.iterations() * boards.size());
+}
+BENCHMARK(BM_Hash)->Name("board/hash");
+
+void BM_Zobrist(benchmark::State& state) {
+  auto boards = corpus();
+
+  for (auto _ : state) {
+    for (const auto& board : boards) benchmark::DoNotOptimize(board.zobrist());
+  }
+  state.SetItemsProcessed(state.iterations() * boards.size());
+}
+BENCHMARK(BM_Zobrist)->Name("board/zobrist");
+
+void BM_QueenAttacks(benchmark::State& state) {
+  auto boards = corpus();
+
+  for (auto _ : state) {
+    for (const auto& board : boards) {
+      Bitboard occupied = board.occ();
+      for (int sq = 0; sq < 64; sq++) {
+        benchmark::DoNotOptimize(attacks::queen(Square(sq), occupied));
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * boards.size() * 64);
+}
+BENCHMARK(BM_QueenAttacks)->Name("attacks/queen");
+
+void BM_MoveToSan(benchmark::State& state) {
+  auto boards = corpus();
+  auto moves = corpusMoves(boards);
+  int64_t count = 0;
+
+  for (auto _ : state) {
+    for (size_t i = 0; i < boards.size(); i++) {
+      for (const auto& move : moves[i]) {
+        benchmark::DoNotOptimize(uci::moveToSan(boards[i], move));
+      }
+      count += moves[i].size();
+    }
+  }
+  state.SetItemsProcessed(count);
+}
+BENCHMARK(BM_MoveToSan)->Name("uci/moveToSan");
+
+void BM_FormatSan(benchmark::State& state) {
+  auto boards = corpus();
+  auto moves = corpusMoves(boards);
+  int64_t count = 0;
+
+  for (auto _ : state) {
+    for (size_t i = 0; i < boards.size(); i++) {
+      for (const auto& move : moves[i]) {
+        benchmark::DoNotOptimize(uci::formatSan(boards[i], move));
+      }
+      count += moves[i].size();
+    }
+  }
+  state.SetItemsProcessed(count);
+}
+BENCHMARK(BM_FormatSan)->Name("uci/formatSan");
+
+void BM_ParseSan(benchmark::State& state) {
+  auto boards = corpus();
+  auto moves = corpusMoves(boards);
+
+  std::vector<std::vector<std::string>> sans(boards.size());
+  for (size_t i = 0; i < boards.size(); i++) {
+    for (const auto& move : moves[i]) {
+      sans[i].push_back(uci::moveToSan(boards[i], move));
+    }
+  }
+
+  int64_t count = 0;
+  for (auto _ : state) {
+    for (size_t i = 0; i < boards.size(); i++) {
+      for (const auto& san : sans[i]) {
+        benchmark::DoNotOptimize(uci::parseSan(boards[i], san));
+      }
+      count += sans[i].size();
+    }
+  }
+  state.SetItemsProcessed(count);
+}
+BENCHMARK(BM_ParseSan)->Name("uci/parseSan");
+
+void BM_SetFen(benchmark::State& state) {
+  const auto& fens = benchPositions();
+  Board board;
+
+  for (auto _ : state) {
+    for (const auto& fen : fens) {
+      board.setFen(fen);
+      benchmark::DoNotOptimize(board.hash());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * fens.size());
+}
+BENCHMARK(BM_SetFen)->Name("board/setFen");
+
+void BM_GetFen(benchmark::State& state) {
+  auto boards = corpus();
+
+  for (auto _ : state) {
+    for (const auto& board : boards) benchmark::DoNotOptimize(board.getFen());
+  }
+  state.SetItemsProcessed(state.iterations() * boards.size());
+}
+BENCHMARK(BM_GetFen)->Name("board/getFen");
+
+// Without the pawn hash table, which the search almost always hits
+void BM_PawnStructure(benchmark::State& state) {
+  auto boards = corpus();
+
+  for (auto _ : state) {
+    for (const auto& board : boards) {
+      benchmark::DoNotOptimize(pawnStructureScore(board));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * boards.size());
+}
+BENCHMARK(BM_PawnStructure)->Name("eval/pawnStructure");
+
+}  // namespace
+
+// Friend of Engine, runs an evaluation term on every corpus position. Each
+// position has its own engine since evaluatePosition also looks at the
+// engine's board.
+struct EngineBench {
+  template <typename F>
+  static void run(benchmark::State& state, F term) {
+    auto boards = corpus();
+    std::vector<Engine> engines(boards.size());
+    for (size_t i = 0; i < boards.size(); i++) {
+      engines[i].setPosition(boards[i].getFen());
+    }
+
+    for (auto _ : state) {
+      for (size_t i = 0; i < boards.size(); i++) {
+        benchmark::DoNotOptimize(term(engines[i], boards[i]));
+      }
+    }
+    state.SetItemsProcessed(state.iterations() * boards.size());
+  }
+
+  // The cached entry is dropped first, otherwise every call after the first
+  // is a cache hit
+  static void evaluatePosition(benchmark::State& state) {
+    run(state, [](Engine& engine, const Board& board) {
+      engine.evalCache[board.hash() & (EVAL_CACHE_ENTRIES - 1)].key ^= 1;
+      return engine.evaluatePosition(board, 0, 0);
+    });
+  }
+
+  static void evaluatePositionCached(benchmark::State& state) {
+    run(state, [](Engine& engine, const Board& board) {
+      return engine.evaluatePosition(board, 0, 0);
+    });
+  }
+
+  static void evaluateMaterial(benchmark::State& state) {
+    run(state, [](Engine& engine, const Board& board) {
+      return engine.evaluateMaterial(board);
+    });
+  }
+
+  static void evaluatePieceSquareTables(benchmark::State& state) {
+    run(state, [](Engine& engine, const Board& board) {
+      return engine.evaluatePieceSquareTables(board, false);
+    });
+  }
+
+  static void evaluateMobility(benchmark::State& state) {
+    run(state, [](Engine& engine, const Board& board) {
+      return engine.evaluateMobility(countAttackTerms(board));
+    });
+  }
+
+  static void kingEndgameScore(benchmark::State& state) {
+    run(state, [](Engine& engine, const Board& board) {
+      return engine.kingEndgameScore(board, Color::WHITE, Color::BLACK);
+    });
+  }
+};
+
+BENCHMARK(EngineBench::evaluatePosition)->Name("eval/evaluatePosition");
+BENCHMARK(EngineBench::evaluatePositionCached)
+    ->Name("eval/evaluatePositionCached");
+BENCHMARK(EngineBench::evaluateMaterial)->Name("eval/material");
+BENCHMARK(EngineBench::evaluatePieceSquareTables)->Name("eval/pieceSquareTables");
+BENCHMARK(EngineBench::evaluateMobility)->Name("eval/mobility");
+BENCHMARK(EngineBench::kingEndgameScore)->Name("eval/kingEndgameScore");
+
+BENCHMARK_MAIN();
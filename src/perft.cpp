@@ -0,0 +1,100 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "./engine/engine.hpp"
+
+// Compares make/unmake with copy-make move making, once in perft and once
+// in a fixed depth search.
+//
+// Usage: pawnstar-perft [perft depth] [search depth]
+
+const std::string POSITIONS[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+};
+
+uint64_t perftMakeUnmake(Board& board, int depth) {
+  Movelist moves;
+  movegen::legalmoves(moves, board);
+  if (depth == 1) return moves.size();
+
+  uint64_t nodes = 0;
+  for (const auto& move : moves) {
+    board.makeMove(move);
+    nodes += perftMakeUnmake(board, depth - 1);
+    board.unmakeMove(move);
+  }
+  return nodes;
+}
+
+uint64_t perftCopyMake(Board& board, int depth) {
+  Movelist moves;
+  movegen::legalmoves(moves, board);
+  if (depth == 1) return moves.size();
+
+  uint64_t nodes = 0;
+  const Board::Position saved = board.position();
+  for (const auto& move : moves) {
+    board.makeMove(move);
+    nodes += perftCopyMake(board, depth - 1);
+    board.unmakeMove(saved);
+  }
+  return nodes;
+}
+
+template <typename F>
+void report(const std::string& name, F run) {
+  auto start = std::chrono::steady_clock::now();
+  uint64_t nodes = run();
+  auto end = std::chrono::steady_clock::now();
+
+  auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - start)
+                .count();
+  uint64_t nps = nodes * 1000 / (ms > 0 ? ms : 1);
+
+  std::cout << name << ": " << nodes << " nodes " << ms << " ms " << nps
+            << " nps" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+  int perftDepth = (argc > 1) ? std::stoi(argv[1]) : 4;
+  int searchDepth = (argc > 2) ? std::stoi(argv[2]) : 4;
+
+  report("perft make/unmake", [&]() {
+    uint64_t nodes = 0;
+    for (const auto& fen : POSITIONS) {
+      Board board(fen);
+      nodes += perftMakeUnmake(board, perftDepth);
+    }
+    return nodes;
+  });
+
+  report("perft copy-make  ", [&]() {
+    uint64_t nodes = 0;
+    for (const auto& fen : POSITIONS) {
+      Board board(fen);
+      nodes += perftCopyMake(board, perftDepth);
+    }
+    return nodes;
+  });
+
+  for (bool copyMake : {false, true}) {
+    report(copyMake ? "search copy-make  " : "search make/unmake", [&]() {
+      uint64_t nodes = 0;
+      for (const auto& fen : POSITIONS) {
+        Engine engine;
+        engine.setCopyMake(copyMake);
+        engine.setPosition(fen);
+        engine.getBestMove(searchDepth);
+        nodes += engine.positionsSearched;
+      }
+      return nodes;
+    });
+  }
+
+  return 0;
+}
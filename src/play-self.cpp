@@ -1,230 +1,199 @@
 #include <signal.h>
 
+#include <algorithm>
 #include <atomic>
+#include <cctype>
 #include <chrono>
-#include <ctime>
-#include <fstream>
+#include <cstdint>
 #include <iostream>
-#include <sstream>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <vector>
 
 #include "./engine/engine.hpp"
+#include "./play/game.hpp"
+#include "./play/openings.hpp"
+#include "./play/pgn-writer.hpp"
 #include "chess-library/include/chess.hpp"  // Include the chess library
 
-// Configuration
-const int SEARCH_DEPTH = 4;  // Depth for engine search
-const int MAX_MOVES = 200;   // Max moves before declaring draw
-const bool SAVE_PGN = true;  // Whether to save games as PGN
-const std::string PGN_FILE = "self_play_games.pgn";
-
-// Global variables to handle crashes
-std::vector<std::string> g_currentSanMoves;
-std::string g_currentResult = "*";
-int g_currentGameNum = 0;
-bool g_gameInProgress = false;
-
-// Signal handler for crashes
-void signalHandler(int signum) {
-  std::cout << "Signal " << signum
-            << " received. Saving current game state before exit..."
-            << std::endl;
-
-  if (g_gameInProgress && SAVE_PGN) {
-    std::ofstream pgnFile(PGN_FILE, std::ios::app);
-    if (pgnFile.is_open()) {
-      // Create PGN with incomplete game
-      std::stringstream pgn;
-      pgn << "[Event \"Self-play Game (Interrupted)\"]" << std::endl;
-      pgn << "[Site \"Local\"]" << std::endl;
-
-      // Get current date
-      auto now = std::chrono::system_clock::now();
-      std::time_t time = std::chrono::system_clock::to_time_t(now);
-      std::tm* timeinfo = std::localtime(&time);
-      char buffer[80];
-      std::strftime(buffer, 80, "%Y.%m.%d", timeinfo);
-
-      pgn << "[Date \"" << buffer << "\"]" << std::endl;
-      pgn << "[Round \"" << g_currentGameNum << "\"]" << std::endl;
-      pgn << "[White \"Pawnstar\"]" << std::endl;
-      pgn << "[Black \"Pawnstar\"]" << std::endl;
-      pgn << "[Result \"" << g_currentResult << "\"]" << std::endl << std::endl;
-
-      // Directly write the SAN moves we've been storing
-      for (size_t i = 0; i < g_currentSanMoves.size(); ++i) {
-        if (i % 2 == 0) {
-          pgn << (i / 2 + 1) << ". ";
-        }
-
-        pgn << g_currentSanMoves[i] << " ";
-
-        // Line break every 5 full moves
-        if (i % 10 == 9) {
-          pgn << std::endl;
-        }
-      }
-
-      pgn << g_currentResult << std::endl << std::endl;
-      pgnFile << pgn.str();
-      pgnFile.close();
-      std::cout << "Interrupted game saved to " << PGN_FILE << std::endl;
+// Configuration, every value can be changed from the command line
+struct SelfPlayConfig {
+  int games = 1;
+  int concurrency = 1;   // Games played at the same time
+  int depth = 4;         // Depth for engine search
+  int maxMoves = 200;    // Max plies before declaring draw
+  int randomPlies = 8;   // Random opening plies when there is no book
+  uint64_t seed = 0;     // Seed for the random openings
+  std::string openingFile;
+  std::string pgnFile = "self_play_games.pgn";
+};
+
+// Set by the signal handler, the games in progress are saved as interrupted
+std::atomic<bool> g_stopRequested{false};
+
+void signalHandler(int) { g_stopRequested = true; }
+
+// Counts finished games and serializes the progress output
+struct SelfPlayStats {
+  std::mutex mutex;
+  int whiteWins = 0;
+  int blackWins = 0;
+  int draws = 0;
+  int interrupted = 0;
+};
+
+// One engine per worker, the workers take the next unplayed game until all
+// games are done
+void runWorker(const SelfPlayConfig& config,
+               const std::vector<std::string>& openings,
+               std::atomic<int>& nextGame, PgnWriter& writer,
+               SelfPlayStats& stats) {
+  PlayerOptions options;
+  options.depth = config.depth;
+  EnginePlayer engine(options);
+
+  while (!g_stopRequested) {
+    int index = nextGame.fetch_add(1);
+    if (index >= config.games) break;
+
+    std::string openingFen =
+        openings.empty() ? randomOpening(config.randomPlies, config.seed + index)
+                         : openings[index % openings.size()];
+
+    // The same engine plays both sides
+    GameRecord game = playGame(engine, engine, openingFen, config.maxMoves,
+                               g_stopRequested);
+    game.round = index + 1;
+    if (game.result == "*") game.event = "Self-play Game (Interrupted)";
+    writer.write(game);
+
+    std::lock_guard<std::mutex> lock(stats.mutex);
+    if (game.result == "1-0") {
+      stats.whiteWins++;
+    } else if (game.result == "0-1") {
+      stats.blackWins++;
+    } else if (game.result == "1/2-1/2") {
+      stats.draws++;
+    } else {
+      stats.interrupted++;
     }
-  }
 
-  exit(signum);
+    std::cout << "Game " << game.round << ": " << game.result << " in "
+              << game.sanMoves.size() << " plies (+" << stats.whiteWins
+              << " =" << stats.draws << " -" << stats.blackWins << ")"
+              << std::endl;
+  }
 }
 
-// Helper functions for PGN generation
-std::string getCurrentDateTime() {
-  auto now = std::chrono::system_clock::now();
-  std::time_t time = std::chrono::system_clock::to_time_t(now);
-  std::tm* timeinfo = std::localtime(&time);
-
-  char buffer[80];
-  std::strftime(buffer, 80, "%Y.%m.%d", timeinfo);
-  return std::string(buffer);
+void printUsage() {
+  std::cout << "Usage: pawnstar-selfplay [games] [options]\n"
+            << "  --concurrency N   games played in parallel (default 1)\n"
+            << "  --depth N         search depth (default 4)\n"
+            << "  --max-moves N     plies before a game is drawn (default 200)\n"
+            << "  --openings FILE   .epd or .pgn file with start positions\n"
+            << "  --random-plies N  random opening plies without a file "
+               "(default 8)\n"
+            << "  --seed N          seed for the random openings\n"
+            << "  --pgn FILE        output file (default self_play_games.pgn)\n";
 }
 
-std::string createPgn(const std::vector<std::string>& sanMoves,
-                      const std::string& result) {
-  std::stringstream pgn;
-
-  // PGN headers
-  pgn << "[Event \"Self-play Game\"]" << std::endl;
-  pgn << "[Site \"Local\"]" << std::endl;
-  pgn << "[Date \"" << getCurrentDateTime() << "\"]" << std::endl;
-  pgn << "[Round \"" << g_currentGameNum << "\"]" << std::endl;
-  pgn << "[White \"Pawnstar\"]" << std::endl;
-  pgn << "[Black \"Pawnstar\"]" << std::endl;
-  pgn << "[Result \"" << result << "\"]" << std::endl << std::endl;
-
-  // Write SAN moves directly
-  for (size_t i = 0; i < sanMoves.size(); ++i) {
-    if (i % 2 == 0) {
-      pgn << (i / 2 + 1) << ". ";
-    }
-    pgn << sanMoves[i] << " ";
-
-    // Line break every 5 full moves
-    if (i % 10 == 9) {
-      pgn << std::endl;
+bool parseArgs(int argc, char* argv[], SelfPlayConfig& config) {
+  config.seed = static_cast<uint64_t>(
+      std::chrono::steady_clock::now().time_since_epoch().count());
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+
+    if (arg == "--concurrency" && hasValue) {
+      config.concurrency = std::max(1, std::stoi(argv[++i]));
+    } else if (arg == "--depth" && hasValue) {
+      config.depth = std::stoi(argv[++i]);
+    } else if (arg == "--max-moves" && hasValue) {
+      config.maxMoves = std::stoi(argv[++i]);
+    } else if (arg == "--openings" && hasValue) {
+      config.openingFile = argv[++i];
+    } else if (arg == "--random-plies" && hasValue) {
+      config.randomPlies = std::stoi(argv[++i]);
+    } else if (arg == "--seed" && hasValue) {
+      config.seed = std::stoull(argv[++i]);
+    } else if (arg == "--pgn" && hasValue) {
+      config.pgnFile = argv[++i];
+    } else if (!arg.empty() && std::isdigit(static_cast<unsigned char>(arg[0]))) {
+      config.games = std::stoi(arg);
+    } else {
+      return false;
     }
   }
 
-  pgn << result << std::endl << std::endl;
-  return pgn.str();
+  return true;
 }
 
-void playSelfGame(int gameNum) {
-  std::cout << "=== Starting Game " << gameNum << " ===" << std::endl;
-
-  // Update global game tracking
-  g_currentGameNum = gameNum;
-  g_currentSanMoves.clear();
-  g_currentResult = "*";
-  g_gameInProgress = true;
-
-  // Initialize the engine
-  Engine engine;
-  engine.initilizeEngine();
-
-  // Initialize the chess library board
-  chess::Board board;
-  std::vector<std::string> sanMoves;
-  std::string result = "*";
-  int moveCount = 0;
+int main(int argc, char* argv[]) {
+  SelfPlayConfig config;
 
   try {
-    // Play game until conclusion
-    while (moveCount < MAX_MOVES) {
-      moveCount++;
-
-      // Get current FEN from chess library
-      std::string currentFen = board.getFen();
-
-      // Set the position in the engine
-      engine.setPosition(currentFen);
-
-      // Get best move from engine
-      std::string bestMove = engine.getBestMove(SEARCH_DEPTH);
-
-      // Check if game is over
-      if (bestMove.empty() || bestMove == "(none)") {
-        // Determine if checkmate or stalemate
-        bool isInCheck = board.inCheck();
-        if (isInCheck) {
-          // Checkmate
-          result = (moveCount % 2 == 1) ? "0-1" : "1-0";
-        } else {
-          // Stalemate
-          result = "1/2-1/2";
-        }
-        break;
-      }
-
-      Move bst = uci::uciToMove(board, bestMove);
-
-      // Convert UCI move to SAN using chess library
-      std::string sanMove = uci::moveToSan(board, bst);
-
-      std::cout << "Move " << moveCount << ": " << bestMove << " (" << sanMove
-                << ")" << std::endl;
-
-      // Make the move on the board
-      board.makeMove(bst);
-
-      // Store SAN move for PGN
-      sanMoves.push_back(sanMove);
-
-      // Update global tracking for crash handling
-      g_currentSanMoves = sanMoves;
-
-      // Check for draw conditions (simplified)
-      if (board.isHalfMoveDraw() || board.isInsufficientMaterial() ||
-          board.isRepetition() || moveCount >= MAX_MOVES) {
-        result = "1/2-1/2";
-        break;
-      }
+    if (!parseArgs(argc, argv, config)) {
+      printUsage();
+      return 1;
     }
-  } catch (const std::exception& e) {
-    std::cerr << "Error during game: " << e.what() << std::endl;
-    result = "*";  // Mark as incomplete
+  } catch (const std::exception&) {
+    printUsage();
+    return 1;
   }
 
-  // Update final result for crash handler
-  g_currentResult = result;
-  std::cout << "Game over: " << result << std::endl;
-
-  // Save game in PGN format if enabled
-  if (SAVE_PGN) {
-    std::ofstream pgnFile(PGN_FILE, std::ios::app);
-    if (pgnFile.is_open()) {
-      pgnFile << createPgn(sanMoves, result);
-      pgnFile.close();
-      std::cout << "Game saved to " << PGN_FILE << std::endl;
-    } else {
-      std::cerr << "Failed to open PGN file for writing" << std::endl;
+  // Register signal handlers, the running games are stopped and saved
+  signal(SIGINT, signalHandler);
+  signal(SIGTERM, signalHandler);
+
+  std::vector<std::string> openings;
+  if (!config.openingFile.empty()) {
+    openings = loadOpenings(config.openingFile);
+    if (openings.empty()) {
+      std::cerr << "No openings found in " << config.openingFile << std::endl;
+      return 1;
     }
+    std::cout << "Loaded " << openings.size() << " openings" << std::endl;
+  } else {
+    std::cout << "Random openings of " << config.randomPlies
+              << " plies, seed " << config.seed << std::endl;
   }
 
-  g_gameInProgress = false;
-}
-
-int main(int argc, char* argv[]) {
-  // Register signal handlers for crash recovery
-  signal(SIGINT, signalHandler);
-  signal(SIGSEGV, signalHandler);
-  signal(SIGTERM, signalHandler);
+  PgnWriter writer(config.pgnFile);
+  if (!writer.isOpen()) {
+    std::cerr << "Failed to open PGN file for writing" << std::endl;
+    return 1;
+  }
 
-  int numGames = (argc > 1) ? std::stoi(argv[1]) : 1;
+  std::cout << "Starting " << config.games << " self-play game(s) on "
+            << config.concurrency << " thread(s)" << std::endl;
 
-  std::cout << "Starting " << numGames << " self-play game(s)" << std::endl;
+  auto start = std::chrono::steady_clock::now();
 
-  for (int i = 1; i <= numGames; ++i) {
-    playSelfGame(i);
+  std::atomic<int> nextGame{0};
+  SelfPlayStats stats;
+  std::vector<std::thread> workers;
+  for (int i = 0; i < config.concurrency; ++i) {
+    workers.emplace_back(runWorker, std::cref(config), std::cref(openings),
+                         std::ref(nextGame), std::ref(writer),
+                         std::ref(stats));
   }
+  for (auto& worker : workers) worker.join();
+
+  writer.flush();
+
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  int played = writer.getGamesWritten();
+
+  std::cout << "Played " << played << " games in " << seconds << "s ("
+            << static_cast<int>(played * 3600.0 / std::max(seconds, 1e-3))
+            << " games/hour): +" << stats.whiteWins << " =" << stats.draws
+            << " -" << stats.blackWins;
+  if (stats.interrupted) std::cout << ", " << stats.interrupted << " interrupted";
+  std::cout << "\nGames saved to " << config.pgnFile << std::endl;
 
   return 0;
-}
\ No newline at end of file
+}
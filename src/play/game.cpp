@@ -0,0 +1,68 @@
+#include "game.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+GameRecord playGame(Player& white, Player& black, const std::string& fen,
+                    int maxMoves, const std::atomic<bool>& stop) {
+  GameRecord game;
+  game.white = white.getName();
+  game.black = black.getName();
+  game.startFen = fen;
+
+  // The players and the board are all kept in sync by playing the moves, so
+  // no position has to be rebuilt from a FEN during the game
+  bool samePlayer = &white == &black;
+  white.newGame(fen);
+  if (!samePlayer) black.newGame(fen);
+  Board board(fen);
+
+  try {
+    while (true) {
+      if (stop) return game;
+
+      auto [reason, outcome] = board.isGameOver();
+      if (outcome != GameResult::NONE) {
+        if (outcome == GameResult::LOSE) {
+          // Checkmate, the side to move lost
+          game.result = board.sideToMove() == Color::WHITE ? "0-1" : "1-0";
+        } else {
+          game.result = "1/2-1/2";
+        }
+        return game;
+      }
+
+      if (static_cast<int>(game.sanMoves.size()) >= maxMoves) {
+        game.result = "1/2-1/2";
+        return game;
+      }
+
+      Player& toMove = board.sideToMove() == Color::WHITE ? white : black;
+      std::string bestMove = toMove.getBestMove();
+
+      // Moves from other engines are checked against the legal moves
+      Move move = bestMove.size() >= 4 ? uci::uciToMove(board, bestMove)
+                                       : Move(Move::NO_MOVE);
+      Movelist legalMoves;
+      movegen::legalmoves(legalMoves, board);
+      if (std::find(legalMoves.begin(), legalMoves.end(), move) ==
+          legalMoves.end()) {
+        std::cerr << toMove.getName() << " returned an illegal move '"
+                  << bestMove << "' in " << board.getFen() << std::endl;
+        return game;
+      }
+
+      game.sanMoves.push_back(uci::moveToSan(board, move));
+
+      board.makeMove(move);
+      white.playMove(bestMove);
+      if (!samePlayer) black.playMove(bestMove);
+    }
+  } catch (const std::exception& e) {
+    std::cerr << "Error during game: " << e.what() << std::endl;
+  }
+
+  // Mark as incomplete
+  game.result = "*";
+  return game;
+}
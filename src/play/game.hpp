@@ -0,0 +1,16 @@
+#ifndef GAME_HPP
+#define GAME_HPP
+
+#include <atomic>
+#include <string>
+
+#include "pgn-writer.hpp"
+#include "player.hpp"
+
+// Plays one game from `fen`. White and black may be the same player, which
+// is then told about every move once. A game that is still running when
+// `stop` is set, or in which a player fails, gets the result "*".
+GameRecord playGame(Player& white, Player& black, const std::string& fen,
+                    int maxMoves, const std::atomic<bool>& stop);
+
+#endif
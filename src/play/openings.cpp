@@ -0,0 +1,107 @@
+#include "openings.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <random>
+
+namespace {
+
+// Collects the final position of every game in a PGN file
+class OpeningVisitor : public pgn::Visitor {
+ public:
+  explicit OpeningVisitor(std::vector<std::string>& fens) : fens(fens) {}
+
+  void startPgn() override {
+    board.setFen(constants::STARTPOS);
+    valid = true;
+  }
+
+  void header(std::string_view key, std::string_view value) override {
+    if (key == "FEN") board.setFen(value);
+  }
+
+  void startMoves() override {}
+
+  void move(std::string_view move, std::string_view) override {
+    if (!valid) return;
+
+    try {
+      board.makeMove<true>(uci::parseSan(board, move));
+    } catch (const std::exception&) {
+      valid = false;
+    }
+  }
+
+  void endPgn() override {
+    if (valid) fens.push_back(board.getFen());
+  }
+
+ private:
+  std::vector<std::string>& fens;
+  Board board;
+  bool valid = true;
+};
+
+bool endsWith(const std::string& str, const std::string& suffix) {
+  return str.size() >= suffix.size() &&
+         str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+}  // namespace
+
+std::vector<std::string> loadOpenings(const std::string& path) {
+  std::vector<std::string> fens;
+  std::ifstream file(path);
+
+  if (!file.is_open()) {
+    std::cerr << "Failed to open opening file " << path << std::endl;
+    return fens;
+  }
+
+  if (endsWith(path, ".pgn")) {
+    OpeningVisitor visitor(fens);
+    pgn::StreamParser parser(file);
+    parser.readGames(visitor);
+    return fens;
+  }
+
+  // EPD lines have 4 fields followed by operations, plain FENs have 6
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.empty() || line[0] == '#') continue;
+
+    try {
+      auto fields = utils::splitString(line, ' ');
+      bool isFen = fields.size() >= 6 && fields[4].find(';') == std::string::npos;
+      Board board = isFen ? Board::fromFen(line) : Board::fromEpd(line);
+      fens.push_back(board.getFen());
+    } catch (const std::exception&) {
+      std::cerr << "Skipping invalid opening: " << line << std::endl;
+    }
+  }
+
+  return fens;
+}
+
+std::string randomOpening(int plies, uint64_t seed) {
+  std::mt19937_64 rng(seed);
+  Board board;
+  Movelist moves;
+
+  // Random moves can walk into a mate or stalemate, in which case we start
+  // again with the next numbers from the generator
+  for (int attempt = 0; attempt < 100; attempt++) {
+    board.setFen(constants::STARTPOS);
+
+    int ply = 0;
+    for (; ply < plies; ply++) {
+      movegen::legalmoves(moves, board);
+      if (moves.empty()) break;
+      board.makeMove<true>(moves[rng() % moves.size()]);
+    }
+
+    if (ply == plies && board.isGameOver().second == GameResult::NONE) break;
+  }
+
+  return board.getFen();
+}
@@ -0,0 +1,27 @@
+#ifndef OPENINGS_HPP
+#define OPENINGS_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../chess-library/include/chess.hpp"
+
+using namespace chess;
+
+/*
+ * Opening positions for self-play and matches
+ *
+ * Openings are kept as FENs. They are either read from a file (one EPD or
+ * FEN per line, or the final position of every game in a PGN file) or made
+ * by playing a few random legal moves from the start position.
+ */
+
+// Loads the openings from an .epd or .pgn file, empty if nothing was read
+std::vector<std::string> loadOpenings(const std::string& path);
+
+// Plays `plies` random legal moves from the start position. The same seed
+// always gives the same opening, whatever thread asks for it.
+std::string randomOpening(int plies, uint64_t seed);
+
+#endif
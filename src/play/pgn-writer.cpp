@@ -0,0 +1,95 @@
+#include "pgn-writer.hpp"
+
+#include <chrono>
+#include <ctime>
+#include <sstream>
+
+namespace {
+
+std::string getCurrentDate() {
+  auto now = std::chrono::system_clock::now();
+  std::time_t time = std::chrono::system_clock::to_time_t(now);
+  std::tm timeinfo{};
+#ifdef _WIN32
+  localtime_s(&timeinfo, &time);
+#else
+  localtime_r(&time, &timeinfo);
+#endif
+
+  char buffer[80];
+  std::strftime(buffer, 80, "%Y.%m.%d", &timeinfo);
+  return std::string(buffer);
+}
+
+}  // namespace
+
+std::string createPgn(const GameRecord& game) {
+  std::stringstream pgn;
+
+  // PGN headers
+  pgn << "[Event \"" << game.event << "\"]\n";
+  pgn << "[Site \"Local\"]\n";
+  pgn << "[Date \"" << getCurrentDate() << "\"]\n";
+  pgn << "[Round \"" << game.round << "\"]\n";
+  pgn << "[White \"" << game.white << "\"]\n";
+  pgn << "[Black \"" << game.black << "\"]\n";
+  pgn << "[Result \"" << game.result << "\"]\n";
+
+  if (game.startFen != constants::STARTPOS) {
+    pgn << "[SetUp \"1\"]\n";
+    pgn << "[FEN \"" << game.startFen << "\"]\n";
+  }
+  pgn << "\n";
+
+  // Move numbers continue from the starting position
+  Board board(game.startFen);
+  int moveNumber = board.fullMoveNumber();
+  bool whiteToMove = board.sideToMove() == Color::WHITE;
+
+  for (size_t i = 0; i < game.sanMoves.size(); ++i) {
+    if (whiteToMove) {
+      pgn << moveNumber << ". ";
+    } else if (i == 0) {
+      pgn << moveNumber << "... ";
+    }
+    pgn << game.sanMoves[i] << " ";
+
+    // Line break every 5 full moves
+    if (i % 10 == 9) {
+      pgn << "\n";
+    }
+
+    if (!whiteToMove) moveNumber++;
+    whiteToMove = !whiteToMove;
+  }
+
+  pgn << game.result << "\n\n";
+  return pgn.str();
+}
+
+PgnWriter::PgnWriter(const std::string& path, size_t flushBytes)
+    : file(path, std::ios::app), flushBytes(flushBytes) {
+  buffer.reserve(flushBytes);
+}
+
+void PgnWriter::write(const GameRecord& game) {
+  // Format outside the lock, only the append is serialized
+  std::string pgn = createPgn(game);
+
+  std::lock_guard<std::mutex> lock(mutex);
+  buffer += pgn;
+  gamesWritten++;
+  if (buffer.size() >= flushBytes) flushLocked();
+}
+
+void PgnWriter::flush() {
+  std::lock_guard<std::mutex> lock(mutex);
+  flushLocked();
+}
+
+void PgnWriter::flushLocked() {
+  if (buffer.empty()) return;
+  file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+  file.flush();
+  buffer.clear();
+}
@@ -0,0 +1,58 @@
+#ifndef PGN_WRITER_HPP
+#define PGN_WRITER_HPP
+
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "../chess-library/include/chess.hpp"
+
+using namespace chess;
+
+// A finished (or interrupted) game
+struct GameRecord {
+  std::string event = "Self-play Game";
+  std::string white = "Pawnstar";
+  std::string black = "Pawnstar";
+  std::string startFen = constants::STARTPOS;
+  std::vector<std::string> sanMoves;
+  std::string result = "*";
+  int round = 0;
+};
+
+// Formats a game as PGN text
+std::string createPgn(const GameRecord& game);
+
+/*
+ * Appends games to one PGN file from any number of threads.
+ *
+ * Games are collected in a buffer under a lock and only written out once it
+ * holds `flushBytes`, on flush() and when the writer is destroyed.
+ */
+class PgnWriter {
+ private:
+  std::ofstream file;
+  std::mutex mutex;
+  std::string buffer;
+  size_t flushBytes;
+  int gamesWritten = 0;
+
+  void flushLocked();
+
+ public:
+  explicit PgnWriter(const std::string& path, size_t flushBytes = 1 << 16);
+  ~PgnWriter() { flush(); }
+
+  bool isOpen() const { return file.is_open(); }
+
+  void write(const GameRecord& game);
+  void flush();
+
+  int getGamesWritten() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return gamesWritten;
+  }
+};
+
+#endif
@@ -0,0 +1,183 @@
+#include "player.hpp"
+
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+bool PlayerOptions::parse(const std::string& spec) {
+  try {
+    for (auto field : utils::splitString(spec, ',')) {
+      auto separator = field.find('=');
+      if (separator == std::string_view::npos) return false;
+
+      std::string key(field.substr(0, separator));
+      std::string value(field.substr(separator + 1));
+
+      if (key == "name") {
+        name = value;
+      } else if (key == "cmd") {
+        command = value;
+      } else if (key == "depth") {
+        depth = std::stoi(value);
+      } else if (key == "movetime") {
+        movetime = std::stoi(value);
+      } else if (key == "copymake") {
+        copyMake = value == "on" || value == "true" || value == "1";
+      } else {
+        return false;
+      }
+    }
+  } catch (const std::exception&) {
+    return false;
+  }
+
+  return true;
+}
+
+EnginePlayer::EnginePlayer(const PlayerOptions& options) : options(options) {
+  engine.setPrintInfo(false);
+  engine.setCopyMake(options.copyMake);
+}
+
+void EnginePlayer::newGame(const std::string& fen) { engine.setPosition(fen); }
+
+void EnginePlayer::playMove(const std::string& uciMove) {
+  engine.makeMove(uciMove);
+}
+
+std::string EnginePlayer::getBestMove() {
+  return engine.getBestMove(options.depth);
+}
+
+std::unique_ptr<Player> createPlayer(const PlayerOptions& options) {
+  if (options.command.empty()) return std::make_unique<EnginePlayer>(options);
+  return std::make_unique<UciPlayer>(options);
+}
+
+#ifndef _WIN32
+
+UciPlayer::UciPlayer(const PlayerOptions& options) : options(options) {
+  int input[2], output[2];
+  if (pipe(input) != 0 || pipe(output) != 0) {
+    throw std::runtime_error("pipe failed for " + options.command);
+  }
+
+  // Engines started later must not inherit our ends of these pipes, or this
+  // engine would never see end of file on its input
+  for (int fd : {input[0], input[1], output[0], output[1]}) {
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+  }
+
+  pid = fork();
+  if (pid < 0) throw std::runtime_error("fork failed for " + options.command);
+
+  if (pid == 0) {
+    dup2(input[0], STDIN_FILENO);
+    dup2(output[1], STDOUT_FILENO);
+    close(input[0]);
+    close(input[1]);
+    close(output[0]);
+    close(output[1]);
+    execl(options.command.c_str(), options.command.c_str(),
+          static_cast<char*>(nullptr));
+    _exit(127);
+  }
+
+  close(input[0]);
+  close(output[1]);
+  toEngine = fdopen(input[1], "w");
+  fromEngine = fdopen(output[0], "r");
+
+  // A dead engine should fail the game, not kill the match with SIGPIPE
+  signal(SIGPIPE, SIG_IGN);
+
+  send("uci");
+  waitFor("uciok");
+  send("isready");
+  waitFor("readyok");
+}
+
+UciPlayer::~UciPlayer() {
+  if (toEngine) {
+    send("quit");
+    fclose(toEngine);
+  }
+  if (fromEngine) fclose(fromEngine);
+  if (pid > 0) waitpid(pid, nullptr, 0);
+}
+
+void UciPlayer::send(const std::string& command) {
+  fputs(command.c_str(), toEngine);
+  fputc('\n', toEngine);
+  fflush(toEngine);
+}
+
+std::string UciPlayer::waitFor(const std::string& token) {
+  std::string line;
+  int c;
+
+  while ((c = fgetc(fromEngine)) != EOF) {
+    if (c != '\n') {
+      line += static_cast<char>(c);
+      continue;
+    }
+
+    if (line.compare(0, token.size(), token) == 0) return line;
+    line.clear();
+  }
+
+  throw std::runtime_error(options.name + " exited while waiting for " +
+                           token);
+}
+
+void UciPlayer::newGame(const std::string& fen) {
+  startFen = fen;
+  moves.clear();
+  send("ucinewgame");
+  send("isready");
+  waitFor("readyok");
+}
+
+void UciPlayer::playMove(const std::string& uciMove) {
+  if (!moves.empty()) moves += ' ';
+  moves += uciMove;
+}
+
+std::string UciPlayer::getBestMove() {
+  std::string position = "position fen " + startFen;
+  if (!moves.empty()) position += " moves " + moves;
+  send(position);
+
+  if (options.movetime > 0) {
+    send("go movetime " + std::to_string(options.movetime));
+  } else {
+    send("go depth " + std::to_string(options.depth));
+  }
+
+  // "bestmove e2e4 ponder e7e5"
+  std::string line = waitFor("bestmove");
+  auto fields = utils::splitString(line, ' ');
+  if (fields.size() < 2 || fields[1] == "(none)") return "";
+  return std::string(fields[1]);
+}
+
+#else
+
+UciPlayer::UciPlayer(const PlayerOptions& options) : options(options) {
+  throw std::runtime_error("UCI engines are only supported on POSIX systems");
+}
+
+UciPlayer::~UciPlayer() {}
+
+void UciPlayer::send(const std::string&) {}
+std::string UciPlayer::waitFor(const std::string&) { return ""; }
+void UciPlayer::newGame(const std::string&) {}
+void UciPlayer::playMove(const std::string&) {}
+std::string UciPlayer::getBestMove() { return ""; }
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef PLAYER_HPP
+#define PLAYER_HPP
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../engine/engine.hpp"
+
+/*
+ * One side of a game. The game loop tells every player about each move that
+ * is played and asks the side to move for its best move.
+ */
+class Player {
+ public:
+  virtual ~Player() = default;
+
+  virtual const std::string& getName() const = 0;
+
+  // Starts a new game from the given position
+  virtual void newGame(const std::string& fen) = 0;
+
+  // Called for every move played by either side
+  virtual void playMove(const std::string& uciMove) = 0;
+
+  // Best move in the current position, empty if there is none
+  virtual std::string getBestMove() = 0;
+};
+
+// Search settings of a player, parsed from "key=value,key=value"
+struct PlayerOptions {
+  std::string name = "Pawnstar";
+  std::string command;  // A UCI executable, in-process engine when empty
+  int depth = 4;
+  int movetime = 0;  // Milliseconds per move for UCI engines, 0 to use depth
+  bool copyMake = false;
+
+  // Returns false on an unknown key or bad value
+  bool parse(const std::string& spec);
+};
+
+// The engine of this build, running in the calling thread
+class EnginePlayer : public Player {
+ private:
+  PlayerOptions options;
+  Engine engine;
+
+ public:
+  explicit EnginePlayer(const PlayerOptions& options);
+
+  const std::string& getName() const override { return options.name; }
+  void newGame(const std::string& fen) override;
+  void playMove(const std::string& uciMove) override;
+  std::string getBestMove() override;
+};
+
+// An external UCI engine talking to us over pipes
+class UciPlayer : public Player {
+ private:
+  PlayerOptions options;
+  int pid = -1;
+  FILE* toEngine = nullptr;
+  FILE* fromEngine = nullptr;
+
+  std::string startFen;
+  std::string moves;  // Space separated UCI moves since startFen
+
+  void send(const std::string& command);
+  // Reads lines until one starts with `token` and returns that line
+  std::string waitFor(const std::string& token);
+
+ public:
+  // Starts the engine process, throws if it cannot be started
+  explicit UciPlayer(const PlayerOptions& options);
+  ~UciPlayer() override;
+
+  UciPlayer(const UciPlayer&) = delete;
+  UciPlayer& operator=(const UciPlayer&) = delete;
+
+  const std::string& getName() const override { return options.name; }
+  void newGame(const std::string& fen) override;
+  void playMove(const std::string& uciMove) override;
+  std::string getBestMove() override;
+};
+
+// A UciPlayer when the options name a command, otherwise an EnginePlayer
+std::unique_ptr<Player> createPlayer(const PlayerOptions& options);
+
+#endif
@@ -0,0 +1,82 @@
+#include "sprt.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+double eloToScore(double elo) { return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0)); }
+
+double scoreToElo(double score) {
+  score = std::clamp(score, 1e-6, 1.0 - 1e-6);
+  return -400.0 * std::log10(1.0 / score - 1.0);
+}
+
+// Mean and variance of the per pair score, scaled to 0..1. Every bucket gets
+// a small prior count, otherwise the variance of the first few pairs is close
+// to zero and the LLR jumps past the bounds after a single pair.
+void pairMoments(const std::array<int, 5>& pairs, double& count, double& mean,
+                 double& variance) {
+  constexpr double PSEUDO_COUNT = 0.25;
+
+  count = 0;
+  mean = 0;
+  for (int i = 0; i < 5; i++) {
+    double n = pairs[i] + PSEUDO_COUNT;
+    count += n;
+    mean += n * i / 4.0;
+  }
+  mean /= count;
+
+  variance = 0;
+  for (int i = 0; i < 5; i++) {
+    double n = pairs[i] + PSEUDO_COUNT;
+    variance += n * (i / 4.0 - mean) * (i / 4.0 - mean);
+  }
+  variance /= count;
+}
+
+}  // namespace
+
+void MatchStats::addPair(double firstScore, double secondScore) {
+  for (double score : {firstScore, secondScore}) {
+    if (score == 1.0) {
+      wins++;
+    } else if (score == 0.0) {
+      losses++;
+    } else {
+      draws++;
+    }
+  }
+
+  pairs[static_cast<int>(std::lround((firstScore + secondScore) * 2))]++;
+}
+
+double MatchStats::elo() const {
+  double count, mean, variance;
+  pairMoments(pairs, count, mean, variance);
+  return scoreToElo(mean);
+}
+
+double MatchStats::eloError() const {
+  double count, mean, variance;
+  pairMoments(pairs, count, mean, variance);
+
+  double margin = 1.959964 * std::sqrt(variance / count);
+  return (scoreToElo(mean + margin) - scoreToElo(mean - margin)) / 2.0;
+}
+
+double MatchStats::llr(double elo0, double elo1) const {
+  double count, mean, variance;
+  pairMoments(pairs, count, mean, variance);
+  if (games() == 0) return 0.0;
+
+  double score0 = eloToScore(elo0);
+  double score1 = eloToScore(elo1);
+  return count * (score1 - score0) * (2 * mean - score0 - score1) /
+         (2 * variance);
+}
+
+SprtBounds SprtBounds::fromErrors(double alpha, double beta) {
+  return {std::log(beta / (1.0 - alpha)), std::log((1.0 - beta) / alpha)};
+}
@@ -0,0 +1,46 @@
+#ifndef SPRT_HPP
+#define SPRT_HPP
+
+#include <array>
+
+/*
+ * Match statistics for SPRT testing
+ *
+ * Games are played in pairs on the same opening with colors reversed, so
+ * the results are counted per pair (pentanomial). The pair score of the
+ * first engine is 0, 0.5, 1, 1.5 or 2 points. Using pairs removes most of
+ * the noise that comes from unbalanced openings.
+ *
+ * Elo is logistic Elo. The log-likelihood ratio uses the normal
+ * approximation of the generalized SPRT as used by fishtest.
+ */
+
+struct MatchStats {
+  // From the first engine's point of view
+  int wins = 0;
+  int draws = 0;
+  int losses = 0;
+  // Number of pairs by score in half points
+  std::array<int, 5> pairs{};
+
+  // Scores are 0, 0.5 or 1 for the first engine in each game of the pair
+  void addPair(double firstScore, double secondScore);
+
+  int games() const { return wins + draws + losses; }
+
+  double elo() const;
+  // Half width of the 95% confidence interval
+  double eloError() const;
+  // Log-likelihood ratio of H1 (elo1) against H0 (elo0)
+  double llr(double elo0, double elo1) const;
+};
+
+// Decision bounds for the log-likelihood ratio from the error rates
+struct SprtBounds {
+  double lower;  // H0 is accepted below this
+  double upper;  // H1 is accepted above this
+
+  static SprtBounds fromErrors(double alpha, double beta);
+};
+
+#endif
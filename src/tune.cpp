@@ -0,0 +1,616 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "./engine/engine.hpp"
+#include "./engine/pbin.hpp"
+
+/*
+ * Texel tuner for the evaluation parameters
+ *
+ * The evaluation is a sum of parameters times integer coefficients (piece
+ * counts, piece-square occupancy, mobility, ...), so every position is
+ * turned into a short list of non-zero coefficients once when it is loaded.
+ * A training pass then only needs a dot product per position. The parameters
+ * are fitted with Adam to minimize the squared error between
+ * sigmoid(K * eval) and the game result, and written out as a new
+ * piece-maps.hpp.
+ *
+ * Usage: pawnstar-tune [options] data.pbin...
+ */
+
+// Parameter layout
+constexpr int MATERIAL_OFFSET = 0;  // Pawn to queen
+constexpr int PST_OFFSET = MATERIAL_OFFSET + 5;
+constexpr int PST_COUNT = 7;  // Pawn to queen, king middle game, king endgame
+constexpr int MOBILITY_INDEX = PST_OFFSET + PST_COUNT * 64;
+constexpr int KING_CORNER_INDEX = MOBILITY_INDEX + 1;
+constexpr int KING_EDGE_INDEX = KING_CORNER_INDEX + 1;
+constexpr int DOUBLED_PAWN_INDEX = KING_EDGE_INDEX + 1;
+constexpr int ISOLATED_PAWN_INDEX = DOUBLED_PAWN_INDEX + 1;
+constexpr int BACKWARD_PAWN_INDEX = ISOLATED_PAWN_INDEX + 1;
+constexpr int CONNECTED_PAWN_INDEX = BACKWARD_PAWN_INDEX + 1;
+constexpr int CANDIDATE_PAWN_INDEX = CONNECTED_PAWN_INDEX + 1;
+constexpr int PASSED_PAWN_OFFSET = CANDIDATE_PAWN_INDEX + 1;  // By rank
+constexpr int BISHOP_PAIR_INDEX = PASSED_PAWN_OFFSET + 8;
+constexpr int KNIGHT_PAWN_INDEX = BISHOP_PAIR_INDEX + 1;
+constexpr int ROOK_PAWN_INDEX = KNIGHT_PAWN_INDEX + 1;
+constexpr int PAWN_SHIELD_INDEX = ROOK_PAWN_INDEX + 1;
+constexpr int PAWN_STORM_INDEX = PAWN_SHIELD_INDEX + 1;
+constexpr int KING_SAFETY_OFFSET = PAWN_STORM_INDEX + 1;  // By attack units
+constexpr int NUM_PARAMS = KING_SAFETY_OFFSET + KING_SAFETY_UNITS;
+
+const int* const TABLES[PST_COUNT] = {
+    PAWN_TABLE,  KNIGHT_TABLE,      BISHOP_TABLE,  ROOK_TABLE,
+    QUEEN_TABLE, KING_MIDDLE_TABLE, KING_END_TABLE};
+
+const char* const TABLE_NAMES[PST_COUNT] = {
+    "PAWN_TABLE",  "KNIGHT_TABLE",      "BISHOP_TABLE",  "ROOK_TABLE",
+    "QUEEN_TABLE", "KING_MIDDLE_TABLE", "KING_END_TABLE"};
+
+const char* const TABLE_COMMENTS[PST_COUNT] = {
+    "Pawn piece-square table",
+    "Knight piece-square table",
+    "Bishop piece-square table",
+    "Rook piece-square table",
+    "Queen piece-square table",
+    "King middle game piece-square table",
+    "King end game piece-square table"};
+
+struct TuneConfig {
+  std::vector<std::string> inputs;
+  std::string output = "piece-maps.hpp";
+  int epochs = 1000;
+  double learningRate = 1.0;
+  double lambda = 1.0;  // Weight of the game result against the search score
+  double k = 0.0;       // Fitted when 0
+  int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+};
+
+// Coefficients are white minus black, the evaluation is from whites side
+struct TuneCoef {
+  uint16_t index;
+  int16_t value;
+};
+
+struct TunePosition {
+  uint32_t firstCoef;
+  uint16_t coefCount;
+  float target;  // 1 white wins, 0 black wins
+};
+
+struct TuneData {
+  std::vector<TunePosition> positions;
+  std::vector<TuneCoef> coefs;
+};
+
+// Runs fn(begin, end, thread) on one chunk of [0, count) per thread
+template <typename Fn>
+void parallelFor(size_t count, int threads, Fn fn) {
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(threads) schedule(static)
+  for (int t = 0; t < threads; t++) {
+    fn(count * t / threads, count * (t + 1) / threads, t);
+  }
+#else
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; t++) {
+    workers.emplace_back(fn, count * t / threads, count * (t + 1) / threads,
+                         t);
+  }
+  for (auto& worker : workers) worker.join();
+#endif
+}
+
+std::vector<double> initialParams() {
+  std::vector<double> params(NUM_PARAMS);
+  const int material[5] = {PAWN_VALUE, KNIGHT_VALUE, BISHOP_VALUE, ROOK_VALUE,
+                           QUEEN_VALUE};
+
+  for (int i = 0; i < 5; i++) params[MATERIAL_OFFSET + i] = material[i];
+  for (int t = 0; t < PST_COUNT; t++) {
+    for (int sq = 0; sq < 64; sq++) params[PST_OFFSET + t * 64 + sq] = TABLES[t][sq];
+  }
+  params[MOBILITY_INDEX] = MOBILITY_WEIGHT;
+  params[KING_CORNER_INDEX] = KING_CORNER_BONUS;
+  params[KING_EDGE_INDEX] = KING_EDGE_BONUS;
+  params[DOUBLED_PAWN_INDEX] = DOUBLED_PAWN;
+  params[ISOLATED_PAWN_INDEX] = ISOLATED_PAWN;
+  params[BACKWARD_PAWN_INDEX] = BACKWARD_PAWN;
+  params[CONNECTED_PAWN_INDEX] = CONNECTED_PAWN;
+  params[CANDIDATE_PAWN_INDEX] = CANDIDATE_PAWN;
+  for (int rank = 0; rank < 8; rank++) {
+    params[PASSED_PAWN_OFFSET + rank] = PASSED_PAWN_BONUS[rank];
+  }
+  params[BISHOP_PAIR_INDEX] = BISHOP_PAIR_BONUS;
+  params[KNIGHT_PAWN_INDEX] = KNIGHT_PAWN_ADJUST;
+  params[ROOK_PAWN_INDEX] = ROOK_PAWN_ADJUST;
+  params[PAWN_SHIELD_INDEX] = PAWN_SHIELD;
+  params[PAWN_STORM_INDEX] = PAWN_STORM;
+  for (int units = 0; units < KING_SAFETY_UNITS; units++) {
+    params[KING_SAFETY_OFFSET + units] = KING_SAFETY_TABLE[units];
+  }
+
+  return params;
+}
+
+// Mirrors Engine::evaluatePosition, `coefs` gets one entry per parameter
+void extractCoefs(const Board& board, std::vector<int>& coefs) {
+  std::fill(coefs.begin(), coefs.end(), 0);
+
+  bool isEndgame = (board.pieces(PieceType::QUEEN, Color::WHITE).count() +
+                        board.pieces(PieceType::QUEEN, Color::BLACK).count() ==
+                    0);
+
+  for (Square sq = 0; sq < 64; sq++) {
+    Piece piece = board.at(sq);
+    if (piece.type() == PieceType::NONE) continue;
+
+    bool white = piece.color() == Color::WHITE;
+    int sign = white ? 1 : -1;
+    int index = white ? mirrorIndex(sq.index()) : sq.index();
+    int type = static_cast<int>(piece.type());
+
+    if (piece.type() != PieceType::KING) {
+      coefs[MATERIAL_OFFSET + type] += sign;
+    } else if (isEndgame) {
+      type = 6;
+    }
+    coefs[PST_OFFSET + type * 64 + index] += sign;
+  }
+
+  AttackTerms attacks = countAttackTerms(board);
+  coefs[MOBILITY_INDEX] = attacks.mobility[0] - attacks.mobility[1];
+
+  // King safety is a table lookup by attack units, so the entry of each
+  // side's units is the coefficient
+  if (!isEndgame) {
+    coefs[KING_SAFETY_OFFSET + attacks.attackUnits[0]] += 1;
+    coefs[KING_SAFETY_OFFSET + attacks.attackUnits[1]] -= 1;
+
+    for (Color color : {Color::WHITE, Color::BLACK}) {
+      KingPawnTerms terms = countKingPawnTerms(
+          board.pieces(PieceType::PAWN, color),
+          board.pieces(PieceType::PAWN, ~color), color, board.kingSq(color));
+      int sign = color == Color::WHITE ? 1 : -1;
+      coefs[PAWN_SHIELD_INDEX] += sign * terms.shield;
+      coefs[PAWN_STORM_INDEX] += sign * terms.storm;
+    }
+  }
+
+  for (Color color : {Color::WHITE, Color::BLACK}) {
+    PawnTerms terms = countPawnTerms(board.pieces(PieceType::PAWN, color),
+                                     board.pieces(PieceType::PAWN, ~color),
+                                     color);
+    int sign = color == Color::WHITE ? 1 : -1;
+
+    coefs[DOUBLED_PAWN_INDEX] += sign * terms.doubled;
+    coefs[ISOLATED_PAWN_INDEX] += sign * terms.isolated;
+    coefs[BACKWARD_PAWN_INDEX] += sign * terms.backward;
+    coefs[CONNECTED_PAWN_INDEX] += sign * terms.connected;
+    coefs[CANDIDATE_PAWN_INDEX] += sign * terms.candidate;
+    for (int rank = 0; rank < 8; rank++) {
+      coefs[PASSED_PAWN_OFFSET + rank] += sign * terms.passed[rank];
+    }
+
+    ImbalanceTerms imbalance = countImbalanceTerms(board, color);
+    coefs[BISHOP_PAIR_INDEX] += sign * imbalance.bishopPair;
+    coefs[KNIGHT_PAWN_INDEX] += sign * imbalance.knightPawns;
+    coefs[ROOK_PAWN_INDEX] += sign * imbalance.rookPawns;
+  }
+
+  // The king distance part of kingEndgameScore cancels out
+  if (isEndgame) {
+    for (Color color : {Color::WHITE, Color::BLACK}) {
+      Square king = board.kingSq(~color);
+      int file = king.file(), rank = king.rank();
+      int sign = color == Color::WHITE ? 1 : -1;
+
+      bool fileEdge = file == 0 || file == 7;
+      bool rankEdge = rank == 0 || rank == 7;
+      if (fileEdge && rankEdge) {
+        coefs[KING_CORNER_INDEX] += sign;
+      } else if (fileEdge || rankEdge) {
+        coefs[KING_EDGE_INDEX] += sign;
+      }
+    }
+  }
+}
+
+// Positions the engine scores as a sum of the parameters. Insufficient
+// material is a draw without an evaluation, and known endgames have their
+// own evaluation or scale factor.
+bool isTunable(const Board& board) {
+  if (board.isInsufficientMaterial()) return false;
+
+  MaterialEntry material;
+  computeMaterial(board, material);
+  return !material.isSpecial(board);
+}
+
+double sigmoid(double k, double eval) { return 1.0 / (1.0 + std::exp(-k * eval)); }
+
+// Loads the records and turns them into coefficients, one chunk per thread
+TuneData loadData(const TuneConfig& config) {
+  std::vector<PbinRecord> records;
+  for (const auto& path : config.inputs) {
+    PbinReader reader(path);
+    if (!reader.isOpen()) {
+      std::cerr << "Skipping " << path << ", not a .pbin file" << std::endl;
+      continue;
+    }
+
+    const PbinRecord* batch;
+    size_t count;
+    while ((count = reader.next(batch)) > 0) {
+      records.insert(records.end(), batch, batch + count);
+    }
+  }
+
+  // The search score is turned into a win probability with the standard
+  // 400 point logistic curve before it is blended with the result
+  constexpr double SCORE_SCALE = 2.302585092994046 / 400.0;
+
+  std::vector<TuneData> chunks(config.threads);
+  parallelFor(records.size(), config.threads,
+              [&](size_t begin, size_t end, int thread) {
+                TuneData& chunk = chunks[thread];
+                std::vector<int> coefs(NUM_PARAMS);
+
+                for (size_t i = begin; i < end; i++) {
+                  const PbinRecord& record = records[i];
+                  Board board = record.toBoard();
+
+                  if (!isTunable(board)) continue;
+                  extractCoefs(board, coefs);
+
+                  bool whiteToMove = board.sideToMove() == Color::WHITE;
+                  double score = whiteToMove ? record.score : -record.score;
+                  double result = (static_cast<int>(record.result) + 1) / 2.0;
+
+                  TunePosition position;
+                  position.firstCoef = static_cast<uint32_t>(chunk.coefs.size());
+                  position.target = static_cast<float>(
+                      config.lambda * result +
+                      (1.0 - config.lambda) * sigmoid(SCORE_SCALE, score));
+
+                  for (int p = 0; p < NUM_PARAMS; p++) {
+                    if (coefs[p] == 0) continue;
+                    chunk.coefs.push_back(
+                        {static_cast<uint16_t>(p), static_cast<int16_t>(coefs[p])});
+                  }
+                  position.coefCount = static_cast<uint16_t>(
+                      chunk.coefs.size() - position.firstCoef);
+                  chunk.positions.push_back(position);
+                }
+              });
+
+  TuneData data;
+  for (auto& chunk : chunks) {
+    uint32_t offset = static_cast<uint32_t>(data.coefs.size());
+    for (auto& position : chunk.positions) {
+      position.firstCoef += offset;
+      data.positions.push_back(position);
+    }
+    data.coefs.insert(data.coefs.end(), chunk.coefs.begin(), chunk.coefs.end());
+  }
+
+  return data;
+}
+
+double evaluate(const TuneData& data, const TunePosition& position,
+                const std::vector<double>& params) {
+  double eval = 0;
+  const TuneCoef* coef = &data.coefs[position.firstCoef];
+  for (int i = 0; i < position.coefCount; i++, coef++) {
+    eval += coef->value * params[coef->index];
+  }
+  return eval;
+}
+
+// Mean squared error, and its gradient when `gradient` is given
+double computeLoss(const TuneData& data, const std::vector<double>& params,
+                   double k, int threads, std::vector<double>* gradient) {
+  std::vector<double> losses(threads, 0.0);
+  std::vector<std::vector<double>> gradients(
+      gradient ? threads : 0, std::vector<double>(NUM_PARAMS, 0.0));
+
+  parallelFor(data.positions.size(), threads,
+              [&](size_t begin, size_t end, int thread) {
+                double loss = 0;
+                for (size_t i = begin; i < end; i++) {
+                  const TunePosition& position = data.positions[i];
+                  double s = sigmoid(k, evaluate(data, position, params));
+                  double error = s - position.target;
+                  loss += error * error;
+
+                  if (!gradient) continue;
+
+                  double slope = 2.0 * error * s * (1.0 - s) * k;
+                  const TuneCoef* coef = &data.coefs[position.firstCoef];
+                  for (int c = 0; c < position.coefCount; c++, coef++) {
+                    gradients[thread][coef->index] += slope * coef->value;
+                  }
+                }
+                losses[thread] = loss;
+              });
+
+  double n = static_cast<double>(std::max<size_t>(1, data.positions.size()));
+  if (gradient) {
+    gradient->assign(NUM_PARAMS, 0.0);
+    for (const auto& threadGradient : gradients) {
+      for (int p = 0; p < NUM_PARAMS; p++) (*gradient)[p] += threadGradient[p] / n;
+    }
+  }
+
+  double loss = 0;
+  for (double threadLoss : losses) loss += threadLoss;
+  return loss / n;
+}
+
+// The scale between centipawns and win probability for the current
+// parameters, by golden section search on log(k)
+double fitK(const TuneData& data, const std::vector<double>& params,
+            int threads) {
+  const double ratio = (std::sqrt(5.0) - 1.0) / 2.0;
+  double low = std::log(1e-4), high = std::log(5e-2);
+
+  for (int i = 0; i < 40; i++) {
+    double a = high - ratio * (high - low);
+    double b = low + ratio * (high - low);
+    if (computeLoss(data, params, std::exp(a), threads, nullptr) <
+        computeLoss(data, params, std::exp(b), threads, nullptr)) {
+      high = b;
+    } else {
+      low = a;
+    }
+  }
+
+  return std::exp((low + high) / 2.0);
+}
+
+void tune(const TuneData& data, std::vector<double>& params, double k,
+          const TuneConfig& config) {
+  constexpr double BETA1 = 0.9, BETA2 = 0.999, EPSILON = 1e-8;
+
+  std::vector<double> m(NUM_PARAMS, 0.0), v(NUM_PARAMS, 0.0), gradient;
+
+  for (int epoch = 1; epoch <= config.epochs; epoch++) {
+    double loss = computeLoss(data, params, k, config.threads, &gradient);
+
+    double correction1 = 1.0 - std::pow(BETA1, epoch);
+    double correction2 = 1.0 - std::pow(BETA2, epoch);
+    for (int p = 0; p < NUM_PARAMS; p++) {
+      m[p] = BETA1 * m[p] + (1.0 - BETA1) * gradient[p];
+      v[p] = BETA2 * v[p] + (1.0 - BETA2) * gradient[p] * gradient[p];
+      params[p] -= config.learningRate * (m[p] / correction1) /
+                   (std::sqrt(v[p] / correction2) + EPSILON);
+    }
+
+    if (epoch % 50 == 0 || epoch == config.epochs) {
+      std::cout << "Epoch " << epoch << " loss " << std::setprecision(8)
+                << loss << std::endl;
+    }
+  }
+}
+
+// Eight values to a row like the piece-square tables
+void writeTable(std::ofstream& out, const std::vector<double>& params,
+                const char* comment, const char* name, int offset, int size) {
+  out << "// " << comment << "\n";
+  out << "constexpr int " << name << "[" << size << "] = {\n";
+  for (int row = 0; row < size / 8; row++) {
+    out << "   ";
+    for (int col = 0; col < 8; col++) {
+      int value = static_cast<int>(std::lround(params[offset + row * 8 + col]));
+      out << " " << std::setw(4) << value
+          << (row * 8 + col < size - 1 ? "," : "");
+    }
+    out << "\n";
+  }
+  out << "};\n";
+}
+
+bool writePieceMaps(const std::string& path, const std::vector<double>& params) {
+  std::ofstream out(path);
+  if (!out.is_open()) return false;
+
+  auto value = [&](int index) { return static_cast<int>(std::lround(params[index])); };
+
+  out << "#ifndef PIECE_VALUES_HPP\n#define PIECE_VALUES_HPP\n\n";
+  out << "// Evaluation parameters, pawnstar-tune writes this file. The\n"
+         "// piece-square tables are from whites side with the 8th rank "
+         "first.\n\n";
+
+  out << "// Material values\n";
+  const char* const materialNames[5] = {"PAWN_VALUE", "KNIGHT_VALUE",
+                                        "BISHOP_VALUE", "ROOK_VALUE",
+                                        "QUEEN_VALUE"};
+  for (int i = 0; i < 5; i++) {
+    out << "constexpr int " << materialNames[i] << " = "
+        << value(MATERIAL_OFFSET + i) << ";\n";
+  }
+
+  out << "\n// Imbalance, knights gain and rooks lose value with more own pawns\n";
+  out << "constexpr int BISHOP_PAIR_BONUS = " << value(BISHOP_PAIR_INDEX)
+      << ";\n";
+  out << "constexpr int KNIGHT_PAWN_ADJUST = " << value(KNIGHT_PAWN_INDEX)
+      << ";  // Per knight and pawn above five\n";
+  out << "constexpr int ROOK_PAWN_ADJUST = " << value(ROOK_PAWN_INDEX)
+      << ";  // Per rook and pawn above five\n";
+
+  out << "\n// Bonus per legal move\n";
+  out << "constexpr int MOBILITY_WEIGHT = " << value(MOBILITY_INDEX) << ";\n";
+  out << "\n// Endgame bonus for the opponent king standing in a corner or on "
+         "an edge\n";
+  out << "constexpr int KING_CORNER_BONUS = " << value(KING_CORNER_INDEX)
+      << ";\n";
+  out << "constexpr int KING_EDGE_BONUS = " << value(KING_EDGE_INDEX) << ";\n";
+
+  out << "\n// Pawn structure, per pawn\n";
+  out << "constexpr int DOUBLED_PAWN = " << value(DOUBLED_PAWN_INDEX) << ";\n";
+  out << "constexpr int ISOLATED_PAWN = " << value(ISOLATED_PAWN_INDEX)
+      << ";\n";
+  out << "constexpr int BACKWARD_PAWN = " << value(BACKWARD_PAWN_INDEX)
+      << ";\n";
+  out << "constexpr int CONNECTED_PAWN = " << value(CONNECTED_PAWN_INDEX)
+      << ";\n";
+  out << "constexpr int CANDIDATE_PAWN = " << value(CANDIDATE_PAWN_INDEX)
+      << ";\n";
+  out << "\n// Passed pawn bonus by rank from the pawn's side\n";
+  out << "constexpr int PASSED_PAWN_BONUS[8] = {";
+  for (int rank = 0; rank < 8; rank++) {
+    out << (rank > 0 ? ", " : "") << value(PASSED_PAWN_OFFSET + rank);
+  }
+  out << "};\n";
+
+  out << "\n// Pawns around the own king in the middle game, per pawn\n";
+  out << "constexpr int PAWN_SHIELD = " << value(PAWN_SHIELD_INDEX) << ";\n";
+  out << "constexpr int PAWN_STORM = " << value(PAWN_STORM_INDEX) << ";\n";
+
+  out << "\n";
+  writeTable(out, params,
+             "Middle game bonus for attacking the enemy king zone, by attack "
+             "units",
+             "KING_SAFETY_TABLE", KING_SAFETY_OFFSET, KING_SAFETY_UNITS);
+
+  for (int table = 0; table < PST_COUNT; table++) {
+    out << "\n";
+    writeTable(out, params, TABLE_COMMENTS[table], TABLE_NAMES[table],
+               PST_OFFSET + table * 64, 64);
+  }
+
+  out << "\n#endif\n";
+  return true;
+}
+
+// Checks the coefficients against the engine on the first positions, so a
+// change to the evaluation that is not mirrored here is noticed
+bool verifyCoefs(const TuneData& data, const std::vector<PbinRecord>& sample,
+                 const std::vector<double>& params) {
+  Engine engine;
+  size_t index = 0;
+  for (const auto& record : sample) {
+    Board board = record.toBoard();
+    if (!isTunable(board)) continue;
+    engine.setPosition(board.getFen());
+
+    const TunePosition& position = data.positions[index++];
+    int eval = static_cast<int>(std::lround(evaluate(data, position, params)));
+    if (board.sideToMove() == Color::BLACK) eval = -eval;
+
+    if (eval != engine.evaluate()) {
+      std::cerr << "Coefficients donot match the engine evaluation in "
+                << board.getFen() << ": " << eval << " vs "
+                << engine.evaluate() << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+void printUsage() {
+  std::cout << "Usage: pawnstar-tune [options] data.pbin...\n"
+            << "  --epochs N      Adam steps over all positions (default 1000)\n"
+            << "  --lr X          learning rate in centipawns (default 1.0)\n"
+            << "  --lambda X      weight of the game result against the\n"
+            << "                  search score (default 1.0)\n"
+            << "  --k X           sigmoid scale, fitted when missing\n"
+            << "  --threads N     threads (default all cores)\n"
+            << "  --output FILE   generated header (default piece-maps.hpp)\n";
+}
+
+bool parseArgs(int argc, char* argv[], TuneConfig& config) {
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+
+    if (arg == "--epochs" && hasValue) {
+      config.epochs = std::stoi(argv[++i]);
+    } else if (arg == "--lr" && hasValue) {
+      config.learningRate = std::stod(argv[++i]);
+    } else if (arg == "--lambda" && hasValue) {
+      config.lambda = std::stod(argv[++i]);
+    } else if (arg == "--k" && hasValue) {
+      config.k = std::stod(argv[++i]);
+    } else if (arg == "--threads" && hasValue) {
+      config.threads = std::max(1, std::stoi(argv[++i]));
+    } else if (arg == "--output" && hasValue) {
+      config.output = argv[++i];
+    } else if (arg.rfind("--", 0) == 0) {
+      return false;
+    } else {
+      config.inputs.push_back(arg);
+    }
+  }
+
+  return !config.inputs.empty();
+}
+
+int main(int argc, char* argv[]) {
+  TuneConfig config;
+
+  try {
+    if (!parseArgs(argc, argv, config)) {
+      printUsage();
+      return 1;
+    }
+  } catch (const std::exception&) {
+    printUsage();
+    return 1;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  auto elapsed = [&]() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start)
+        .count();
+  };
+
+  TuneData data = loadData(config);
+  if (data.positions.empty()) {
+    std::cerr << "No positions loaded" << std::endl;
+    return 1;
+  }
+
+  std::cout << "Loaded " << data.positions.size() << " positions, "
+            << data.coefs.size() << " coefficients in " << elapsed() << "s"
+            << std::endl;
+
+  std::vector<double> params = initialParams();
+
+  {
+    PbinReader reader(config.inputs.front());
+    const PbinRecord* batch = nullptr;
+    size_t count = reader.isOpen() ? reader.next(batch) : 0;
+    std::vector<PbinRecord> sample(batch, batch + std::min<size_t>(count, 1000));
+    if (!verifyCoefs(data, sample, params)) return 1;
+  }
+
+  double k = config.k > 0 ? config.k : fitK(data, params, config.threads);
+  std::cout << "K " << k << ", initial loss "
+            << computeLoss(data, params, k, config.threads, nullptr)
+            << std::endl;
+
+  tune(data, params, k, config);
+
+  if (!writePieceMaps(config.output, params)) {
+    std::cerr << "Failed to write " << config.output << std::endl;
+    return 1;
+  }
+
+  std::cout << "Wrote " << config.output << " after " << elapsed() << "s"
+            << std::endl;
+  return 0;
+}
@@ -0,0 +1,59 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "engine/bench.hpp"
+#include "engine/engine.hpp"
+
+/*
+ * Lazy evaluation bounds
+ *
+ * An evaluation that stops early is only valid as a bound, so for every
+ * window it has to be at or below alpha, at or above beta, or equal to the
+ * full evaluation.
+ */
+
+// Friend of Engine, evaluates with the eval cache bypassed
+struct EvalTest {
+  static int evaluate(Engine& engine, int alpha, int beta) {
+    const Board& board = engine.board;
+    engine.evalCache[board.hash() & (EVAL_CACHE_ENTRIES - 1)].key = 0;
+    return engine.evaluatePosition(board, 0, 0, alpha, beta);
+  }
+};
+
+int main() {
+  std::vector<std::string> positions = benchPositions();
+
+  // Scaled down endings, opposite colored bishops and pawnless
+  positions.push_back("2b1k3/8/8/8/8/8/PPPPPPPP/2B1K3 w - - 0 1");
+  positions.push_back("4k3/5b2/8/3P4/2P5/8/3B4/4K3 b - - 0 1");
+  positions.push_back("4k3/8/8/3n4/8/8/8/R3K3 w - - 0 1");
+
+  int failures = 0;
+  int windows = 0;
+  for (const auto& fen : positions) {
+    Engine engine;
+    engine.setPosition(fen);
+    int full = EvalTest::evaluate(engine, -MATE_SCORE, MATE_SCORE);
+
+    for (int alpha = -1000; alpha <= 1000; alpha += 5) {
+      for (int width : {1, 10, 50, 200, 400}) {
+        int beta = alpha + width;
+        int lazy = EvalTest::evaluate(engine, alpha, beta);
+        windows++;
+        if (lazy <= alpha || lazy >= beta || lazy == full) continue;
+
+        if (failures++ < 10) {
+          std::cerr << fen << ": window (" << alpha << ", " << beta
+                    << ") gave " << lazy << ", full evaluation " << full
+                    << std::endl;
+        }
+      }
+    }
+  }
+
+  std::cout << windows << " windows, " << failures << " failures"
+            << std::endl;
+  return failures == 0 ? 0 : 1;
+}
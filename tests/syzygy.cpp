@@ -0,0 +1,504 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "engine/bitbase.hpp"
+#include "engine/syzygy.hpp"
+
+/*
+ * Syzygy probing
+ *
+ * Writes KRvK and KPvK tables in the Syzygy format, with the values solved
+ * here (KRvK by retrograde distance to mate, KPvK from the KPK bitbase),
+ * and checks the probes of every legal position of both colorings against
+ * them. The tables are written with one fixed length code per value instead
+ * of the Huffman codes of the generator, the reader decodes both the same
+ * way. Every distinct position up to symmetry has to get its own index.
+ */
+
+namespace {
+
+constexpr int BLOCK_BITS = 10;  // 1024 byte blocks
+constexpr int SPAN_BITS = 10;   // A sparse index entry for 1024 values
+constexpr uint8_t WDL_MAGIC[4] = {0x71, 0xE8, 0x23, 0x5D};
+constexpr uint8_t DTZ_MAGIC[4] = {0xD7, 0x66, 0x0C, 0xA5};
+
+// Values of one side to move and leading pawn file, empty for the single
+// value placeholder
+struct Section {
+  uint8_t flags = 0;
+  std::vector<uint8_t> values;
+};
+
+void putLittle(std::vector<uint8_t>& out, uint64_t value, int bytes) {
+  for (int i = 0; i < bytes; i++) out.push_back((value >> (8 * i)) & 0xFF);
+}
+
+int codeBits(const Section& section) {
+  int bits = 1;
+  int highest = *std::max_element(section.values.begin(), section.values.end());
+  while ((1 << bits) <= highest) bits++;
+  return bits;
+}
+
+uint64_t perBlock(const Section& section) {
+  return (uint64_t(8) << BLOCK_BITS) / codeBits(section);
+}
+
+uint64_t blockCount(const Section& section) {
+  return (section.values.size() + perBlock(section) - 1) / perBlock(section);
+}
+
+// The table file: header, sizes and code of every section, (DTZ maps), the
+// sparse indexes, the block lengths, then the 64 byte aligned blocks
+void writeTable(const std::string& path, bool isDtz,
+                const std::vector<uint8_t>& header,
+                const std::vector<Section>& sections) {
+  std::vector<uint8_t> out(isDtz ? DTZ_MAGIC : WDL_MAGIC,
+                           (isDtz ? DTZ_MAGIC : WDL_MAGIC) + 4);
+  out.insert(out.end(), header.begin(), header.end());
+  if (out.size() & 1) out.push_back(0);
+
+  for (const auto& section : sections) {
+    if (section.values.empty()) {
+      out.push_back(section.flags | 128);
+      out.push_back(0);
+      continue;
+    }
+
+    // Every symbol is a leaf holding its own value
+    int bits = codeBits(section);
+    out.push_back(section.flags);
+    out.push_back(BLOCK_BITS);
+    out.push_back(SPAN_BITS);
+    out.push_back(1);
+    putLittle(out, blockCount(section), 4);
+    out.push_back(static_cast<uint8_t>(bits));
+    out.push_back(static_cast<uint8_t>(bits));
+    putLittle(out, 0, 2);
+    putLittle(out, 1 << bits, 2);
+    for (int sym = 0; sym < (1 << bits); sym++) {
+      out.push_back(sym & 0xFF);
+      out.push_back(((sym >> 8) & 0xF) | 0xF0);
+      out.push_back(0xFF);
+    }
+  }
+  if (isDtz && (out.size() & 1)) out.push_back(0);
+
+  for (const auto& section : sections) {
+    if (section.values.empty()) continue;
+
+    uint64_t span = uint64_t(1) << SPAN_BITS;
+    uint64_t size = section.values.size();
+    for (uint64_t k = 0; k < (size + span - 1) / span; k++) {
+      uint64_t middle = k * span + span / 2;
+      uint64_t block =
+          std::min(middle / perBlock(section), blockCount(section) - 1);
+      putLittle(out, block, 4);
+      putLittle(out, middle - block * perBlock(section), 2);
+    }
+  }
+
+  for (const auto& section : sections) {
+    if (section.values.empty()) continue;
+
+    uint64_t blocks = blockCount(section);
+    for (uint64_t block = 0; block < blocks; block++) {
+      uint64_t end = std::min<uint64_t>((block + 1) * perBlock(section),
+                                        section.values.size());
+      putLittle(out, end - block * perBlock(section) - 1, 2);
+    }
+    putLittle(out, perBlock(section) - 1, 2);
+  }
+
+  for (const auto& section : sections) {
+    if (section.values.empty()) continue;
+
+    while (out.size() & 63) out.push_back(0);
+
+    int bits = codeBits(section);
+    for (uint64_t block = 0; block < blockCount(section); block++) {
+      std::vector<uint8_t> bytes(size_t(1) << BLOCK_BITS);
+      uint64_t first = block * perBlock(section);
+      uint64_t end = std::min<uint64_t>(first + perBlock(section),
+                                        section.values.size());
+      for (uint64_t i = first; i < end; i++) {
+        for (int b = 0; b < bits; b++) {
+          uint64_t bit = (i - first) * bits + b;
+          if ((section.values[i] >> (bits - 1 - b)) & 1) {
+            bytes[bit / 8] |= 0x80 >> (bit % 8);
+          }
+        }
+      }
+      out.insert(out.end(), bytes.begin(), bytes.end());
+    }
+  }
+
+  out.resize(out.size() + 64);
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file.write(reinterpret_cast<const char*>(out.data()), out.size());
+}
+
+// A piece on a square, uppercase for white
+struct Placed {
+  char piece;
+  int sq;
+};
+
+std::string fenOf(const std::vector<Placed>& pieces, bool blackToMove) {
+  char grid[64];
+  std::fill(grid, grid + 64, ' ');
+  for (const auto& placed : pieces) grid[placed.sq] = placed.piece;
+
+  std::string fen;
+  for (int rank = 7; rank >= 0; rank--) {
+    int empty = 0;
+    for (int file = 0; file < 8; file++) {
+      char c = grid[rank * 8 + file];
+      if (c == ' ') {
+        empty++;
+        continue;
+      }
+      if (empty) fen += std::to_string(empty);
+      empty = 0;
+      fen += c;
+    }
+    if (empty) fen += std::to_string(empty);
+    if (rank) fen += '/';
+  }
+  return fen + (blackToMove ? " b" : " w") + " - - 0 1";
+}
+
+// The same position with the colors swapped
+std::string mirroredFen(const std::vector<Placed>& pieces, bool blackToMove) {
+  std::vector<Placed> mirrored;
+  for (const auto& placed : pieces) {
+    char c = placed.piece;
+    mirrored.push_back({static_cast<char>(std::isupper(c) ? std::tolower(c)
+                                                          : std::toupper(c)),
+                        placed.sq ^ 56});
+  }
+  return fenOf(mirrored, !blackToMove);
+}
+
+bool isLegal(const Board& board) {
+  Color stm = board.sideToMove();
+  return !board.isAttacked(board.kingSq(~stm), stm);
+}
+
+// Smallest packing of the squares over the symmetries of the board, the
+// eight of a pawnless ending or the file mirror with pawns
+int symmetryClass(const std::vector<int>& squares, bool pawns) {
+  int best = -1;
+  for (int t = 0; t < (pawns ? 2 : 8); t++) {
+    int packed = 0;
+    for (int sq : squares) {
+      if (t & 1) sq ^= 7;
+      if (t & 2) sq ^= 56;
+      if (t & 4) sq = ((sq >> 3) | (sq << 3)) & 63;
+      packed = packed * 64 + sq;
+    }
+    if (best < 0 || packed < best) best = packed;
+  }
+  return best;
+}
+
+int krkIndex(bool blackToMove, int wk, int wr, int bk) {
+  return ((blackToMove * 64 + wk) * 64 + wr) * 64 + bk;
+}
+
+// Plies to mate of every KRvK position with the rook white, -1 for a draw
+// and -2 for an illegal position
+std::vector<int> solveKrk() {
+  std::vector<int> dtm(2 * 64 * 64 * 64, -2);
+  std::vector<std::vector<int>> next(dtm.size());
+  std::vector<bool> escapes(dtm.size());
+
+  for (int stm = 0; stm < 2; stm++) {
+    for (int wk = 0; wk < 64; wk++) {
+      for (int wr = 0; wr < 64; wr++) {
+        for (int bk = 0; bk < 64; bk++) {
+          if (wk == wr || wk == bk || wr == bk) continue;
+
+          Board board(fenOf({{'K', wk}, {'R', wr}, {'k', bk}}, stm));
+          if (!isLegal(board)) continue;
+
+          int pos = krkIndex(stm, wk, wr, bk);
+          dtm[pos] = -1;
+
+          Movelist moves;
+          movegen::legalmoves(moves, board);
+          if (moves.empty() && board.inCheck()) dtm[pos] = 0;
+
+          for (const Move move : moves) {
+            if (board.isCapture(move)) {
+              escapes[pos] = true;
+              continue;
+            }
+            board.makeMove(move);
+            next[pos].push_back(krkIndex(
+                stm == 0, board.kingSq(Color::WHITE).index(),
+                board.pieces(PieceType::ROOK, Color::WHITE).lsb(),
+                board.kingSq(Color::BLACK).index()));
+            board.unmakeMove(move);
+          }
+        }
+      }
+    }
+  }
+
+  // White resolves on odd plies, black on even ones
+  int idle = 0;
+  for (int ply = 1; idle < 2; ply++) {
+    bool changed = false;
+    bool blackToMove = ply % 2 == 0;
+
+    for (size_t pos = 0; pos < dtm.size(); pos++) {
+      if (dtm[pos] != -1 || (pos >= 64 * 64 * 64) != blackToMove) continue;
+      if (next[pos].empty()) continue;
+
+      bool resolved;
+      if (blackToMove) {
+        resolved = !escapes[pos] &&
+                   std::all_of(next[pos].begin(), next[pos].end(),
+                               [&](int child) { return dtm[child] >= 0; });
+      } else {
+        resolved =
+            std::any_of(next[pos].begin(), next[pos].end(),
+                        [&](int child) { return dtm[child] == ply - 1; });
+      }
+
+      if (resolved) {
+        dtm[pos] = ply;
+        changed = true;
+      }
+    }
+
+    idle = changed ? 0 : idle + 1;
+  }
+
+  return dtm;
+}
+
+}  // namespace
+
+// Friend of Syzygy, reaches the tables and the index encoding
+struct SyzygyTest {
+  std::string directory;
+  Syzygy syzygy;
+  int failures = 0;
+
+  void fail(const std::string& fen, const std::string& what) {
+    if (failures++ < 10) std::cerr << fen << ": " << what << std::endl;
+  }
+
+  const Syzygy::Table& table(const std::string& fen) {
+    return *syzygy.findTable(Board(fen));
+  }
+
+  // Sections of the table sized from the placeholder, in file order
+  static std::vector<Section> sections(const Syzygy::Table& t, bool isDtz,
+                                       uint8_t flags) {
+    std::vector<Section> result;
+    for (uint64_t size : Syzygy::sizes(t, isDtz)) {
+      result.push_back({flags, std::vector<uint8_t>(size)});
+    }
+    return result;
+  }
+
+  // Stores the value of the position, and checks that no other position
+  // shares its index
+  void store(const Syzygy::Table& t, const Board& board, bool isDtz,
+             bool pawns, std::vector<Section>& values,
+             std::vector<std::vector<int>>& classes, int symmetry, int value) {
+    int stm, tbFile;
+    uint64_t idx = Syzygy::encode(t, board, isDtz, stm, tbFile);
+    if (isDtz && stm != 0) return;
+
+    size_t sides = values.size() / (pawns ? 4 : 1);
+    size_t section = tbFile * sides + stm;
+    if (idx >= values[section].values.size()) {
+      fail(board.getFen(), "index out of the table");
+      return;
+    }
+
+    classes.resize(values.size());
+    auto& known = classes[section];
+    if (known.empty()) known.assign(values[section].values.size(), -1);
+    if (known[idx] >= 0 && known[idx] != symmetry) {
+      fail(board.getFen(), "index shared with another position");
+    }
+    known[idx] = symmetry;
+    values[section].values[idx] = static_cast<uint8_t>(value);
+  }
+
+  void testKrk() {
+    std::vector<int> dtm = solveKrk();
+
+    writeTable(directory + "/KRvK.rtbw", false, {1, 0, 0x66, 0x44, 0xEE},
+               {{}, {}});
+    writeTable(directory + "/KRvK.rtbz", true, {1, 0, 0x06, 0x04, 0x0E}, {{}});
+    syzygy.load(directory);
+
+    const Syzygy::Table& t = table("8/8/8/8/8/8/8/KRk5 w - - 0 1");
+    std::vector<Section> wdl = sections(t, false, 0);
+    // Values are plies, stored minus one, white to move
+    std::vector<Section> dtz = sections(t, true, 4 | 8);
+    std::vector<std::vector<int>> wdlClasses, dtzClasses;
+
+    for (int pos = 0; pos < static_cast<int>(dtm.size()); pos++) {
+      if (dtm[pos] == -2) continue;
+
+      bool blackToMove = pos >= 64 * 64 * 64;
+      int wk = (pos >> 12) & 63, wr = (pos >> 6) & 63, bk = pos & 63;
+      Board board(fenOf({{'K', wk}, {'R', wr}, {'k', bk}}, blackToMove));
+      int symmetry = symmetryClass({wk, wr, bk}, false);
+
+      int result = dtm[pos] < 0 ? 0 : blackToMove ? -2 : 2;
+      store(t, board, false, false, wdl, wdlClasses, symmetry, result + 2);
+      if (!blackToMove && dtm[pos] > 0) {
+        store(t, board, true, false, dtz, dtzClasses, symmetry, dtm[pos] - 1);
+      }
+    }
+
+    syzygy.clear();
+    writeTable(directory + "/KRvK.rtbw", false, {1, 0, 0x66, 0x44, 0xEE}, wdl);
+    writeTable(directory + "/KRvK.rtbz", true, {1, 0, 0x06, 0x04, 0x0E}, dtz);
+    if (syzygy.load(directory) != 1) fail("KRvK", "tables not loaded");
+
+    int probes = 0;
+    for (int pos = 0; pos < static_cast<int>(dtm.size()); pos++) {
+      if (dtm[pos] == -2) continue;
+
+      bool blackToMove = pos >= 64 * 64 * 64;
+      std::vector<Placed> pieces = {
+          {'K', (pos >> 12) & 63}, {'R', (pos >> 6) & 63}, {'k', pos & 63}};
+
+      SyzygyWdl expectedWdl = dtm[pos] < 0   ? SyzygyWdl::DRAW
+                              : blackToMove ? SyzygyWdl::LOSS
+                                             : SyzygyWdl::WIN;
+      int expectedDtz = dtm[pos] < 0 ? 0
+                        : !blackToMove ? dtm[pos]
+                        : dtm[pos] == 0 ? -1
+                                        : -dtm[pos];
+
+      for (const auto& fen :
+           {fenOf(pieces, blackToMove), mirroredFen(pieces, blackToMove)}) {
+        Board board(fen);
+        SyzygyWdl wdlResult;
+        int dtzResult;
+        probes++;
+
+        if (!syzygy.probeWdl(board, wdlResult) || wdlResult != expectedWdl) {
+          fail(fen, "wrong WDL " + std::to_string(static_cast<int>(wdlResult)));
+        }
+        if (!syzygy.probeDtz(board, dtzResult) || dtzResult != expectedDtz) {
+          fail(fen, "DTZ " + std::to_string(dtzResult) + " instead of " +
+                        std::to_string(expectedDtz));
+        }
+        if (board.getFen() != fen) fail(fen, "board changed by the probe");
+
+        // The best ranked root move gets one ply closer to the mate
+        if (!blackToMove && dtm[pos] > 1 && pos % 97 == 0) {
+          Movelist moves;
+          movegen::legalmoves(moves, board);
+          std::vector<int> ranks(moves.size());
+          if (!syzygy.rankRootMoves(board, &moves[0], moves.size(),
+                                    ranks.data())) {
+            fail(fen, "root moves not ranked");
+            continue;
+          }
+
+          size_t best =
+              std::max_element(ranks.begin(), ranks.end()) - ranks.begin();
+          board.makeMove(moves[best]);
+          int childDtz = 0;
+          syzygy.probeDtz(board, childDtz);
+          // Mated is -1 like a mate in one
+          int expected = dtm[pos] == 1 ? -1 : -(dtm[pos] - 1);
+          if (childDtz != expected) {
+            fail(fen, "best root move does not make progress");
+          }
+        }
+      }
+    }
+
+    std::cout << "KRvK: " << probes << " positions" << std::endl;
+  }
+
+  void testKpk() {
+    writeTable(directory + "/KPvK.rtbw", false,
+               {1 | 2, 0, 0x11, 0x66, 0xEE, 0, 0x11, 0x66, 0xEE, 0, 0x11, 0x66,
+                0xEE, 0, 0x11, 0x66, 0xEE},
+               std::vector<Section>(8));
+    syzygy.load(directory);
+
+    const Syzygy::Table& t = table("8/8/8/8/8/8/P7/K1k5 w - - 0 1");
+    std::vector<Section> wdl = sections(t, false, 0);
+    std::vector<std::vector<int>> classes;
+    std::vector<std::tuple<std::vector<Placed>, bool, int>> positions;
+
+    for (int blackToMove = 0; blackToMove < 2; blackToMove++) {
+      for (int wp = 8; wp < 56; wp++) {
+        for (int wk = 0; wk < 64; wk++) {
+          for (int bk = 0; bk < 64; bk++) {
+            if (wp == wk || wp == bk || wk == bk) continue;
+
+            std::vector<Placed> pieces = {{'P', wp}, {'K', wk}, {'k', bk}};
+            Board board(fenOf(pieces, blackToMove));
+            if (!isLegal(board)) continue;
+
+            bool wins = probeKpk(board, Color::WHITE);
+            int result = !wins ? 0 : blackToMove ? -2 : 2;
+            store(t, board, false, true, wdl, classes,
+                  symmetryClass({wp, wk, bk}, true), result + 2);
+            positions.emplace_back(pieces, blackToMove, result);
+          }
+        }
+      }
+    }
+
+    syzygy.clear();
+    writeTable(directory + "/KPvK.rtbw", false,
+               {1 | 2, 0, 0x11, 0x66, 0xEE, 0, 0x11, 0x66, 0xEE, 0, 0x11, 0x66,
+                0xEE, 0, 0x11, 0x66, 0xEE},
+               wdl);
+    if (syzygy.load(directory) != 2) fail("KPvK", "tables not loaded");
+
+    for (const auto& [pieces, blackToMove, result] : positions) {
+      for (const auto& fen :
+           {fenOf(pieces, blackToMove), mirroredFen(pieces, blackToMove)}) {
+        Board board(fen);
+        SyzygyWdl wdlResult;
+        if (!syzygy.probeWdl(board, wdlResult) ||
+            static_cast<int>(wdlResult) != result) {
+          fail(fen, "wrong WDL " + std::to_string(static_cast<int>(wdlResult)));
+        }
+      }
+    }
+
+    std::cout << "KPvK: " << 2 * positions.size() << " positions" << std::endl;
+  }
+};
+
+int main() {
+  SyzygyTest test;
+  auto directory =
+      std::filesystem::temp_directory_path() / "pawnstar-syzygy-test";
+  test.directory = directory.string();
+  std::filesystem::remove_all(test.directory);
+  std::filesystem::create_directories(test.directory);
+
+  test.testKrk();
+  test.testKpk();
+
+  test.syzygy.clear();
+  std::filesystem::remove_all(test.directory);
+
+  std::cout << test.failures << " failures" << std::endl;
+  return test.failures == 0 ? 0 : 1;
+}